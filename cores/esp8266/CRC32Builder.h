@@ -0,0 +1,38 @@
+/*
+  CRC32Builder.h - incremental crc32()
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef __ESP8266_CRC32_BUILDER__
+#define __ESP8266_CRC32_BUILDER__
+
+#include <string.h>
+#include <WString.h>
+#include "coredecls.h"
+
+// the data can be added in any number of parts, of any size: the result is
+// the crc32() of all of it
+class CRC32Builder {
+  private:
+    uint32_t _crc = 0xffffffff;
+  public:
+    void begin(uint32_t crc = 0xffffffff){ _crc = crc; }
+    void add(const void * data, size_t len){ _crc = crc32(data, len, _crc); }
+    void add(const char * data){ add(data, strlen(data)); }
+    void add(const String& data){ add(data.c_str(), data.length()); }
+    uint32_t getCRC(void) const { return _crc; }
+};
+
+#endif
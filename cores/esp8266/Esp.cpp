@@ -24,6 +24,7 @@
 #include <memory>
 #include "interrupts.h"
 #include "MD5Builder.h"
+#include "CRC32Builder.h"
 #include "umm_malloc/umm_malloc.h"
 #include "cont.h"
 #include "flash_hal.h"
@@ -470,13 +471,15 @@ bool EspClass::checkFlashCRC() {
 
     uint32_t firstPart = (uintptr_t)&__crc_len - 0x40200000; // How many bytes to check before the 1st CRC val
 
+    CRC32Builder crc;
+    crc.begin();
     // Start the checksum
-    uint32_t crc = crc32((const void*)0x40200000, firstPart, 0xffffffff);
+    crc.add((const void*)0x40200000, firstPart);
     // Pretend the 2 words of crc/len are zero to be idempotent
-    crc = crc32(z, 8, crc);
+    crc.add(z, 8);
     // Finish the CRC calculation over the rest of flash
-    crc = crc32((const void*)(0x40200000 + firstPart + 8), __crc_len - (firstPart + 8), crc);
-    return crc == __crc_val;
+    crc.add((const void*)(0x40200000 + firstPart + 8), __crc_len - (firstPart + 8));
+    return crc.getCRC() == __crc_val;
 }
 
 
@@ -21,14 +21,62 @@
 #include "FS.h"
 #include "FSImpl.h"
 
+#ifndef FS_PEEK_WINDOW_SIZE
+#define FS_PEEK_WINDOW_SIZE 512
+#endif
+
 using namespace fs;
 
 static bool sflags(const char* mode, OpenMode& om, AccessMode& am);
 
+size_t FileImpl::peekAvailable() {
+    if (peekPending())
+        return peekPending();
+
+    peekInvalidate();
+    if (!_peekBuf) {
+        _peekBuf.reset(new (std::nothrow) char[FS_PEEK_WINDOW_SIZE]);
+        if (!_peekBuf)
+            return 0;
+    }
+    int len = read((uint8_t*)_peekBuf.get(), FS_PEEK_WINDOW_SIZE);
+    if (len > 0)
+        _peekLen = len;
+    return peekPending();
+}
+
+size_t FileImpl::peekRead(uint8_t* buf, size_t size) {
+    size_t len = std::min(size, peekPending());
+    if (len) {
+        memcpy(buf, peekBuffer(), len);
+        _peekOff += len;
+    }
+    return len;
+}
+
+bool FileImpl::peekSeek(size_t pos) {
+    size_t end = position();
+    if (!_peekLen || pos > end || pos < end - _peekLen) {
+        peekInvalidate();
+        return false;
+    }
+    _peekOff = _peekLen - (end - pos);
+    return true;
+}
+
+bool FileImpl::peekDrop() {
+    size_t pending = peekPending();
+    peekInvalidate();
+    return !pending || seek(position() - pending, SeekSet);
+}
+
 size_t File::write(uint8_t c) {
     if (!_p)
         return 0;
 
+    _p->peekDrop();
+    if (_baseFS)
+        _baseFS->_modified();
     return _p->write(&c, 1);
 }
 
@@ -36,6 +84,9 @@ size_t File::write(const uint8_t *buf, size_t size) {
     if (!_p)
         return 0;
 
+    _p->peekDrop();
+    if (_baseFS)
+        _baseFS->_modified();
     return _p->write(buf, size);
 }
 
@@ -43,7 +94,7 @@ int File::available() {
     if (!_p)
         return false;
 
-    return _p->size() - _p->position();
+    return _p->size() - position();
 }
 
 int File::availableForWrite() {
@@ -59,7 +110,7 @@ int File::read() {
         return -1;
 
     uint8_t result;
-    if (_p->read(&result, 1) != 1) {
+    if (read(&result, 1) != 1) {
         return -1;
     }
 
@@ -70,13 +121,23 @@ int File::read(uint8_t* buf, size_t size) {
     if (!_p)
         return 0;
 
-    return _p->read(buf, size);
+    size_t done = _p->peekRead(buf, size);
+    if (done == size)
+        return done;
+
+    int len = _p->read(buf + done, size - done);
+    if (len <= 0)
+        return done ? (int)done : len;
+    return done + len;
 }
 
 int File::peek() {
     if (!_p)
         return -1;
 
+    if (_p->peekAvailable())
+        return (uint8_t)*_p->peekBuffer();
+
     size_t curPos = _p->position();
     int result = read();
     seek(curPos, SeekSet);
@@ -94,6 +155,12 @@ bool File::seek(uint32_t pos, SeekMode mode) {
     if (!_p)
         return false;
 
+    if (mode == SeekCur) {
+        pos += position();
+        mode = SeekSet;
+    }
+    if (mode == SeekSet && _p->peekSeek(pos))
+        return true;
     return _p->seek(pos, mode);
 }
 
@@ -101,7 +168,7 @@ size_t File::position() const {
     if (!_p)
         return 0;
 
-    return _p->position();
+    return _p->position() - _p->peekPending();
 }
 
 size_t File::size() const {
@@ -126,6 +193,9 @@ bool File::truncate(uint32_t size) {
     if (!_p)
         return false;
 
+    _p->peekDrop();
+    if (_baseFS)
+        _baseFS->_modified();
     return _p->truncate(size);
 }
 
@@ -173,6 +243,31 @@ File File::openNextFile() {
     return _fakeDir->openFile("r");
 }
 
+bool File::hasPeekBufferAPI() const {
+    return !!_p;
+}
+
+size_t File::peekAvailable() {
+    if (!_p)
+        return 0;
+
+    return _p->peekAvailable();
+}
+
+const char* File::peekBuffer() {
+    if (!_p || !_p->peekAvailable())
+        return nullptr;
+
+    return _p->peekBuffer();
+}
+
+void File::peekConsume(size_t consume) {
+    if (!_p)
+        return;
+
+    _p->peekConsume(consume);
+}
+
 String File::readString()
 {
     String ret;
@@ -221,6 +316,9 @@ File Dir::openFile(const char* mode) {
         return File();
     }
 
+    if ((am & AM_WRITE) && _baseFS) {
+        _baseFS->_modified();
+    }
     File f(_impl->openFile(om, am), _baseFS);
     f.setTimeCallback(_timeCallback);
     return f;
@@ -335,6 +433,7 @@ bool FS::format() {
     if (!_impl) {
         return false;
     }
+    _impl->modified();
     return _impl->format();
 }
 
@@ -367,6 +466,9 @@ File FS::open(const char* path, const char* mode) {
         DEBUGV("FS::open: invalid mode `%s`\r\n", mode);
         return File();
     }
+    if (am & AM_WRITE) {
+        _impl->modified();
+    }
     File f(_impl->open(path, om, am), this);
     f.setTimeCallback(_timeCallback);
     return f;
@@ -401,6 +503,7 @@ bool FS::remove(const char* path) {
     if (!_impl) {
         return false;
     }
+    _impl->modified();
     return _impl->remove(path);
 }
 
@@ -412,6 +515,7 @@ bool FS::rmdir(const char* path) {
     if (!_impl) {
         return false;
     }
+    _impl->modified();
     return _impl->rmdir(path);
 }
 
@@ -423,6 +527,7 @@ bool FS::mkdir(const char* path) {
     if (!_impl) {
         return false;
     }
+    _impl->modified();
     return _impl->mkdir(path);
 }
 
@@ -434,6 +539,7 @@ bool FS::rename(const char* pathFrom, const char* pathTo) {
     if (!_impl) {
         return false;
     }
+    _impl->modified();
     return _impl->rename(pathFrom, pathTo);
 }
 
@@ -448,6 +554,19 @@ time_t FS::getCreationTime() {
     return _impl->getCreationTime();
 }
 
+void FS::_modified() {
+    if (_impl) {
+        _impl->modified();
+    }
+}
+
+uint32_t FS::generation() const {
+    if (!_impl) {
+        return 0;
+    }
+    return _impl->generation();
+}
+
 void FS::setTimeCallback(time_t (*cb)(void)) {
     if (!_impl)
         return;
@@ -75,6 +75,16 @@ public:
     size_t position() const;
     size_t size() const;
     virtual ssize_t streamRemaining() override { return (ssize_t)size() - (ssize_t)position(); }
+    // all data are already available, there is nothing to wait for
+    virtual bool inputCanTimeout() override { return false; }
+
+    // peek buffer API, backed by a read-ahead window in FileImpl: file
+    // data are copied once into it, as read() would, not lent by the driver
+    virtual bool hasPeekBufferAPI() const override;
+    virtual size_t peekAvailable() override;
+    virtual const char* peekBuffer() override;
+    virtual void peekConsume(size_t consume) override;
+
     void close();
     operator bool() const;
     const char* name() const;
@@ -241,10 +251,16 @@ public:
 
     void setTimeCallback(time_t (*cb)(void));
 
+    // Changes each time a file or directory is modified
+    uint32_t generation() const;
+
+    friend class File; // notify modifications
+    friend class Dir;
     friend class ::SDClass; // More of a frenemy, but SD needs internal implementation to get private FAT bits
 protected:
     FSImplPtr _impl;
     FSImplPtr getImpl() { return _impl; }
+    void _modified();
     time_t (*_timeCallback)(void) = nullptr;
     static time_t _defaultTimeCB(void) { return time(NULL); }
 };
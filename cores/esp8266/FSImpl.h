@@ -22,6 +22,8 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <algorithm>
+#include <memory>
 #include <FS.h>
 
 namespace fs {
@@ -55,8 +57,28 @@ public:
     // Same for creation time.
     virtual time_t getCreationTime() { return 0; } // Default is to not support timestamps
 
+    // Read-ahead window backing File's peek buffer API (see Stream.h).
+    // It is filled with read() and never seeks back: the position of the
+    // implementation is ahead of File's one by peekPending() bytes.
+    size_t peekAvailable(); // fills the window when it is empty
+    const char* peekBuffer() const { return _peekBuf.get() + _peekOff; }
+    void peekConsume(size_t consume) { _peekOff += std::min(consume, peekPending()); }
+    size_t peekPending() const { return _peekLen - _peekOff; }
+    // copies and consumes pending bytes
+    size_t peekRead(uint8_t* buf, size_t size);
+    // moves inside the window, false when pos is out of it
+    bool peekSeek(size_t pos);
+    // forgets the window, the implementation position is left as is
+    void peekInvalidate() { _peekLen = _peekOff = 0; }
+    // forgets the window, moving the implementation back to File's position
+    bool peekDrop();
+
 protected:
     time_t (*_timeCallback)(void) = nullptr;
+
+    std::unique_ptr<char[]> _peekBuf; // allocated on first use
+    size_t _peekLen = 0;
+    size_t _peekOff = 0;
 };
 
 enum OpenMode {
@@ -122,8 +144,14 @@ public:
     // returns the present time as reported by time(null)
     virtual void setTimeCallback(time_t (*cb)(void)) { _timeCallback = cb; }
 
+    // Modification counter, incremented by FS and File on every change,
+    // so that caches built over file contents can be invalidated
+    uint32_t generation() const { return _generation; }
+    void modified() { _generation++; }
+
 protected:
     time_t (*_timeCallback)(void) = nullptr;
+    uint32_t _generation = 0;
 };
 
 } // namespace fs
@@ -4,7 +4,6 @@
 
 // TODO:
 // remove all Serial.print
-// unchain pbufs
 
 #include <netif/ethernet.h>
 #include <lwip/init.h>
@@ -18,6 +17,7 @@
 
 #include "SPI.h"
 #include "Schedule.h"
+#include "coredecls.h"
 #include "LwipIntf.h"
 #include "wl_definitions.h"
 
@@ -36,9 +36,13 @@ public:
         _mtu(DEFAULT_MTU),
         _intrPin(intr),
         _started(false),
-        _default(false)
+        _default(false),
+        _rxBudget(rxBudgetMin),
+        _rxPending(false),
+        _rxInterrupt(false)
     {
         memset(&_netif, 0, sizeof(_netif));
+        memset(&_rxStats, 0, sizeof(_rxStats));
     }
 
     boolean config(const IPAddress& local_ip, const IPAddress& arg1, const IPAddress& arg2, const IPAddress& arg3 = IPADDR_NONE, const IPAddress& dns2 = IPADDR_NONE);
@@ -75,6 +79,20 @@ public:
 
     wl_status_t status();
 
+    struct RxStats
+    {
+        uint32_t frames;     // frames given to lwIP
+        uint32_t drops;      // frames dropped (no buffer, refused by lwIP)
+        uint32_t interrupts; // interrupts received on intr pin
+        uint32_t pollHits;   // polls finding frames (in interrupt mode: missed interrupts)
+        uint32_t pollMisses; // polls finding nothing
+    };
+
+    const RxStats& rxStats() const
+    {
+        return _rxStats;
+    }
+
 protected:
 
     err_t netif_init();
@@ -87,6 +105,19 @@ protected:
     // called on a regular basis or on interrupt
     err_t handlePackets();
 
+    void service();
+    void poll();
+    static void interrupt_s(void* arg);
+
+    // number of frames processed per handlePackets() call,
+    // adapted between these bounds to the incoming load
+    static constexpr uint8_t rxBudgetMin = 4;
+    static constexpr uint8_t rxBudgetMax = 32;
+
+    // polling interval, or fallback polling interval when intr pin is used
+    static constexpr uint32_t pollIntervalUs = 100;
+    static constexpr uint32_t intrPollIntervalUs = 1000;
+
     // members
 
     netif       _netif;
@@ -96,6 +127,10 @@ protected:
     uint8_t     _macAddress[6];
     bool        _started;
     bool        _default;
+    uint8_t     _rxBudget;
+    bool        _rxPending;
+    volatile bool _rxInterrupt;
+    RxStats     _rxStats;
 
 };
 
@@ -211,7 +246,11 @@ boolean LwipIntfDev<RawDev>::begin(const uint8_t* macAddress, const uint16_t mtu
     {
         if (RawDev::interruptIsPossible())
         {
-            //attachInterrupt(_intrPin, [&]() { this->handlePackets(); }, FALLING);
+            RawDev::enableRxInterrupt();
+            pinMode(_intrPin, INPUT);
+            // intr pin may already be asserted
+            _rxInterrupt = true;
+            attachInterruptArg(_intrPin, interrupt_s, this, FALLING);
         }
         else
         {
@@ -220,12 +259,26 @@ boolean LwipIntfDev<RawDev>::begin(const uint8_t* macAddress, const uint16_t mtu
         }
     }
 
-    if (_intrPin < 0 && !schedule_recurrent_function_us([&]()
+    // with interrupts, the alarm gets the device serviced from the next
+    // yield() or loop() and polling is slower, it only catches missed ones
+    std::function<bool(void)> alarm;
+    if (_intrPin >= 0)
+    {
+        alarm = [this]()
+        {
+            return _rxInterrupt;
+        };
+    }
+    if (!schedule_recurrent_function_us([&]()
 {
-    this->handlePackets();
+    this->service();
         return true;
-    }, 100))
+    }, _intrPin < 0 ? pollIntervalUs : intrPollIntervalUs, alarm))
     {
+        if (_intrPin >= 0)
+        {
+            detachInterrupt(_intrPin);
+        }
         netif_remove(&_netif);
         return false;
     }
@@ -321,68 +374,134 @@ void LwipIntfDev<RawDev>::netif_status_callback()
 template <class RawDev>
 err_t LwipIntfDev<RawDev>::handlePackets()
 {
-    int pkt = 0;
+    uint8_t pkt = 0;
     while (1)
     {
-        if (++pkt == 10)
-            // prevent starvation
+        if (pkt == _rxBudget)
         {
+            // prevent starvation,
+            // frames are still pending: allow more of them next time
+            if (_rxBudget < rxBudgetMax)
+            {
+                _rxBudget *= 2;
+            }
+            _rxPending = true;
             return ERR_OK;
         }
 
         uint16_t tot_len = RawDev::readFrameSize();
         if (!tot_len)
         {
+            _rxPending = false;
+            // device is drained: shrink budget when it was largely unused
+            if (pkt < _rxBudget / 2 && _rxBudget > rxBudgetMin)
+            {
+                _rxBudget /= 2;
+            }
             return ERR_OK;
         }
+        pkt++;
 
         // from doc: use PBUF_RAM for TX, PBUF_POOL from RX
-        // however:
-        // PBUF_POOL can return chained pbuf (not in one piece)
-        // and WiznetDriver does not have the proper API to deal with that
-        // so in the meantime, we use PBUF_RAM instead which is currently
-        // guarantying to deliver a continuous chunk of memory.
-        // TODO: tweak the wiznet driver to allow copying partial chunk
-        //       of received data and use PBUF_POOL.
-        pbuf* pbuf = pbuf_alloc(PBUF_RAW, tot_len, PBUF_RAM);
-        if (!pbuf || pbuf->len < tot_len)
+        // PBUF_POOL buffers have a fixed size (they are still malloc'd with
+        // MEMP_MEM_MALLOC), they are chained when the frame is larger and
+        // it is then read in as many chunks
+        pbuf* pbuf = pbuf_alloc(PBUF_RAW, tot_len, PBUF_POOL);
+        if (!pbuf)
         {
-            if (pbuf)
-            {
-                pbuf_free(pbuf);
-            }
             RawDev::discardFrame(tot_len);
+            _rxStats.drops++;
+            // lwIP is short of buffers, let it process what it already has
+            _rxBudget = rxBudgetMin;
+            _rxPending = true;
             return ERR_BUF;
         }
 
-        uint16_t len = RawDev::readFrameData((uint8_t*)pbuf->payload, tot_len);
-        if (len != tot_len)
+        for (struct pbuf* q = pbuf; q; q = q->next)
         {
-            // tot_len is given by readFrameSize()
-            // and is supposed to be honoured by readFrameData()
-            // todo: ensure this test is unneeded, remove the print
-            Serial.println("read error?\r\n");
-            pbuf_free(pbuf);
-            return ERR_BUF;
+            RawDev::readFrameChunk((uint8_t*)q->payload, q->len, /*last*/!q->next);
         }
 
+#if PHY_HAS_CAPTURE
+        // with TCP_MSS=536 (lm2f), PBUF_POOL buffers are smaller than a full
+        // sized frame: chained frames are captured from a contiguous copy
+        char* capture = nullptr;
+        if (phy_capture && pbuf->next)
+        {
+            capture = (char*)malloc(tot_len);
+            if (capture)
+            {
+                pbuf_copy_partial(pbuf, capture, tot_len, 0);
+            }
+        }
+        const char* captured = pbuf->next ? capture : (const char*)pbuf->payload;
+#endif
+
         err_t err = _netif.input(pbuf, &_netif);
 
 #if PHY_HAS_CAPTURE
-        if (phy_capture)
+        if (phy_capture && captured)
         {
-            phy_capture(_netif.num, (const char*)pbuf->payload, tot_len, /*out*/0, /*success*/err == ERR_OK);
+            phy_capture(_netif.num, captured, tot_len, /*out*/0, /*success*/err == ERR_OK);
         }
+        free(capture);
 #endif
 
         if (err != ERR_OK)
         {
             pbuf_free(pbuf);
+            _rxStats.drops++;
+            _rxPending = true;
             return err;
         }
         // (else) allocated pbuf is now lwIP's responsibility
+        _rxStats.frames++;
+
+    }
+}
+
+template <class RawDev>
+void LwipIntfDev<RawDev>::poll()
+{
+    uint32_t before = _rxStats.frames + _rxStats.drops;
+    handlePackets();
+    if (_rxStats.frames + _rxStats.drops != before)
+    {
+        _rxStats.pollHits++;
+    }
+    else
+    {
+        _rxStats.pollMisses++;
+    }
+}
 
+template <class RawDev>
+void LwipIntfDev<RawDev>::service()
+{
+    if (!_rxInterrupt)
+    {
+        poll();
+        return;
     }
+    _rxInterrupt = false;
+    // acknowledge first, so a frame received meanwhile raises intr pin again
+    RawDev::ackRxInterrupt();
+    handlePackets();
+    if (_rxPending)
+    {
+        // budget exhausted, intr pin will not be raised again for these frames
+        _rxInterrupt = true;
+    }
+}
+
+template <class RawDev>
+IRAM_ATTR void LwipIntfDev<RawDev>::interrupt_s(void* arg)
+{
+    LwipIntfDev* ths = (LwipIntfDev*)arg;
+    ths->_rxStats.interrupts++;
+    ths->_rxInterrupt = true;
+    // wake up a sleeping delay(), the alarm is checked when cont resumes
+    esp_schedule();
 }
 
 template <class RawDev>
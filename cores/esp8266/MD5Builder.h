@@ -43,6 +43,10 @@ class MD5Builder {
     void getBytes(uint8_t * output) const;
     void getChars(char * output) const;
     String toString(void) const;
+
+    // state of the hash being computed, to continue it later
+    const md5_context_t& getContext(void) const { return _ctx; }
+    void setContext(const md5_context_t& ctx) { _ctx = ctx; }
 };
 
 
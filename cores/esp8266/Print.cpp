@@ -29,6 +29,429 @@
 
 #include "Print.h"
 
+// Formatter ///////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Collects the output of printf() in a small stack buffer, handed to write()
+// whenever it is full (or holds what the sink can take without blocking, as
+// told by availableForWrite()): the output is never allocated nor formatted
+// twice, whatever its length.
+class PrintfSink {
+public:
+    explicit PrintfSink(Print& out): _out(out) {
+        setLimit();
+    }
+
+    size_t produced() const {
+        return _produced;
+    }
+
+    size_t written() const {
+        return _written;
+    }
+
+    bool failed() const {
+        return _failed;
+    }
+
+    void put(char c) {
+        if (_used >= _limit) {
+            flush();
+        }
+        _chunk[_used++] = c;
+        _produced++;
+    }
+
+    // 'str' may be in RAM or in flash
+    void put(const char* str, size_t len) {
+        while (len) {
+            if (_used >= _limit) {
+                flush();
+            }
+            size_t n = std::min(len, _limit - _used);
+            memcpy_P(_chunk + _used, str, n);
+            _used += n;
+            _produced += n;
+            str += n;
+            len -= n;
+        }
+    }
+
+    void fill(char c, size_t count) {
+        while (count--) {
+            put(c);
+        }
+    }
+
+    // room left in the buffer, flushed first when less than 'wanted' bytes are free
+    char* reserve(size_t wanted, size_t& room) {
+        if (sizeof(_chunk) - _used < wanted) {
+            flush();
+        }
+        room = sizeof(_chunk) - _used;
+        return _chunk + _used;
+    }
+
+    void commit(size_t len) {
+        _used += len;
+        _produced += len;
+    }
+
+    void flush() {
+        if (_used && !_failed) {
+            size_t n = _out.write((const uint8_t*) _chunk, _used);
+            _written += n;
+            _failed = n != _used;
+        }
+        _used = 0;
+        setLimit();
+    }
+
+private:
+    void setLimit() {
+        // small windows would only multiply the calls to write()
+        int room = _out.availableForWrite();
+        _limit = room >= 16 && (size_t) room < sizeof(_chunk) ? room : sizeof(_chunk);
+    }
+
+    Print& _out;
+    size_t _used = 0;
+    size_t _limit;
+    size_t _produced = 0;
+    size_t _written = 0;
+    bool _failed = false;
+    char _chunk[64];
+};
+
+enum : uint8_t {
+    FLAG_LEFT = 1,
+    FLAG_PLUS = 2,
+    FLAG_SPACE = 4,
+    FLAG_ALT = 8,
+    FLAG_ZERO = 16,
+};
+
+// %d %i %u %o %x %X %p, with flags, width and precision as in printf()
+void formatInteger(PrintfSink& sink, unsigned long long value, bool negative, char conversion,
+                   uint8_t flags, int width, int precision) {
+    const unsigned base = conversion == 'o' ? 8 : (conversion == 'x' || conversion == 'X' || conversion == 'p') ? 16 : 10;
+    const char* digitChars = conversion == 'X' ? "0123456789ABCDEF" : "0123456789abcdef";
+
+    char digits[22]; // 64 bits in octal
+    char* end = digits + sizeof(digits);
+    char* str = end;
+    if (base != 10) {
+        const unsigned shift = base == 16 ? 4 : 3;
+        for (; value; value >>= shift) {
+            *--str = digitChars[value & (base - 1)];
+        }
+    } else if (value <= 0xffffffffULL) {
+        // 32 bit divisions are much cheaper
+        for (uint32_t v = value; v; v /= 10) {
+            *--str = '0' + v % 10;
+        }
+    } else {
+        for (; value; value /= 10) {
+            *--str = '0' + value % 10;
+        }
+    }
+    size_t len = end - str;
+
+    // "%.0d" prints nothing for 0, "%#.0o" prints "0"
+    size_t zeros = precision >= 0 ? (precision > (int) len ? precision - len : 0) : (len ? 0 : 1);
+    if (base == 8 && (flags & FLAG_ALT) && !zeros && (!len || *str != '0')) {
+        zeros = 1;
+    }
+
+    char prefix[2];
+    size_t prefixLen = 0;
+    if (base == 10) {
+        if (negative) {
+            prefix[prefixLen++] = '-';
+        } else if (flags & FLAG_PLUS) {
+            prefix[prefixLen++] = '+';
+        } else if (flags & FLAG_SPACE) {
+            prefix[prefixLen++] = ' ';
+        }
+    } else if (base == 16 && (flags & FLAG_ALT) && (len || conversion == 'p')) {
+        // "%p" of NULL is "0x0", as in newlib
+        prefix[prefixLen++] = '0';
+        prefix[prefixLen++] = conversion == 'X' ? 'X' : 'x';
+    }
+
+    size_t total = prefixLen + zeros + len;
+    size_t padding = width > (int) total ? width - total : 0;
+    if (padding && (flags & FLAG_ZERO) && !(flags & FLAG_LEFT) && precision < 0) {
+        zeros += padding;
+        padding = 0;
+    }
+
+    if (!(flags & FLAG_LEFT)) {
+        sink.fill(' ', padding);
+    }
+    sink.put(prefix, prefixLen);
+    sink.fill('0', zeros);
+    sink.put(str, len);
+    if (flags & FLAG_LEFT) {
+        sink.fill(' ', padding);
+    }
+}
+
+void formatString(PrintfSink& sink, const char* str, size_t len, uint8_t flags, int width) {
+    size_t padding = width > (int) len ? width - len : 0;
+    if (!(flags & FLAG_LEFT)) {
+        sink.fill(' ', padding);
+    }
+    sink.put(str, len);
+    if (flags & FLAG_LEFT) {
+        sink.fill(' ', padding);
+    }
+}
+
+// %f %e %g %a are left to the C library, one conversion at a time, into the
+// free part of the buffer
+template<typename T>
+void formatFloat(PrintfSink& sink, T value, char conversion, bool isLong,
+                 uint8_t flags, int width, int precision) {
+    char spec[12];
+    char* s = spec;
+    *s++ = '%';
+    if (flags & FLAG_LEFT) *s++ = '-';
+    if (flags & FLAG_PLUS) *s++ = '+';
+    if (flags & FLAG_SPACE) *s++ = ' ';
+    if (flags & FLAG_ALT) *s++ = '#';
+    if (flags & FLAG_ZERO) *s++ = '0';
+    *s++ = '*';
+    if (precision >= 0) {
+        *s++ = '.';
+        *s++ = '*';
+    }
+    if (isLong) *s++ = 'L';
+    *s++ = conversion;
+    *s = 0;
+
+    auto format = [&](char* buffer, size_t size) {
+        return precision >= 0 ? snprintf(buffer, size, spec, width, precision, value)
+                              : snprintf(buffer, size, spec, width, value);
+    };
+
+    size_t room;
+    char* buffer = sink.reserve(32, room);
+    int len = format(buffer, room);
+    if (len < 0) {
+        return;
+    }
+    if ((size_t) len < room) {
+        sink.commit(len);
+        return;
+    }
+
+    // longer than the buffer (e.g. "%f" of 1e100, or a large width): this
+    // conversion alone is formatted in a temporary buffer
+    char* temp = new (std::nothrow) char[len + 1];
+    if (temp) {
+        format(temp, len + 1);
+        sink.put(temp, len);
+        delete[] temp;
+    }
+}
+
+size_t formatTo(Print& out, PGM_P format, va_list arg) {
+    PrintfSink sink(out);
+
+    // the format string may be in flash
+    for (char c; (c = pgm_read_byte(format)) && !sink.failed();) {
+        if (c != '%') {
+            PGM_P text = format;
+            while ((c = pgm_read_byte(++format)) && c != '%') {
+            }
+            sink.put(text, format - text);
+            continue;
+        }
+        format++;
+
+        uint8_t flags = 0;
+        for (;; format++) {
+            c = pgm_read_byte(format);
+            if (c == '-') flags |= FLAG_LEFT;
+            else if (c == '+') flags |= FLAG_PLUS;
+            else if (c == ' ') flags |= FLAG_SPACE;
+            else if (c == '#') flags |= FLAG_ALT;
+            else if (c == '0') flags |= FLAG_ZERO;
+            else break;
+        }
+
+        int width = 0;
+        if (c == '*') {
+            width = va_arg(arg, int);
+            if (width < 0) {
+                flags |= FLAG_LEFT;
+                width = -width;
+            }
+            c = pgm_read_byte(++format);
+        } else {
+            for (; c >= '0' && c <= '9'; c = pgm_read_byte(++format)) {
+                width = width * 10 + c - '0';
+            }
+        }
+
+        int precision = -1;
+        if (c == '.') {
+            c = pgm_read_byte(++format);
+            if (c == '*') {
+                precision = va_arg(arg, int);
+                c = pgm_read_byte(++format);
+            } else {
+                for (precision = 0; c >= '0' && c <= '9'; c = pgm_read_byte(++format)) {
+                    precision = precision * 10 + c - '0';
+                }
+            }
+            if (precision < 0) {
+                precision = -1;
+            }
+        }
+
+        // length modifier, in units of int
+        enum { LEN_CHAR, LEN_SHORT, LEN_INT, LEN_LONG, LEN_LONGLONG, LEN_SIZE, LEN_MAX, LEN_PTRDIFF, LEN_DOUBLE } length = LEN_INT;
+        switch (c) {
+        case 'h':
+            length = LEN_SHORT;
+            if (pgm_read_byte(format + 1) == 'h') {
+                length = LEN_CHAR;
+                format++;
+            }
+            break;
+        case 'l':
+            length = LEN_LONG;
+            if (pgm_read_byte(format + 1) == 'l') {
+                length = LEN_LONGLONG;
+                format++;
+            }
+            break;
+        case 'q': length = LEN_LONGLONG; break;
+        case 'z': length = LEN_SIZE; break;
+        case 'j': length = LEN_MAX; break;
+        case 't': length = LEN_PTRDIFF; break;
+        case 'L': length = LEN_DOUBLE; break;
+        default: format--; break;
+        }
+        format++;
+        c = pgm_read_byte(format++);
+
+        switch (c) {
+        case 'd':
+        case 'i': {
+            long long value;
+            switch (length) {
+            case LEN_CHAR: value = (signed char) va_arg(arg, int); break;
+            case LEN_SHORT: value = (short) va_arg(arg, int); break;
+            case LEN_LONG: value = va_arg(arg, long); break;
+            case LEN_LONGLONG:
+            case LEN_DOUBLE: value = va_arg(arg, long long); break;
+            case LEN_SIZE: value = va_arg(arg, ssize_t); break;
+            case LEN_MAX: value = va_arg(arg, intmax_t); break;
+            case LEN_PTRDIFF: value = va_arg(arg, ptrdiff_t); break;
+            default: value = va_arg(arg, int); break;
+            }
+            unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long) value : value;
+            formatInteger(sink, magnitude, value < 0, c, flags, width, precision);
+            break;
+        }
+
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X': {
+            unsigned long long value;
+            switch (length) {
+            case LEN_CHAR: value = (unsigned char) va_arg(arg, unsigned); break;
+            case LEN_SHORT: value = (unsigned short) va_arg(arg, unsigned); break;
+            case LEN_LONG: value = va_arg(arg, unsigned long); break;
+            case LEN_LONGLONG:
+            case LEN_DOUBLE: value = va_arg(arg, unsigned long long); break;
+            case LEN_SIZE: value = va_arg(arg, size_t); break;
+            case LEN_MAX: value = va_arg(arg, uintmax_t); break;
+            case LEN_PTRDIFF: value = va_arg(arg, ptrdiff_t); break;
+            default: value = va_arg(arg, unsigned); break;
+            }
+            formatInteger(sink, value, false, c, flags & ~(FLAG_PLUS | FLAG_SPACE), width, precision);
+            break;
+        }
+
+        case 'p':
+            formatInteger(sink, (uintptr_t) va_arg(arg, void*), false, 'p', (flags & FLAG_LEFT) | FLAG_ALT, width, -1);
+            break;
+
+        case 'c': {
+            char value = va_arg(arg, int);
+            formatString(sink, &value, 1, flags, width);
+            break;
+        }
+
+        case 's':
+        case 'S': { // strings may be in flash
+            const char* value = va_arg(arg, const char*);
+            if (!value) {
+                value = "(null)";
+            }
+            size_t len = precision >= 0 ? strnlen_P(value, precision) : strlen_P(value);
+            formatString(sink, value, len, flags, width);
+            break;
+        }
+
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            if (length == LEN_DOUBLE) {
+                formatFloat(sink, va_arg(arg, long double), c, true, flags, width, precision);
+            } else {
+                formatFloat(sink, va_arg(arg, double), c, false, flags, width, precision);
+            }
+            break;
+
+        case 'n': {
+            size_t count = sink.produced();
+            switch (length) {
+            case LEN_CHAR: *va_arg(arg, signed char*) = count; break;
+            case LEN_SHORT: *va_arg(arg, short*) = count; break;
+            case LEN_LONG: *va_arg(arg, long*) = count; break;
+            case LEN_LONGLONG: *va_arg(arg, long long*) = count; break;
+            case LEN_SIZE: *va_arg(arg, size_t*) = count; break;
+            case LEN_MAX: *va_arg(arg, intmax_t*) = count; break;
+            case LEN_PTRDIFF: *va_arg(arg, ptrdiff_t*) = count; break;
+            default: *va_arg(arg, int*) = count; break;
+            }
+            break;
+        }
+
+        case '%':
+            sink.put('%');
+            break;
+
+        case 0:
+            // lone '%' ending the format
+            format--;
+            break;
+
+        default:
+            // unknown conversion: shown as is
+            sink.put(c);
+            break;
+        }
+    }
+
+    sink.flush();
+    return sink.written();
+}
+
+} // namespace
+
 // Public Methods //////////////////////////////////////////////////////////////
 
 /* default implementation: may be overridden */
@@ -50,46 +473,16 @@ size_t Print::write(const uint8_t *buffer, size_t size) {
 size_t Print::printf(const char *format, ...) {
     va_list arg;
     va_start(arg, format);
-    char temp[64];
-    char* buffer = temp;
-    size_t len = vsnprintf(temp, sizeof(temp), format, arg);
+    size_t len = formatTo(*this, format, arg);
     va_end(arg);
-    if (len > sizeof(temp) - 1) {
-        buffer = new (std::nothrow) char[len + 1];
-        if (!buffer) {
-            return 0;
-        }
-        va_start(arg, format);
-        vsnprintf(buffer, len + 1, format, arg);
-        va_end(arg);
-    }
-    len = write((const uint8_t*) buffer, len);
-    if (buffer != temp) {
-        delete[] buffer;
-    }
     return len;
 }
 
 size_t Print::printf_P(PGM_P format, ...) {
     va_list arg;
     va_start(arg, format);
-    char temp[64];
-    char* buffer = temp;
-    size_t len = vsnprintf_P(temp, sizeof(temp), format, arg);
+    size_t len = formatTo(*this, format, arg);
     va_end(arg);
-    if (len > sizeof(temp) - 1) {
-        buffer = new (std::nothrow) char[len + 1];
-        if (!buffer) {
-            return 0;
-        }
-        va_start(arg, format);
-        vsnprintf_P(buffer, len + 1, format, arg);
-        va_end(arg);
-    }
-    len = write((const uint8_t*) buffer, len);
-    if (buffer != temp) {
-        delete[] buffer;
-    }
     return len;
 }
 
@@ -40,14 +40,48 @@ struct recurrent_fn_t
 {
     recurrent_fn_t* mNext = nullptr;
     mRecFuncT mFunc;
-    esp8266::polledTimeout::periodicFastUs callNow;
+    uint32_t mPeriod; // us
+    uint32_t mDue;    // micros() of next call
+    uint32_t mSeq;    // registration order, for equal deadlines
     std::function<bool(void)> alarm = nullptr;
-    recurrent_fn_t(esp8266::polledTimeout::periodicFastUs interval) : callNow(interval) { }
+    recurrent_fn_t(uint32_t period, uint32_t due, uint32_t seq) : mPeriod(period), mDue(due), mSeq(seq) { }
 };
 
+// newly registered functions (possibly from ISR), moved by
+// run_scheduled_recurrent_functions() to:
+static recurrent_fn_t* rPendingFirst = nullptr;
+static recurrent_fn_t* rPendingLast = nullptr;
+static uint32_t rSeq = 0;
+
+// - functions with an alarm, which must be polled at every run
+//   (also used as fallback when heap cannot grow)
 static recurrent_fn_t* rFirst = nullptr;
 static recurrent_fn_t* rLast = nullptr;
 
+// - a min-heap of other functions sorted by deadline, so that only
+//   due functions are touched
+static recurrent_fn_t** rHeap = nullptr;
+static size_t rHeapCount = 0;
+static size_t rHeapSize = 0;
+
+static_assert((SCHEDULED_FN_ISR_MAX_COUNT & (SCHEDULED_FN_ISR_MAX_COUNT - 1)) == 0,
+    "SCHEDULED_FN_ISR_MAX_COUNT must be a power of 2");
+static_assert(SCHEDULED_FN_ISR_STATE_SIZE % sizeof(uintptr_t) == 0,
+    "SCHEDULED_FN_ISR_STATE_SIZE must be a multiple of sizeof(void*)");
+
+struct scheduled_fn_isr_t
+{
+    void (*mFunc)(void* state);
+    volatile bool mReady; // set once the producer has filled the slot
+    uintptr_t mState[SCHEDULED_FN_ISR_STATE_SIZE / sizeof(uintptr_t)];
+};
+
+static scheduled_fn_isr_t iRing[SCHEDULED_FN_ISR_MAX_COUNT];
+// free running indexes, iHead is only written by the consumer
+static volatile uint32_t iHead = 0;
+static volatile uint32_t iTail = 0;
+static scheduled_fn_isr_stats_t iStats = { };
+
 // Returns a pointer to an unused sched_fn_t,
 // or if none are available allocates a new one,
 // or nullptr if limit is reached
@@ -102,16 +136,76 @@ bool schedule_function(const std::function<void(void)>& fn)
     return true;
 }
 
+IRAM_ATTR // (not only) called from ISR
+bool schedule_function_isr_raw(void (*trampoline)(void* state), const uintptr_t* state)
+{
+    uint32_t slot;
+    {
+        esp8266::InterruptLock lockAllInterruptsInThisScope;
+
+        uint32_t pending = iTail - iHead;
+        if (pending >= SCHEDULED_FN_ISR_MAX_COUNT)
+        {
+            ++iStats.dropped;
+            return false;
+        }
+        if (++pending > iStats.highWater)
+            iStats.highWater = pending;
+        slot = iTail++;
+    }
+
+    // slot is reserved, fill it with interrupts enabled
+    scheduled_fn_isr_t& item = iRing[slot & (SCHEDULED_FN_ISR_MAX_COUNT - 1)];
+    item.mFunc = trampoline;
+    for (size_t i = 0; i < SCHEDULED_FN_ISR_STATE_SIZE / sizeof(uintptr_t); i++)
+        item.mState[i] = state[i];
+    // slot content must be visible before it is published
+    __sync_synchronize();
+    item.mReady = true;
+
+    return true;
+}
+
+scheduled_fn_isr_stats_t get_scheduled_fn_isr_stats(bool reset)
+{
+    esp8266::InterruptLock lockAllInterruptsInThisScope;
+
+    scheduled_fn_isr_stats_t ret = iStats;
+    if (reset)
+        iStats = { };
+    return ret;
+}
+
+static void run_scheduled_isr_functions()
+{
+    // prevent running of new functions during this run
+    const uint32_t stop = iTail;
+    while (iHead != stop)
+    {
+        scheduled_fn_isr_t& item = iRing[iHead & (SCHEDULED_FN_ISR_MAX_COUNT - 1)];
+        if (!item.mReady)
+            // producer has been interrupted while filling its slot
+            break;
+        // slot content must not be read before mReady
+        __sync_synchronize();
+        item.mFunc(item.mState);
+        item.mReady = false;
+        // slot must be done with before it is released to producers
+        __sync_synchronize();
+        iHead = iHead + 1; // releases the slot
+    }
+}
+
 IRAM_ATTR // (not only) called from ISR
 bool schedule_recurrent_function_us(const std::function<bool(void)>& fn,
     uint32_t repeat_us, const std::function<bool(void)>& alarm)
 {
-    assert(repeat_us < decltype(recurrent_fn_t::callNow)::neverExpires); //~26800000us (26.8s)
+    assert(repeat_us < esp8266::polledTimeout::periodicFastUs::neverExpires); //~26800000us (26.8s)
 
     if (!fn)
         return false;
 
-    recurrent_fn_t* item = new (std::nothrow) recurrent_fn_t(repeat_us);
+    recurrent_fn_t* item = new (std::nothrow) recurrent_fn_t(repeat_us, micros() + repeat_us, 0);
     if (!item)
         return false;
 
@@ -120,21 +214,24 @@ bool schedule_recurrent_function_us(const std::function<bool(void)>& fn,
 
     esp8266::InterruptLock lockAllInterruptsInThisScope;
 
-    if (rLast)
+    item->mSeq = rSeq++;
+    if (rPendingLast)
     {
-        rLast->mNext = item;
+        rPendingLast->mNext = item;
     }
     else
     {
-        rFirst = item;
+        rPendingFirst = item;
     }
-    rLast = item;
+    rPendingLast = item;
 
     return true;
 }
 
 void run_scheduled_functions()
 {
+    run_scheduled_isr_functions();
+
     esp8266::polledTimeout::periodicFastMs yieldNow(100); // yield every 100ms
 
     // prevent scheduling of new functions during this run
@@ -171,6 +268,115 @@ void run_scheduled_functions()
     }
 }
 
+static inline bool recurrent_is_due(const recurrent_fn_t* item, uint32_t now)
+{
+    return (int32_t)(now - item->mDue) >= 0;
+}
+
+static inline bool recurrent_before(const recurrent_fn_t* a, const recurrent_fn_t* b)
+{
+    if (a->mDue != b->mDue)
+        return (int32_t)(a->mDue - b->mDue) < 0;
+    return (int32_t)(a->mSeq - b->mSeq) < 0;
+}
+
+static void recurrent_reschedule(recurrent_fn_t* item, uint32_t now)
+{
+    // like periodicFastUs: skip missed periods
+    if (!item->mPeriod)
+    {
+        item->mDue = now;
+        return;
+    }
+    uint32_t late = now - item->mDue;
+    item->mDue += (late / item->mPeriod + 1) * item->mPeriod;
+}
+
+static void recurrent_append(recurrent_fn_t* item)
+{
+    item->mNext = nullptr;
+    if (rLast)
+        rLast->mNext = item;
+    else
+        rFirst = item;
+    rLast = item;
+}
+
+static void recurrent_heap_push(recurrent_fn_t* item)
+{
+    if (rHeapCount == rHeapSize)
+    {
+        size_t newSize = rHeapSize ? 2 * rHeapSize : 8;
+        recurrent_fn_t** newHeap = new (std::nothrow) recurrent_fn_t*[newSize];
+        if (!newHeap)
+        {
+            // still manageable, just slower
+            recurrent_append(item);
+            return;
+        }
+        for (size_t i = 0; i < rHeapCount; i++)
+            newHeap[i] = rHeap[i];
+        delete [] rHeap;
+        rHeap = newHeap;
+        rHeapSize = newSize;
+    }
+
+    size_t i = rHeapCount++;
+    while (i)
+    {
+        size_t parent = (i - 1) / 2;
+        if (!recurrent_before(item, rHeap[parent]))
+            break;
+        rHeap[i] = rHeap[parent];
+        i = parent;
+    }
+    rHeap[i] = item;
+}
+
+static recurrent_fn_t* recurrent_heap_pop()
+{
+    recurrent_fn_t* top = rHeap[0];
+    recurrent_fn_t* last = rHeap[--rHeapCount];
+    size_t i = 0;
+    while (true)
+    {
+        size_t child = 2 * i + 1;
+        if (child >= rHeapCount)
+            break;
+        if (child + 1 < rHeapCount && recurrent_before(rHeap[child + 1], rHeap[child]))
+            child++;
+        if (!recurrent_before(rHeap[child], last))
+            break;
+        rHeap[i] = rHeap[child];
+        i = child;
+    }
+    rHeap[i] = last;
+    return top;
+}
+
+static inline uint32_t recurrent_delay(const recurrent_fn_t* item, uint32_t now, uint32_t delay)
+{
+    int32_t remaining = item->mDue - now;
+    if (remaining <= 0)
+        return 0;
+    return (uint32_t)remaining < delay ? remaining : delay;
+}
+
+uint32_t get_scheduled_recurrent_delay_us()
+{
+    if (rPendingFirst)
+        // not sorted yet
+        return 0;
+    const uint32_t now = micros();
+    uint32_t delay = UINT32_MAX;
+    // heap top is the earliest deadline of the other functions
+    if (rHeapCount)
+        delay = recurrent_delay(rHeap[0], now, delay);
+    for (const recurrent_fn_t* item = rFirst; item && delay; item = item->mNext)
+        delay = recurrent_delay(item, now, delay);
+    return delay;
+}
+
 void run_scheduled_recurrent_functions()
 {
     esp8266::polledTimeout::periodicFastMs yieldNow(100); // yield every 100ms
@@ -180,9 +386,10 @@ void run_scheduled_recurrent_functions()
     // Scheduled functions are removed only from this function, and
     // its purpose is that it is never called from an interrupt
     // (always on cont stack).
+    // Only the pending list is shared with ISRs, the other
+    // containers are handled here without locking.
 
-    auto current = rFirst;
-    if (!current)
+    if (!rPendingFirst && !rFirst && !rHeapCount)
         return;
 
     static bool fence = false;
@@ -198,25 +405,41 @@ void run_scheduled_recurrent_functions()
         fence = true;
     }
 
-    recurrent_fn_t* prev = nullptr;
-    // prevent scheduling of new functions during this run
-    auto stop = rLast;
+    // sort newly registered functions,
+    // those scheduled during this run will be considered next time
+    recurrent_fn_t* pending;
+    {
+        esp8266::InterruptLock lockAllInterruptsInThisScope;
+        pending = rPendingFirst;
+        rPendingFirst = rPendingLast = nullptr;
+    }
+    while (pending)
+    {
+        recurrent_fn_t* item = pending;
+        pending = pending->mNext;
+        if (item->alarm)
+            recurrent_append(item);
+        else
+            recurrent_heap_push(item);
+    }
 
-    bool done;
-    do
+    const uint32_t now = micros();
+
+    // functions with alarm are polled
+    recurrent_fn_t* prev = nullptr;
+    recurrent_fn_t* current = rFirst;
+    while (current)
     {
-        done = current == stop;
         const bool wakeup = current->alarm && current->alarm();
-        bool callNow = current->callNow;
+        const bool callNow = recurrent_is_due(current, now);
+        if (callNow)
+            recurrent_reschedule(current, now);
 
         if ((wakeup || callNow) && !current->mFunc())
         {
-            // remove function from stack
-            esp8266::InterruptLock lockAllInterruptsInThisScope;
-
+            // remove function from list
             auto to_ditch = current;
 
-            // removing rLast
             if (rLast == current)
                 rLast = prev;
 
@@ -245,7 +468,46 @@ void run_scheduled_recurrent_functions()
             esp_schedule();
             cont_yield(g_pcont);
         }
-    } while (current && !done);
+    }
+
+    // other functions: extract due ones in deadline order,
+    // so that each of them is called only once during this run
+    recurrent_fn_t* due = nullptr;
+    recurrent_fn_t* dueLast = nullptr;
+    while (rHeapCount && recurrent_is_due(rHeap[0], now))
+    {
+        recurrent_fn_t* item = recurrent_heap_pop();
+        item->mNext = nullptr;
+        if (dueLast)
+            dueLast->mNext = item;
+        else
+            due = item;
+        dueLast = item;
+    }
+
+    while (due)
+    {
+        current = due;
+        due = due->mNext;
+
+        if (current->mFunc())
+        {
+            recurrent_reschedule(current, now);
+            recurrent_heap_push(current);
+        }
+        else
+        {
+            delete(current);
+        }
+
+        if (yieldNow)
+        {
+            // because scheduled functions might last too long for watchdog etc,
+            // this is yield() in cont stack:
+            esp_schedule();
+            cont_yield(g_pcont);
+        }
+    }
 
     fence = false;
 }
@@ -20,10 +20,19 @@
 #define ESP_SCHEDULE_H
 
 #include <functional>
+#include <new>
+#include <type_traits>
 #include <stdint.h>
 
 #define SCHEDULED_FN_MAX_COUNT 32
 
+#ifndef SCHEDULED_FN_ISR_MAX_COUNT
+#define SCHEDULED_FN_ISR_MAX_COUNT 32 // must be a power of 2
+#endif
+#ifndef SCHEDULED_FN_ISR_STATE_SIZE
+#define SCHEDULED_FN_ISR_STATE_SIZE (2 * sizeof(void*)) // bytes, multiple of sizeof(void*)
+#endif
+
 // The purpose of scheduled functions is to trigger, from SYS stack (like in
 // an interrupt or a system event), registration of user code to be executed
 // in user stack (called CONT stack) without the common restrictions from
@@ -63,9 +72,44 @@ bool schedule_function (const std::function<void(void)>& fn);
 
 void run_scheduled_functions();
 
+// allocation-free scheduled functions (ISR friendly):
+//
+// * internal queue is a fixed-size FIFO ring of SCHEDULED_FN_ISR_MAX_COUNT
+//   entries, nothing is allocated.
+// * Interrupts are only masked while a ring slot is reserved.
+// * fn is a function pointer or a trivially copyable lambda whose captures
+//   fit in SCHEDULED_FN_ISR_STATE_SIZE bytes (they are copied in the ring).
+// * Returns false when the ring is full (this is counted, see below).
+// * These functions are run by `run_scheduled_functions()`, before those
+//   registered with `schedule_function()`.
+
+struct scheduled_fn_isr_stats_t
+{
+    uint32_t dropped;   // number of refused registrations (ring was full)
+    uint32_t highWater; // maximum number of pending functions seen
+};
+
+scheduled_fn_isr_stats_t get_scheduled_fn_isr_stats(bool reset = false);
+
+bool schedule_function_isr_raw(void (*trampoline)(void* state), const uintptr_t* state);
+
+template <typename T>
+inline __attribute__((always_inline)) // stay in caller's IRAM
+bool schedule_function_isr(const T& fn)
+{
+    using callable_t = typename std::decay<T>::type;
+    static_assert(sizeof(callable_t) <= SCHEDULED_FN_ISR_STATE_SIZE, "captures are too large for SCHEDULED_FN_ISR_STATE_SIZE");
+    static_assert(alignof(callable_t) <= alignof(uintptr_t), "captures are overaligned");
+    static_assert(std::is_trivially_copyable<callable_t>::value, "captures must be trivially copyable");
+
+    uintptr_t state[SCHEDULED_FN_ISR_STATE_SIZE / sizeof(uintptr_t)] = { };
+    new (state) callable_t(fn);
+    return schedule_function_isr_raw([](void* s) { (*reinterpret_cast<callable_t*>(s))(); }, state);
+}
+
 // recurrent scheduled function:
 //
-// * Internal queue is a FIFO.
+// * Internal queue is sorted by deadline (FIFO for equal deadlines).
 // * Run the lambda periodically about every <repeat_us> microseconds until
 //   it returns false.
 // * Note that it may be more than <repeat_us> microseconds between calls if
@@ -85,7 +129,19 @@ bool schedule_recurrent_function_us(const std::function<bool(void)>& fn,
 
 // Test recurrence and run recurrent scheduled functions.
 // (internally called at every `yield()` and `loop()`)
+// Functions without alarm are kept sorted by deadline, only due ones are
+// visited.  Functions with an alarm are checked at every call.
 
 void run_scheduled_recurrent_functions();
 
+// Return the delay in microseconds until a recurrent function is due:
+// 0 when one is due or has just been registered, UINT32_MAX when there is
+// none.  delay() sleeps no longer than this, so that recurrent functions
+// are run on time.
+// Alarms are not polled meanwhile: code making an alarm true from an
+// interrupt must also call esp_schedule() to wake up a sleeping delay().
+// (to be called from cont stack)
+
+uint32_t get_scheduled_recurrent_delay_us();
+
 #endif // ESP_SCHEDULE_H
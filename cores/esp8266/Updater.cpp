@@ -3,6 +3,8 @@
 #include <esp8266_peri.h>
 #include <PolledTimeout.h>
 #include "StackThunk.h"
+#include <coredecls.h>
+#include <stddef.h>
 
 //#define DEBUG_UPDATER Serial
 
@@ -26,6 +28,46 @@ extern "C" {
 
 #include <flash_hal.h>
 
+/*
+  Delta patches (made by tools/delta.py) rebuild the new sketch from the
+  running one, which is read back from flash while the patch is received:
+
+  header (32 bytes, integers are little endian):
+    0   magic: UPDATE_DELTA_MAGIC 'D' 'L' 'T'
+    4   version (1), 3 reserved bytes
+    8   uint32 size of the running sketch the patch was made from
+    12  uint32 size of the new sketch
+    16  MD5 of the running sketch, from byte 4 (bytes 2 and 3 hold
+        the flash mode and size, they can differ from the .bin file)
+  commands:
+    0x00                    end of the patch
+    0x01 <offset> <length>  copy <length> bytes of the running sketch, from
+                            <offset> (zigzag encoded) after the last copy
+    0x02 <length> <bytes>   insert <length> new bytes
+  numbers are unsigned LEB128.
+*/
+#define DELTA_HEADER_SIZE 32
+
+struct UpdaterClass::DeltaState {
+  enum Step : uint8_t { HEADER, COMMAND, COPY_OFFSET, COPY_LENGTH, INSERT_LENGTH, INSERT, END };
+
+  Step step = HEADER;
+  uint8_t shift = 0;           // of the next 7 bits of 'number'
+  uint32_t number = 0;         // being decoded
+  uint32_t consumed = 0;       // patch bytes applied
+  uint32_t sourceSize = 0;
+  uint32_t targetSize = 0;
+  uint32_t sourceAddress = 0;  // end of the last copy
+  uint32_t insertLeft = 0;
+  size_t outLen = 0;
+  // holds the header, then the new sketch until it is written
+  uint8_t out[FLASH_PAGE_SIZE] __attribute__((aligned(4)));
+};
+
+static uint32_t _deltaRead32(const uint8_t *data) {
+  return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
 UpdaterClass::UpdaterClass()
 {
 #if ARDUINO_SIGNING
@@ -50,11 +92,14 @@ void UpdaterClass::_reset() {
   if (_buffer)
     delete[] _buffer;
   _buffer = 0;
+  delete _delta;
+  _delta = nullptr;
   _bufferLen = 0;
   _startAddress = 0;
   _currentAddress = 0;
   _size = 0;
   _command = U_FLASH;
+  _resumable = false;
 
   if(_ledPin != -1) {
     digitalWrite(_ledPin, !_ledOn); // off
@@ -164,7 +209,10 @@ bool UpdaterClass::begin(size_t size, int command, int ledPin, uint8_t ledOn) {
   //initialize
   _startAddress = updateStartAddress;
   _currentAddress = _startAddress;
+  _erasedEnd = _startAddress;
   _size = size;
+  _stats = UpdaterStats();
+  _startMs = millis();
   if (ESP.getFreeHeap() > 2 * FLASH_SECTOR_SIZE) {
     _bufferSize = FLASH_SECTOR_SIZE;
   } else {
@@ -223,6 +271,15 @@ bool UpdaterClass::end(bool evenIfRemaining){
     _size = progress();
   }
 
+  if (_resumable) {
+    // complete: whatever the verification says, there is nothing to resume
+    clearResumable();
+  }
+
+  if (_delta && !_endDelta()) {
+    return false;
+  }
+
   uint32_t sigLen = 0;
   if (_verify) {
     ESP.flashRead(_startAddress + _size - sizeof(uint32_t), &sigLen, sizeof(uint32_t));
@@ -296,6 +353,12 @@ bool UpdaterClass::end(bool evenIfRemaining){
     return false;
   }
 
+#ifdef DEBUG_UPDATER
+  DEBUG_UPDATER.printf_P(PSTR("[Updater] %u bytes in %u ms (%u B/s), erase: %u ms (%u sectors, %u ahead), write: %u ms, wait: %u ms\n"),
+                         _stats.bytes, _stats.durationMs, _stats.throughput(), _stats.eraseUs / 1000, _stats.sectorsErased,
+                         _stats.sectorsErasedAhead, _stats.writeUs / 1000, _stats.waitUs / 1000);
+#endif
+
   if (_command == U_FLASH) {
     eboot_command ebcmd;
     ebcmd.action = ACTION_COPY_RAW;
@@ -328,13 +391,44 @@ bool UpdaterClass::end(bool evenIfRemaining){
 }
 
 bool UpdaterClass::_writeBuffer(){
+  if (!_delta && _bufferLen && _buffer[0] == UPDATE_DELTA_MAGIC
+      && _command == U_FLASH && _currentAddress == _startAddress) {
+    _delta = new (std::nothrow) DeltaState;
+    if (!_delta) {
+      _currentAddress = (_startAddress + _size);
+      _setError(UPDATE_ERROR_DELTA);
+      return false;
+    }
+  }
+
+  if (_delta) {
+    if (!_applyDelta(_buffer, _bufferLen)) {
+      return false;
+    }
+  } else if (!_writeFlash(_buffer, _bufferLen)) {
+    return false;
+  }
+  _bufferLen = 0;
+  return true;
+}
+
+bool UpdaterClass::_writeFlash(uint8_t *data, size_t len){
   #define FLASH_MODE_PAGE  0
   #define FLASH_MODE_OFFSET  2
 
+  if (_resumable && !_delta) {
+    // checkpoints are taken on sector boundaries, split writes crossing one
+    size_t toBoundary = FLASH_SECTOR_SIZE - (_currentAddress - _startAddress) % FLASH_SECTOR_SIZE;
+    if (len > toBoundary) {
+      return _writeFlash(data, toBoundary) && _writeFlash(data + toBoundary, len - toBoundary);
+    }
+  }
+
   bool eraseResult = true, writeResult = true;
-  if (_currentAddress % FLASH_SECTOR_SIZE == 0) {
+  // sectors which were not erased ahead are erased when they are reached
+  while (eraseResult && _erasedEnd < _currentAddress + len) {
     if(!_async) yield();
-    eraseResult = ESP.flashEraseSector(_currentAddress/FLASH_SECTOR_SIZE);
+    eraseResult = _eraseSector();
   }
 
   // If the flash settings don't match what we already have, modify them.
@@ -344,25 +438,27 @@ bool UpdaterClass::_writeBuffer(){
   FlashMode_t flashMode = FM_QIO;
   FlashMode_t bufferFlashMode = FM_QIO;
   //TODO - GZIP can't do this
-  if ((_currentAddress == _startAddress + FLASH_MODE_PAGE) && (_buffer[0] != 0x1f) && (_command == U_FLASH)) {
+  if ((_currentAddress == _startAddress + FLASH_MODE_PAGE) && (data[0] != 0x1f) && (_command == U_FLASH)) {
     flashMode = ESP.getFlashChipMode();
     #ifdef DEBUG_UPDATER
-      DEBUG_UPDATER.printf_P(PSTR("Header: 0x%1X %1X %1X %1X\n"), _buffer[0], _buffer[1], _buffer[2], _buffer[3]);
+      DEBUG_UPDATER.printf_P(PSTR("Header: 0x%1X %1X %1X %1X\n"), data[0], data[1], data[2], data[3]);
     #endif
-    bufferFlashMode = ESP.magicFlashChipMode(_buffer[FLASH_MODE_OFFSET]);
+    bufferFlashMode = ESP.magicFlashChipMode(data[FLASH_MODE_OFFSET]);
     if (bufferFlashMode != flashMode) {
       #ifdef DEBUG_UPDATER
         DEBUG_UPDATER.printf_P(PSTR("Set flash mode from 0x%1X to 0x%1X\n"), bufferFlashMode, flashMode);
       #endif
 
-      _buffer[FLASH_MODE_OFFSET] = flashMode;
+      data[FLASH_MODE_OFFSET] = flashMode;
       modifyFlashMode = true;
     }
   }
   
   if (eraseResult) {
     if(!_async) yield();
-    writeResult = ESP.flashWrite(_currentAddress, _buffer, _bufferLen);
+    uint32_t start = micros();
+    writeResult = ESP.flashWrite(_currentAddress, data, len);
+    _stats.writeUs += micros() - start;
   } else { // if erase was unsuccessful
     _currentAddress = (_startAddress + _size);
     _setError(UPDATE_ERROR_ERASE);
@@ -372,7 +468,7 @@ bool UpdaterClass::_writeBuffer(){
   // Restore the old flash mode, if we modified it.
   // Ensures that the MD5 hash will still match what was sent.
   if (modifyFlashMode) {
-    _buffer[FLASH_MODE_OFFSET] = bufferFlashMode;
+    data[FLASH_MODE_OFFSET] = bufferFlashMode;
   }
 
   if (!writeResult) {
@@ -381,10 +477,60 @@ bool UpdaterClass::_writeBuffer(){
     return false;
   }
   if (!_verify) {
-    _md5.add(_buffer, _bufferLen);
+    _md5.add(data, len);
   }
-  _currentAddress += _bufferLen;
-  _bufferLen = 0;
+  _currentAddress += len;
+  _stats.bytes += len;
+  _stats.durationMs = millis() - _startMs;
+  if (_resumable && !_delta && (_currentAddress - _startAddress) % FLASH_SECTOR_SIZE == 0) {
+    _saveCheckpoint();
+  }
+  return true;
+}
+
+bool UpdaterClass::_eraseSector() {
+  uint32_t start = micros();
+  bool result = ESP.flashEraseSector(_erasedEnd / FLASH_SECTOR_SIZE);
+  _stats.eraseUs += micros() - start;
+  _stats.sectorsErased++;
+  _erasedEnd += FLASH_SECTOR_SIZE;
+  return result;
+}
+
+bool UpdaterClass::idle() {
+  if (!_eraseAhead || hasError() || !isRunning()) {
+    return false;
+  }
+
+  // the size of a delta update is known from the patch header
+  uint32_t end = _startAddress + (_delta ? _delta->targetSize : _size);
+  uint32_t ahead = (_currentAddress & ~(FLASH_SECTOR_SIZE - 1)) + (_eraseAhead + 1) * FLASH_SECTOR_SIZE;
+  if (_erasedEnd >= std::min(end, ahead)) {
+    return false;
+  }
+
+  if (!_eraseSector()) {
+    _currentAddress = (_startAddress + _size);
+    _setError(UPDATE_ERROR_ERASE);
+    return false;
+  }
+  _stats.sectorsErasedAhead++;
+  return true;
+}
+
+// pipelined writes: the complete pages are written, the rest stays in _buffer
+bool UpdaterClass::_writePages() {
+  size_t len = _bufferLen & ~(FLASH_PAGE_SIZE - 1);
+  if (!len) {
+    return true;
+  }
+  size_t rest = _bufferLen - len;
+  _bufferLen = len;
+  if (!_writeBuffer()) {
+    return false;
+  }
+  memmove(_buffer, _buffer + len, rest);
+  _bufferLen = rest;
   return true;
 }
 
@@ -417,6 +563,8 @@ size_t UpdaterClass::write(uint8_t *data, size_t len) {
     if(!_writeBuffer()){
       return len - left;
     }
+  } else if (_eraseAhead && !_writePages()) {
+    return len - left;
   }
   return len;
 }
@@ -424,7 +572,7 @@ size_t UpdaterClass::write(uint8_t *data, size_t len) {
 bool UpdaterClass::_verifyHeader(uint8_t data) {
     if(_command == U_FLASH) {
         // check for valid first magic byte (is always 0xE9)
-        if ((data != 0xE9) && (data != 0x1f)) {
+        if ((data != 0xE9) && (data != 0x1f) && (data != UPDATE_DELTA_MAGIC)) {
             _currentAddress = (_startAddress + _size);
             _setError(UPDATE_ERROR_MAGIC_BYTE);
             return false;
@@ -486,7 +634,8 @@ size_t UpdaterClass::writeStream(Stream &data, uint16_t streamTimeout) {
     if(hasError() || !isRunning())
         return 0;
 
-    if(!_verifyHeader(data.peek())) {
+    // a resumed update doesn't start with the header
+    if(!progress() && !_verifyHeader(data.peek())) {
 #ifdef DEBUG_UPDATER
         printError(DEBUG_UPDATER);
 #endif
@@ -495,7 +644,7 @@ size_t UpdaterClass::writeStream(Stream &data, uint16_t streamTimeout) {
     }
     esp8266::polledTimeout::oneShotMs timeOut(streamTimeout);
     if (_progress_callback) {
-        _progress_callback(0, _size);
+        _progress_callback(progress(), _size);
     }
     if(_ledPin != -1) {
         pinMode(_ledPin, OUTPUT);
@@ -506,10 +655,30 @@ size_t UpdaterClass::writeStream(Stream &data, uint16_t streamTimeout) {
             digitalWrite(_ledPin, _ledOn); // Switch LED on
         }
         size_t bytesToRead = _bufferSize - _bufferLen;
-        if(bytesToRead > remaining()) {
-            bytesToRead = remaining();
+        if(bytesToRead > remaining() - _bufferLen) {
+            bytesToRead = remaining() - _bufferLen;
+        }
+        if (_eraseAhead) {
+            // pipelined: only what is available is read, and the time
+            // spent waiting for more is used to erase the next sectors
+            toRead = 0;
+            size_t available = data.available();
+            if (available) {
+                int got = data.read(_buffer + _bufferLen, std::min(available, bytesToRead));
+                toRead = got > 0 ? got : 0;
+            } else {
+                uint32_t start = micros();
+                if (!idle()) {
+                    if (hasError()) {
+                        return written;
+                    }
+                    delay(1);
+                    _stats.waitUs += micros() - start;
+                }
+            }
+        } else {
+            toRead = data.readBytes(_buffer + _bufferLen,  bytesToRead);
         }
-        toRead = data.readBytes(_buffer + _bufferLen,  bytesToRead);
         if(toRead == 0) { //Timeout
           if (timeOut) {
             _currentAddress = (_startAddress + _size);
@@ -517,7 +686,9 @@ size_t UpdaterClass::writeStream(Stream &data, uint16_t streamTimeout) {
             _reset();
             return written;
           }
-          delay(100);
+          if (!_eraseAhead) {
+            delay(100);
+          }
         } else {
           timeOut.reset();
         }
@@ -525,8 +696,12 @@ size_t UpdaterClass::writeStream(Stream &data, uint16_t streamTimeout) {
             digitalWrite(_ledPin, !_ledOn); // Switch LED off
         }
         _bufferLen += toRead;
-        if((_bufferLen == remaining() || _bufferLen == _bufferSize) && !_writeBuffer())
+        if(_bufferLen == remaining() || _bufferLen == _bufferSize) {
+            if (!_writeBuffer())
+                return written;
+        } else if (_eraseAhead && toRead && !_writePages()) {
             return written;
+        }
         written += toRead;
         if(_progress_callback) {
             _progress_callback(progress(), _size);
@@ -539,6 +714,339 @@ size_t UpdaterClass::writeStream(Stream &data, uint16_t streamTimeout) {
     return written;
 }
 
+size_t UpdaterClass::_deltaProgress() {
+  return _delta->consumed;
+}
+
+bool UpdaterClass::_beginDelta() {
+  DeltaState &delta = *_delta;
+  const uint8_t *header = delta.out;
+
+  if (header[1] != 'D' || header[2] != 'L' || header[3] != 'T' || header[4] != 1) {
+    _setError(UPDATE_ERROR_DELTA);
+    return false;
+  }
+  delta.sourceSize = _deltaRead32(header + 8);
+  delta.targetSize = _deltaRead32(header + 12);
+  if (delta.sourceSize <= 4 || delta.sourceSize > ESP.getSketchSize() || !delta.targetSize) {
+    _setError(UPDATE_ERROR_DELTA);
+    return false;
+  }
+
+  // begin() only knew the size of the patch: the new sketch takes its place
+  // at the end of the space available
+  size_t currentSketchSize = (ESP.getSketchSize() + FLASH_SECTOR_SIZE - 1) & (~(FLASH_SECTOR_SIZE - 1));
+  size_t roundedSize = (delta.targetSize + FLASH_SECTOR_SIZE - 1) & (~(FLASH_SECTOR_SIZE - 1));
+  uintptr_t updateEndAddress = FS_start - 0x40200000;
+  if (updateEndAddress < roundedSize || updateEndAddress - roundedSize < currentSketchSize) {
+    _setError(UPDATE_ERROR_SPACE);
+    return false;
+  }
+  _startAddress = updateEndAddress - roundedSize;
+  _currentAddress = _startAddress;
+  _erasedEnd = _startAddress;
+
+#ifdef DEBUG_UPDATER
+  DEBUG_UPDATER.printf_P(PSTR("[delta] source size: %u, target size: %u\n"), delta.sourceSize, delta.targetSize);
+  DEBUG_UPDATER.printf_P(PSTR("[delta] _startAddress: 0x%08X (%d)\n"), _startAddress, _startAddress);
+#endif
+
+  // the patch only applies to the sketch it was made from
+  MD5Builder md5;
+  md5.begin();
+  uint8_t buff[128] __attribute__((aligned(4)));
+  for (uint32_t address = 4; address < delta.sourceSize; address += sizeof(buff)) {
+    size_t len = std::min(sizeof(buff), (size_t)(delta.sourceSize - address));
+    if (!ESP.flashRead(address, (uint32_t *)buff, (len + 3) & ~3)) {
+      _setError(UPDATE_ERROR_READ);
+      return false;
+    }
+    md5.add(buff, len);
+    if (!_async) yield();
+  }
+  md5.calculate();
+  uint8_t sum[16];
+  md5.getBytes(sum);
+  if (memcmp(sum, header + 16, sizeof(sum))) {
+#ifdef DEBUG_UPDATER
+    DEBUG_UPDATER.printf_P(PSTR("[delta] running sketch MD5 (from byte 4): %s\n"), md5.toString().c_str());
+#endif
+    _setError(UPDATE_ERROR_DELTA);
+    return false;
+  }
+
+  delta.outLen = 0;
+  delta.step = DeltaState::COMMAND;
+  return true;
+}
+
+bool UpdaterClass::_applyDelta(const uint8_t *data, size_t len) {
+  DeltaState &delta = *_delta;
+
+  size_t i = 0;
+  while (i < len) {
+    if (delta.step == DeltaState::HEADER) {
+      size_t n = std::min(len - i, DELTA_HEADER_SIZE - delta.outLen);
+      memcpy(delta.out + delta.outLen, data + i, n);
+      delta.outLen += n;
+      i += n;
+      if (delta.outLen == DELTA_HEADER_SIZE && !_beginDelta()) {
+        return false;
+      }
+      continue;
+    }
+
+    if (delta.step == DeltaState::INSERT) {
+      size_t n = std::min(len - i, (size_t)delta.insertLeft);
+      if (!_deltaOutput(data + i, n)) {
+        return false;
+      }
+      delta.insertLeft -= n;
+      i += n;
+      if (!delta.insertLeft) {
+        delta.step = DeltaState::COMMAND;
+      }
+      continue;
+    }
+
+    uint8_t c = data[i++];
+    if (delta.step == DeltaState::COMMAND) {
+      if (c == 0x00) {
+        delta.step = DeltaState::END;
+      } else if (c == 0x01) {
+        delta.step = DeltaState::COPY_OFFSET;
+      } else if (c == 0x02) {
+        delta.step = DeltaState::INSERT_LENGTH;
+      } else {
+        _setError(UPDATE_ERROR_DELTA);
+        return false;
+      }
+      continue;
+    }
+
+    if (delta.step == DeltaState::END || delta.shift > 28) {
+      // data after the end, or number too large
+      _setError(UPDATE_ERROR_DELTA);
+      return false;
+    }
+
+    delta.number |= (uint32_t)(c & 0x7f) << delta.shift;
+    delta.shift += 7;
+    if (c & 0x80) {
+      continue;
+    }
+    uint32_t number = delta.number;
+    delta.number = 0;
+    delta.shift = 0;
+
+    if (delta.step == DeltaState::COPY_OFFSET) {
+      delta.sourceAddress += (int32_t)((number >> 1) ^ -(number & 1));
+      delta.step = DeltaState::COPY_LENGTH;
+    } else if (delta.step == DeltaState::COPY_LENGTH) {
+      if (!_deltaCopy(delta.sourceAddress, number)) {
+        return false;
+      }
+      delta.sourceAddress += number;
+      delta.step = DeltaState::COMMAND;
+    } else { // INSERT_LENGTH
+      delta.insertLeft = number;
+      delta.step = number ? DeltaState::INSERT : DeltaState::COMMAND;
+    }
+  }
+
+  delta.consumed += len;
+  return true;
+}
+
+bool UpdaterClass::_deltaOutput(const uint8_t *data, size_t len) {
+  DeltaState &delta = *_delta;
+  if (len > delta.targetSize - (_currentAddress - _startAddress) - delta.outLen) {
+    _setError(UPDATE_ERROR_DELTA);
+    return false;
+  }
+
+  while (len) {
+    size_t n = std::min(len, sizeof(delta.out) - delta.outLen);
+    memcpy(delta.out + delta.outLen, data, n);
+    delta.outLen += n;
+    data += n;
+    len -= n;
+    if (delta.outLen == sizeof(delta.out) && !_flushDelta()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool UpdaterClass::_deltaCopy(uint32_t address, size_t len) {
+  // the first 4 bytes (flash mode and size) are never copied
+  if (address < 4 || address > _delta->sourceSize || len > _delta->sourceSize - address) {
+    _setError(UPDATE_ERROR_DELTA);
+    return false;
+  }
+
+  uint32_t window[32];
+  while (len) {
+    // flash is read by aligned words
+    uint32_t aligned = address & ~3;
+    size_t skip = address - aligned;
+    size_t n = std::min(len, sizeof(window) - skip);
+    if (!ESP.flashRead(aligned, window, (skip + n + 3) & ~3)) {
+      _setError(UPDATE_ERROR_READ);
+      return false;
+    }
+    if (!_deltaOutput((const uint8_t *)window + skip, n)) {
+      return false;
+    }
+    address += n;
+    len -= n;
+  }
+  return true;
+}
+
+bool UpdaterClass::_flushDelta() {
+  if (_delta->outLen && !_writeFlash(_delta->out, _delta->outLen)) {
+    return false;
+  }
+  _delta->outLen = 0;
+  return true;
+}
+
+bool UpdaterClass::_endDelta() {
+  if (!_flushDelta()) {
+    return false;
+  }
+  if (_delta->step != DeltaState::END || _currentAddress - _startAddress != _delta->targetSize) {
+#ifdef DEBUG_UPDATER
+    DEBUG_UPDATER.printf_P(PSTR("[delta] incomplete patch, %u of %u bytes\n"), _currentAddress - _startAddress, _delta->targetSize);
+#endif
+    _setError(UPDATE_ERROR_DELTA);
+    return false;
+  }
+
+  // from now on, the update is the new sketch
+  _size = _delta->targetSize;
+  delete _delta;
+  _delta = nullptr;
+  return true;
+}
+
+/*
+  Resumable updates save their progress in the last 128 bytes of the user
+  RTC memory (the first 128 bytes hold the eboot command). It is kept
+  across resets, but not when the power is lost.
+*/
+#ifndef UPDATER_CHECKPOINT_RTC_OFFSET
+#define UPDATER_CHECKPOINT_RTC_OFFSET 96 // in 4 byte blocks
+#endif
+
+#define UPDATER_CHECKPOINT_MAGIC 0x55504431
+
+struct UpdaterCheckpoint {
+  uint32_t magic;
+  uint32_t command;
+  uint32_t size;
+  uint32_t startAddress;
+  uint32_t written;         // whole sectors
+  uint8_t md5[16];          // of the image
+  md5_context_t hash;       // MD5 of what is written
+  uint32_t crc;
+};
+
+static_assert(UPDATER_CHECKPOINT_RTC_OFFSET * 4 + sizeof(UpdaterCheckpoint) <= 512, "checkpoint out of the RTC user memory");
+
+static bool _readCheckpoint(UpdaterCheckpoint &checkpoint, int command) {
+  return ESP.rtcUserMemoryRead(UPDATER_CHECKPOINT_RTC_OFFSET, (uint32_t *)&checkpoint, sizeof(checkpoint))
+      && checkpoint.magic == UPDATER_CHECKPOINT_MAGIC
+      && checkpoint.crc == crc32(&checkpoint, offsetof(UpdaterCheckpoint, crc))
+      && checkpoint.command == (uint32_t)command
+      && checkpoint.written % FLASH_SECTOR_SIZE == 0
+      && checkpoint.written < checkpoint.size;
+}
+
+static bool _parseMD5(const char *hex, uint8_t *md5) {
+  if (!hex || strlen(hex) != 32) {
+    return false;
+  }
+  for (int i = 0; i < 32; i++) {
+    char c = hex[i];
+    uint8_t nibble;
+    if (c >= '0' && c <= '9') nibble = c - '0';
+    else if (c >= 'a' && c <= 'f') nibble = c - 'a' + 10;
+    else if (c >= 'A' && c <= 'F') nibble = c - 'A' + 10;
+    else return false;
+    md5[i / 2] = (i & 1) ? (md5[i / 2] | nibble) : (nibble << 4);
+  }
+  return true;
+}
+
+bool UpdaterClass::beginResumable(size_t size, const char *md5, int command, int ledPin, uint8_t ledOn) {
+  uint8_t imageMD5[16];
+  if (!_parseMD5(md5, imageMD5)) {
+    _setError(UPDATE_ERROR_MD5);
+    return false;
+  }
+  if (!begin(size, command, ledPin, ledOn)) {
+    return false;
+  }
+  setMD5(md5);
+  memcpy(_imageMD5, imageMD5, sizeof(_imageMD5));
+  _resumable = true;
+
+  UpdaterCheckpoint checkpoint;
+  if (_readCheckpoint(checkpoint, command)
+      && checkpoint.size == size
+      && checkpoint.startAddress == _startAddress
+      && !memcmp(checkpoint.md5, imageMD5, sizeof(imageMD5))) {
+    _currentAddress = _startAddress + checkpoint.written;
+    _erasedEnd = _currentAddress;
+    _md5.setContext(checkpoint.hash);
+#ifdef DEBUG_UPDATER
+    DEBUG_UPDATER.printf_P(PSTR("[begin] resuming at %u of %zu\n"), checkpoint.written, size);
+#endif
+  } else {
+    clearResumable();
+  }
+  return true;
+}
+
+size_t UpdaterClass::resumableProgress(String *md5, size_t *size, int command) {
+  UpdaterCheckpoint checkpoint;
+  if (!_readCheckpoint(checkpoint, command)) {
+    return 0;
+  }
+  if (md5) {
+    *md5 = String();
+    for (uint8_t byte : checkpoint.md5) {
+      char digits[3];
+      sprintf(digits, "%02x", byte);
+      *md5 += digits;
+    }
+  }
+  if (size) {
+    *size = checkpoint.size;
+  }
+  return checkpoint.written;
+}
+
+void UpdaterClass::clearResumable() {
+  uint32_t magic = 0;
+  ESP.rtcUserMemoryWrite(UPDATER_CHECKPOINT_RTC_OFFSET, &magic, sizeof(magic));
+}
+
+void UpdaterClass::_saveCheckpoint() {
+  UpdaterCheckpoint checkpoint;
+  checkpoint.magic = UPDATER_CHECKPOINT_MAGIC;
+  checkpoint.command = _command;
+  checkpoint.size = _size;
+  checkpoint.startAddress = _startAddress;
+  checkpoint.written = _currentAddress - _startAddress;
+  memcpy(checkpoint.md5, _imageMD5, sizeof(checkpoint.md5));
+  checkpoint.hash = _md5.getContext();
+  checkpoint.crc = crc32(&checkpoint, offsetof(UpdaterCheckpoint, crc));
+  ESP.rtcUserMemoryWrite(UPDATER_CHECKPOINT_RTC_OFFSET, (uint32_t *)&checkpoint, sizeof(checkpoint));
+}
+
 void UpdaterClass::_setError(int error){
   _error = error;
 #ifdef DEBUG_UPDATER
@@ -567,6 +1075,8 @@ void UpdaterClass::printError(Print &out){
     out.println(F("No data supplied"));
   } else if(_error == UPDATE_ERROR_MD5){
     out.printf_P(PSTR("MD5 Failed: expected:%s, calculated:%s\n"), _target_md5.c_str(), _md5.toString().c_str());
+  } else if(_error == UPDATE_ERROR_DELTA){
+    out.println(F("Delta patch doesn't apply to this sketch"));
   } else if(_error == UPDATE_ERROR_SIGN){
     out.println(F("Signature verification failed"));
   } else if(_error == UPDATE_ERROR_FLASH_CONFIG){
@@ -20,11 +20,15 @@
 #define UPDATE_ERROR_BOOTSTRAP          (11)
 #define UPDATE_ERROR_SIGN               (12)
 #define UPDATE_ERROR_NO_DATA            (13)
+#define UPDATE_ERROR_DELTA              (14)
 
 #define U_FLASH   0
 #define U_FS      100
 #define U_AUTH    200
 
+// First byte of a delta patch against the running sketch (see tools/delta.py)
+#define UPDATE_DELTA_MAGIC 0xD7
+
 #ifdef DEBUG_ESP_UPDATER
 #ifdef DEBUG_ESP_PORT
 #define DEBUG_UPDATER DEBUG_ESP_PORT
@@ -49,6 +53,20 @@ class UpdaterVerifyClass {
     virtual bool verify(UpdaterHashClass *hash, const void *signature, uint32_t signatureLen) = 0; // Verify, return "true" on success
 };
 
+// Where the time of an update went (see UpdaterClass::getStats())
+struct UpdaterStats {
+    uint32_t bytes = 0;              // written to flash
+    uint32_t durationMs = 0;         // from begin() to the last write
+    uint32_t eraseUs = 0;            // erasing sectors
+    uint32_t writeUs = 0;            // writing to flash
+    uint32_t waitUs = 0;             // waiting for data in writeStream()
+    uint16_t sectorsErased = 0;
+    uint16_t sectorsErasedAhead = 0; // while waiting for data
+
+    // bytes per second
+    uint32_t throughput() const { return durationMs ? (uint64_t)bytes * 1000 / durationMs : 0; }
+};
+
 class UpdaterClass {
   public:
     typedef std::function<void(size_t, size_t)> THandlerFunction_Progress;
@@ -65,11 +83,49 @@ class UpdaterClass {
     */
     bool begin(size_t size, int command = U_FLASH, int ledPin = -1, uint8_t ledOn = LOW);
 
+    /*
+      Same as begin(), for an update which can be resumed after an
+      interruption (lost connection, reset): 'md5' (hex string, also set as
+      with setMD5()) identifies the image. Progress is saved in RTC memory
+      after each sector written, and if an update of the same image was
+      interrupted, it is continued: progress() then tells how much of it is
+      already written, and only the rest has to be written.
+      Delta patches can't be resumed.
+    */
+    bool beginResumable(size_t size, const char *md5, int command = U_FLASH, int ledPin = -1, uint8_t ledOn = LOW);
+
+    /*
+      Where an interrupted resumable update can be continued from
+      (0: nothing to resume), with the MD5 and the size of its image
+    */
+    static size_t resumableProgress(String *md5 = nullptr, size_t *size = nullptr, int command = U_FLASH);
+
+    /*
+      Forgets an interrupted resumable update
+    */
+    static void clearResumable();
+
     /*
       Run Updater from asynchronous callbacs
     */
     void runAsync(bool async){ _async = async; }
 
+    /*
+      Pipelined writes: up to 'sectors' flash sectors are erased ahead of
+      the data while waiting for it (in writeStream(), or from idle()),
+      and data is written page by page as soon as it is received, instead
+      of a sector at a time. 0 (default) erases each sector when it is
+      reached. Kept for the next updates.
+    */
+    void setEraseAhead(uint8_t sectors){ _eraseAhead = sectors; }
+
+    /*
+      Call this while waiting for data, with write():
+      erases the next sector ahead when pipelined writes are enabled
+      Returns true when a sector was erased
+    */
+    bool idle();
+
     /*
       Writes a buffer to the flash and increments the address
       Returns the amount written
@@ -122,15 +178,20 @@ class UpdaterClass {
     */
     UpdaterClass& onProgress(THandlerFunction_Progress fn);
 
+    /*
+      Timing of the current (or last) update
+    */
+    const UpdaterStats& getStats(){ return _stats; }
+
     //Helpers
     uint8_t getError(){ return _error; }
     void clearError(){ _error = UPDATE_ERROR_OK; }
     bool hasError(){ return _error != UPDATE_ERROR_OK; }
     bool isRunning(){ return _size > 0; }
-    bool isFinished(){ return _currentAddress == (_startAddress + _size); }
+    bool isFinished(){ return progress() == _size; }
     size_t size(){ return _size; }
-    size_t progress(){ return _currentAddress - _startAddress; }
-    size_t remaining(){ return _size - (_currentAddress - _startAddress); }
+    size_t progress(){ return _delta ? _deltaProgress() : _currentAddress - _startAddress; }
+    size_t remaining(){ return _size - progress(); }
 
     /*
       Template to write from objects that expose
@@ -177,6 +238,20 @@ class UpdaterClass {
   private:
     void _reset();
     bool _writeBuffer();
+    bool _writeFlash(uint8_t *data, size_t len);
+    bool _writePages();
+    void _saveCheckpoint();
+    bool _eraseSector();
+
+    // delta patches: size() and progress() count patch bytes until end()
+    struct DeltaState;
+    bool _beginDelta();
+    bool _applyDelta(const uint8_t *data, size_t len);
+    bool _deltaOutput(const uint8_t *data, size_t len);
+    bool _deltaCopy(uint32_t address, size_t len);
+    bool _flushDelta();
+    bool _endDelta();
+    size_t _deltaProgress();
 
     bool _verifyHeader(uint8_t data);
     bool _verifyEnd();
@@ -192,6 +267,15 @@ class UpdaterClass {
     uint32_t _startAddress = 0;
     uint32_t _currentAddress = 0;
     uint32_t _command = U_FLASH;
+    DeltaState *_delta = nullptr;
+
+    uint8_t _eraseAhead = 0;
+    uint32_t _erasedEnd = 0; // end of the sectors erased for the update
+    UpdaterStats _stats;
+    uint32_t _startMs = 0;
+
+    bool _resumable = false;
+    uint8_t _imageMD5[16]; // identifies a resumable update
 
     String _target_md5;
     MD5Builder _md5;
@@ -24,6 +24,8 @@
 #include "osapi.h"
 #include "user_interface.h"
 #include "cont.h"
+#include "Schedule.h"
+#include "coredecls.h"
 
 extern "C" {
 
@@ -44,16 +46,31 @@ void delay_end(void* arg) {
 }
 
 void __delay(unsigned long ms) {
-    if(ms) {
-        os_timer_setfn(&delay_timer, (os_timer_func_t*) &delay_end, 0);
-        os_timer_arm(&delay_timer, ms, ONCE);
-    } else {
-        esp_schedule();
-    }
-    esp_yield();
-    if(ms) {
-        os_timer_disarm(&delay_timer);
-    }
+    // The sleep is cut at the next recurrent scheduled function deadline:
+    // they are run when cont resumes (in esp_yield()), then sleep goes on.
+    // The same applies when cont is resumed early by esp_schedule().
+    // Out of cont (not allowed), esp_yield() returns at once, and so does
+    // delay().
+    const uint32_t start = millis();
+    uint32_t elapsed = 0;
+    do {
+        uint32_t sleep = ms - elapsed;
+        const uint32_t recurrent_us = get_scheduled_recurrent_delay_us();
+        const uint32_t recurrent_ms = recurrent_us / 1000 + (recurrent_us % 1000 != 0);
+        if (recurrent_ms < sleep) {
+            sleep = recurrent_ms;
+        }
+        if(sleep) {
+            os_timer_setfn(&delay_timer, (os_timer_func_t*) &delay_end, 0);
+            os_timer_arm(&delay_timer, sleep, ONCE);
+        } else {
+            esp_schedule();
+        }
+        esp_yield();
+        if(sleep) {
+            os_timer_disarm(&delay_timer);
+        }
+    } while (can_yield() && (elapsed = millis() - start) < ms);
 }
 
 void delay(unsigned long ms) __attribute__ ((weak, alias("__delay"))); 
@@ -23,6 +23,11 @@ void __real_system_restart_local() __attribute__((noreturn));
 
 uint32_t sqrt32 (uint32_t n);
 uint32_t crc32 (const void* data, size_t length, uint32_t crc = 0xffffffff);
+// crc32() is one of these (see crc32.cpp), they give the same results
+uint32_t crc32_bitwise (const void* data, size_t length, uint32_t crc);
+uint32_t crc32_slice1 (const void* data, size_t length, uint32_t crc);
+uint32_t crc32_slice4 (const void* data, size_t length, uint32_t crc);
+uint32_t crc32_slice8 (const void* data, size_t length, uint32_t crc);
 
 #ifdef __cplusplus
 }
@@ -22,8 +22,116 @@
 #include "coredecls.h"
 #include "pgmspace.h"
 
+/*
+  CRC-32 with the polynomial 0x04c11db7, most significant bit first, no
+  final xor (as checked by eboot and elf2bin.py).
+
+  crc32() uses CRC32_SLICES lookup tables of 1KB each, reading the data by
+  aligned 32 bit words when there are 4 or 8 (the tables are then indexed
+  with the bytes of the word, without swapping them: little endian only):
+    0: no table, bit by bit
+    1: one byte at a time
+    4: one word at a time (default)
+    8: two words at a time
+  The tables are in flash, or in RAM with CRC32_TABLES_IN_RAM (faster
+  while the flash cache is busy with code, but it costs the heap as much).
+  Data can be anywhere, including in flash.
+*/
+
+#ifndef CRC32_SLICES
+#define CRC32_SLICES 4
+#endif
+
+#ifdef CRC32_TABLES_IN_RAM
+#define CRC32_TABLE_ATTR
+#else
+#define CRC32_TABLE_ATTR PROGMEM
+#endif
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "crc32() reads words as little endian");
+
+namespace
+{
+
+// table[k][i]: crc of the byte i followed by k null bytes
+template <size_t slices>
+struct Crc32Tables
+{
+    uint32_t table[slices][256];
+
+    constexpr Crc32Tables(): table()
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t crc = i << 24;
+            for (int bit = 0; bit < 8; bit++)
+                crc = (crc << 1) ^ ((crc & 0x80000000) ? 0x04c11db7 : 0);
+            table[0][i] = crc;
+        }
+        for (size_t k = 1; k < slices; k++)
+            for (uint32_t i = 0; i < 256; i++)
+                table[k][i] = (table[k - 1][i] << 8) ^ table[0][table[k - 1][i] >> 24];
+    }
+};
+
+constexpr Crc32Tables<1> tables1 CRC32_TABLE_ATTR;
+constexpr Crc32Tables<4> tables4 CRC32_TABLE_ATTR;
+constexpr Crc32Tables<8> tables8 CRC32_TABLE_ATTR;
+
+inline uint32_t lookup(const uint32_t* table, uint32_t index)
+{
+    return pgm_read_dword(table + (index & 0xff));
+}
+
+template <size_t slices>
+inline uint32_t crc32Bytes(const Crc32Tables<slices>& t, const uint8_t*& data, size_t length, uint32_t crc)
+{
+    while (length--)
+        crc = (crc << 8) ^ lookup(t.table[0], (crc >> 24) ^ pgm_read_byte(data++));
+    return crc;
+}
+
+// bytes until 'data' is aligned, then words, then the remaining bytes
+template <size_t slices>
+uint32_t crc32Words(const Crc32Tables<slices>& t, const void* data, size_t length, uint32_t crc)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    size_t head = (-(uintptr_t)bytes) & 3;
+    if (head > length)
+        head = length;
+    crc = crc32Bytes(t, bytes, head, crc);
+    length -= head;
+
+    constexpr size_t step = slices / 4 * sizeof(uint32_t);
+    const uint32_t* words = (const uint32_t*)bytes;
+    for (; length >= step; length -= step)
+    {
+        // crc ^= the first 4 bytes, most significant first
+        uint32_t word = pgm_read_dword(words++);
+        uint32_t next = 0;
+        if constexpr (slices == 8)
+        {
+            next = lookup(t.table[3], pgm_read_dword(words)) ^
+                   lookup(t.table[2], pgm_read_dword(words) >> 8) ^
+                   lookup(t.table[1], pgm_read_dword(words) >> 16) ^
+                   lookup(t.table[0], pgm_read_dword(words) >> 24);
+            words++;
+        }
+        crc = lookup(t.table[slices - 1], (crc >> 24) ^ word) ^
+              lookup(t.table[slices - 2], (crc >> 16) ^ (word >> 8)) ^
+              lookup(t.table[slices - 3], (crc >> 8) ^ (word >> 16)) ^
+              lookup(t.table[slices - 4], crc ^ (word >> 24)) ^
+              next;
+    }
+
+    bytes = (const uint8_t*)words;
+    return crc32Bytes(t, bytes, length, crc);
+}
+
+} // namespace
+
 // moved from core_esp8266_eboot_command.cpp
-uint32_t crc32 (const void* data, size_t length, uint32_t crc /*= 0xffffffff*/)
+uint32_t crc32_bitwise (const void* data, size_t length, uint32_t crc)
 {
     const uint8_t* ldata = (const uint8_t*)data;
     while (length--)
@@ -41,3 +149,34 @@ uint32_t crc32 (const void* data, size_t length, uint32_t crc /*= 0xffffffff*/)
     }
     return crc;
 }
+
+uint32_t crc32_slice1 (const void* data, size_t length, uint32_t crc)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    return crc32Bytes(tables1, bytes, length, crc);
+}
+
+uint32_t crc32_slice4 (const void* data, size_t length, uint32_t crc)
+{
+    return crc32Words(tables4, data, length, crc);
+}
+
+uint32_t crc32_slice8 (const void* data, size_t length, uint32_t crc)
+{
+    return crc32Words(tables8, data, length, crc);
+}
+
+uint32_t crc32 (const void* data, size_t length, uint32_t crc /*= 0xffffffff*/)
+{
+#if CRC32_SLICES == 0
+    return crc32_bitwise(data, length, crc);
+#elif CRC32_SLICES == 1
+    return crc32_slice1(data, length, crc);
+#elif CRC32_SLICES == 4
+    return crc32_slice4(data, length, crc);
+#elif CRC32_SLICES == 8
+    return crc32_slice8(data, length, crc);
+#else
+#error CRC32_SLICES must be 0, 1, 4 or 8
+#endif
+}
@@ -42,12 +42,14 @@ namespace esp8266webserver {
 template <typename ServerType>
 ESP8266WebServerTemplate<ServerType>::ESP8266WebServerTemplate(IPAddress addr, int port)
 : _server(addr, port)
+, _slots(WEBSERVER_MAX_CLIENTS)
 {
 }
 
 template <typename ServerType>
 ESP8266WebServerTemplate<ServerType>::ESP8266WebServerTemplate(int port)
 : _server(port)
+, _slots(WEBSERVER_MAX_CLIENTS)
 {
 }
 
@@ -252,6 +254,7 @@ void ESP8266WebServerTemplate<ServerType>::_addRequestHandler(RequestHandlerType
       _lastHandler->next(handler);
       _lastHandler = handler;
     }
+    _routes.invalidate();
 }
 
 template <typename ServerType>
@@ -271,43 +274,132 @@ void ESP8266WebServerTemplate<ServerType>::serveStatic(const char* uri, FS& fs,
 }
 
 template <typename ServerType>
-void ESP8266WebServerTemplate<ServerType>::handleClient() {
-  if (_currentStatus == HC_NONE) {
-    ClientType client = _server.available();
-    if (!client) {
-      return;
+void ESP8266WebServerTemplate<ServerType>::maxClients(size_t count) {
+  if (count < 1)
+    count = 1;
+  for (size_t i = count; i < _slots.size(); i++)
+    _dropSlot(_slots[i]);
+  _slots.resize(count);
+  _nextSlot = 0;
+}
+
+template <typename ServerType>
+bool ESP8266WebServerTemplate<ServerType>::_acceptClient() {
+  // Find a free slot, or else the connection idle for the longest time
+  // if another client is waiting
+  ClientSlot* slot = nullptr;
+  for (ClientSlot& s: _slots)
+    if (s.status == HC_NONE) {
+      slot = &s;
+      break;
     }
+  if (!slot) {
+    if (!_server.hasClient())
+      return false;
+    for (ClientSlot& s: _slots)
+      if (s.status == HC_WAIT_CLOSE && !s.client.available() && (!slot || (long)(s.statusChange - slot->statusChange) < 0))
+        slot = &s;
+    if (!slot)
+      return false;
+    DBGWS("webserver: closing idle client for a new one\n");
+    _dropSlot(*slot);
+  }
+
+  ClientType client = _server.available();
+  if (!client) {
+    return false;
+  }
 
-    DBGWS("New client\n");
+  DBGWS("New client\n");
+
+  slot->client = client;
+  slot->status = HC_WAIT_READ;
+  slot->statusChange = millis();
+  return true;
+}
+
+template <typename ServerType>
+void ESP8266WebServerTemplate<ServerType>::_dropSlot(ClientSlot& slot) {
+  DBGWS("Drop client\n");
+  slot.client = ClientType();
+  slot.status = HC_NONE;
+  slot.keepAlive = false;
+  _resetHead(slot);
+  slot.head = String(); // buffer is only kept while the client is connected
+}
+
+template <typename ServerType>
+void ESP8266WebServerTemplate<ServerType>::handleClient() {
+  while (_acceptClient());
 
-    _currentClient = client;
-    _currentStatus = HC_WAIT_READ;
-    _statusChange = millis();
+  // Serve connections in turn, at most one request from each of them,
+  // starting from a different one at each call
+  bool callYield = false;
+  size_t count = _slots.size();
+  size_t first = _nextSlot;
+  _nextSlot = (_nextSlot + 1) % count;
+  for (size_t i = 0; i < count; i++) {
+    ClientSlot& slot = _slots[(first + i) % count];
+    if (slot.status != HC_NONE && _handleSlot(slot))
+      callYield = true;
+  }
+
+  if (callYield) {
+    yield();
   }
+}
 
+template <typename ServerType>
+bool ESP8266WebServerTemplate<ServerType>::_handleSlot(ClientSlot& slot) {
   bool keepCurrentClient = false;
   bool callYield = false;
 
   DBGWS("http-server loop: conn=%d avail=%d status=%s\n",
-    _currentClient.connected(), _currentClient.available(),
-    _currentStatus==HC_NONE?"none":
-    _currentStatus==HC_WAIT_READ?"wait-read":
-    _currentStatus==HC_WAIT_CLOSE?"wait-close":
+    slot.client.connected(), slot.client.available(),
+    slot.status==HC_NONE?"none":
+    slot.status==HC_WAIT_READ?"wait-read":
+    slot.status==HC_WAIT_CLOSE?"wait-close":
     "??");
 
-  if (_currentClient.connected() || _currentClient.available()) {
-    if (_currentClient.available() && _keepAlive) {
-      _currentStatus = HC_WAIT_READ;
+  if (slot.client.connected() || slot.client.available()) {
+    if (slot.client.available() && slot.keepAlive) {
+      slot.status = HC_WAIT_READ;
     }
 
-    switch (_currentStatus) {
+    ClientFuture whatNow = CLIENT_REQUEST_CAN_CONTINUE;
+    switch (slot.status) {
     case HC_NONE:
       // No-op to avoid C++ compiler warning
       break;
     case HC_WAIT_READ:
-      // Wait for data from client to become available
-      if (_currentClient.available()) {
-        switch (_parseRequest(_currentClient))
+      // Wait for the whole request head (request line and headers),
+      // data are collected as they arrive, without blocking
+      if (slot.client.available() && !_readHead(slot)) {
+        DBGWS("webserver: request head is too large\n");
+        slot.client.stop();
+        break;
+      }
+      if (_hook && !slot.hooked && slot.headEol == 2) {
+        // Hooks are called with the request line, before headers are read
+        slot.hooked = true;
+        _currentClient = slot.client;
+        whatNow = _callHook(_currentClient, slot.head);
+        _currentClient = ClientType();
+        if (   whatNow == CLIENT_REQUEST_CAN_CONTINUE
+            && slot.client.available() && !_readHead(slot)) {
+          DBGWS("webserver: request head is too large\n");
+          slot.client.stop();
+          break;
+        }
+      }
+      if (whatNow != CLIENT_REQUEST_CAN_CONTINUE || slot.headEol == 4) {
+        // A pipelined request following this one is left in the client's
+        // buffer, it will be processed on next turn
+        _currentClient = slot.client;
+        if (whatNow == CLIENT_REQUEST_CAN_CONTINUE)
+          whatNow = _parseRequest(_currentClient, slot.head);
+        _resetHead(slot);
+        switch (whatNow)
         {
         case CLIENT_REQUEST_CAN_CONTINUE:
           _currentClient.setTimeout(HTTP_MAX_SEND_WAIT);
@@ -316,8 +408,9 @@ void ESP8266WebServerTemplate<ServerType>::handleClient() {
           /* fallthrough */
         case CLIENT_REQUEST_IS_HANDLED:
           if (_currentClient.connected() || _currentClient.available()) {
-            _currentStatus = HC_WAIT_CLOSE;
-            _statusChange = millis();
+            slot.status = HC_WAIT_CLOSE;
+            slot.statusChange = millis();
+            slot.keepAlive = _keepAlive;
             keepCurrentClient = true;
           }
           else
@@ -333,9 +426,10 @@ void ESP8266WebServerTemplate<ServerType>::handleClient() {
           DBGWS("Give client\n");
           break;
         } // switch _parseRequest()
+        _currentClient = ClientType();
       } else {
-        // !_currentClient.available(): waiting for more data
-        if (millis() - _statusChange <= HTTP_MAX_DATA_WAIT) {
+        // request head is incomplete: waiting for more data
+        if (millis() - slot.statusChange <= HTTP_MAX_DATA_WAIT) {
           keepCurrentClient = true;
         }
         else
@@ -344,34 +438,31 @@ void ESP8266WebServerTemplate<ServerType>::handleClient() {
       }
       break;
     case HC_WAIT_CLOSE:
-      // Wait for client to close the connection
-      if (!_server.hasClient() && (millis() - _statusChange <= HTTP_MAX_CLOSE_WAIT)) {
+      // Wait for client to close the connection or to send another request
+      if (millis() - slot.statusChange <= HTTP_MAX_CLOSE_WAIT) {
         keepCurrentClient = true;
         callYield = true;
-        if (_currentClient.available())
+        if (slot.client.available())
             // continue serving current client
-            _currentStatus = HC_WAIT_READ;
+            slot.status = HC_WAIT_READ;
       }
       break;
-    } // switch _currentStatus
+    } // switch slot.status
   }
 
   if (!keepCurrentClient) {
-    DBGWS("Drop client\n");
-    _currentClient = ClientType();
-    _currentStatus = HC_NONE;
+    _dropSlot(slot);
     _currentUpload.reset();
   }
 
-  if (callYield) {
-    yield();
-  }
+  return callYield;
 }
 
 template <typename ServerType>
 void ESP8266WebServerTemplate<ServerType>::close() {
   _server.close();
-  _currentStatus = HC_NONE;
+  for (ClientSlot& slot: _slots)
+    _dropSlot(slot);
   if(!_headerKeysCount)
     collectHeaders();
 }
@@ -428,8 +519,11 @@ void ESP8266WebServerTemplate<ServerType>::_prepareHeader(String& response, int
       sendHeader(String(F("Access-Control-Allow-Origin")), String("*"));
     }
 
-    if (_keepAlive && _server.hasClient()) { // Disable keep alive if another client is waiting.
-      _keepAlive = false;
+    if (_keepAlive && _server.hasClient()) { // Disable keep alive if another client is waiting
+      bool freeSlot = false;               // and no slot is available for it.
+      for (const ClientSlot& slot: _slots)
+        freeSlot |= slot.status == HC_NONE;
+      _keepAlive = freeSlot;
     }
     sendHeader(String(F("Connection")), String(_keepAlive ? F("keep-alive") : F("close")));
     if (_keepAlive) {
@@ -27,6 +27,7 @@
 #include <functional>
 #include <memory>
 #include <functional>
+#include <vector>
 #include <ESP8266WiFi.h>
 #include <FS.h>
 #include "detail/mimetable.h"
@@ -58,6 +59,14 @@ enum HTTPAuthMethod { BASIC_AUTH, DIGEST_AUTH };
 #define HTTP_UPLOAD_BUFLEN 2048
 #endif
 
+#ifndef WEBSERVER_MAX_CLIENTS
+#define WEBSERVER_MAX_CLIENTS 4 // default number of connections served concurrently
+#endif
+
+#ifndef WEBSERVER_MAX_HEAD_LENGTH
+#define WEBSERVER_MAX_HEAD_LENGTH 4096 // request line and headers
+#endif
+
 #define HTTP_MAX_DATA_WAIT 5000 //ms to wait for the client to send the request
 #define HTTP_MAX_POST_WAIT 5000 //ms to wait for POST data to arrive
 #define HTTP_MAX_SEND_WAIT 5000 //ms to wait for data chunk to be ACKed
@@ -85,6 +94,7 @@ class ESP8266WebServerTemplate;
 }
 
 #include "detail/RequestHandler.h"
+#include "detail/RouteTable.h"
 
 namespace esp8266webserver {
 
@@ -209,6 +219,14 @@ public:
   void keepAlive(bool keepAlive) { _keepAlive = keepAlive; }
   bool keepAlive() { return _keepAlive; }
 
+  // Number of connections served concurrently (default WEBSERVER_MAX_CLIENTS).
+  // Requests from these connections are handled in turn by handleClient(),
+  // one request per connection and per call.  Idle keep-alive connections
+  // are closed when a new client is waiting and all slots are in use.
+  // To be called before begin().
+  void maxClients(size_t count);
+  size_t maxClients() const { return _slots.size(); }
+
   static String credentialHash(const String& username, const String& realm, const String& password);
 
   static String urlDecode(const String& text);
@@ -257,6 +275,8 @@ public:
 
   static String responseCodeToString(const int code);
 
+  // Hooks are called as soon as the request line is received, before the
+  // headers are read: the rest of the request can be read from the client.
   void addHook (HookFunction hook) {
     if (_hook) {
       auto previousHook = _hook;
@@ -275,7 +295,15 @@ protected:
   void _addRequestHandler(RequestHandlerType* handler);
   void _handleRequest();
   void _finalizeResponse();
-  ClientFuture _parseRequest(ClientType& client);
+  struct ClientSlot;
+  bool _acceptClient();
+  bool _handleSlot(ClientSlot& slot);
+  void _dropSlot(ClientSlot& slot);
+  bool _readHead(ClientSlot& slot);
+  void _resetHead(ClientSlot& slot);
+  ClientFuture _callHook(ClientType& client, const String& head);
+  ClientFuture _parseRequest(ClientType& client, const String& head);
+  ClientFuture _badRequest();
   void _parseArguments(const String& data);
   int _parseArgumentsPrivate(const String& data, std::function<void(String&,String&,const String&,int,int,int,int)> handler);
   bool _parseForm(ClientType& client, const String& boundary, uint32_t len);
@@ -284,6 +312,7 @@ protected:
   int _uploadReadByte(ClientType& client);
   void _prepareHeader(String& response, int code, const char* content_type, size_t contentLength);
   bool _collectHeader(const char* headerName, const char* headerValue);
+  bool _collectHeader(const char* headerName, size_t nameLen, const char* headerValue, size_t valueLen);
 
   void _streamFileCore(const size_t fileSize, const String & fileName, const String & contentType);
 
@@ -296,17 +325,29 @@ protected:
     String value;
   };
 
+  // per-connection state, requests themselves are handled one at a time
+  struct ClientSlot {
+    ClientType client;
+    HTTPClientStatus status = HC_NONE;
+    unsigned long statusChange = 0;
+    String  head;          // request head being received
+    uint8_t headEol = 0;   // progress in "\r\n\r\n" ending the head
+    bool    hooked = false; // hooks have run for the request line in head
+    bool    keepAlive = false;
+  };
+
   ServerType  _server;
-  ClientType  _currentClient;
+  ClientType  _currentClient; // connection of the request being handled
   HTTPMethod  _currentMethod = HTTP_ANY;
   String      _currentUri;
   uint8_t     _currentVersion = 0;
-  HTTPClientStatus _currentStatus = HC_NONE;
-  unsigned long _statusChange = 0;
+  std::vector<ClientSlot> _slots;
+  size_t      _nextSlot = 0;
 
   RequestHandlerType*  _currentHandler = nullptr;
   RequestHandlerType*  _firstHandler = nullptr;
   RequestHandlerType*  _lastHandler = nullptr;
+  RouteTable<ServerType> _routes;
   THandlerFunction _notFoundHandler;
   THandlerFunction _fileUploadHandler;
 
@@ -42,11 +42,102 @@ static bool readBytesWithTimeout(typename ServerType::ClientType& client, size_t
 }
 
 template <typename ServerType>
-typename ESP8266WebServerTemplate<ServerType>::ClientFuture ESP8266WebServerTemplate<ServerType>::_parseRequest(ClientType& client) {
-  // Read the first line of HTTP request
-  String req = client.readStringUntil('\r');
-  DBGWS("request: %s\n", req.c_str());
-  client.readStringUntil('\n');
+bool ESP8266WebServerTemplate<ServerType>::_readHead(ClientSlot& slot) {
+  // Collect available data up to the empty line ending the request head,
+  // without waiting.  Following data (body, next request) are left unread.
+  // With hooks, reading stops after the request line until they have run.
+  static const char eoh[] = "\r\n\r\n";
+  ClientType& client = slot.client;
+  String& head = slot.head;
+  uint8_t& headEol = slot.headEol;
+  const uint8_t end = (_hook && !slot.hooked)? 2: 4;
+  while (headEol < end && client.available()) {
+    if (client.hasPeekBufferAPI()) {
+      const char* data = client.peekBuffer();
+      size_t avail = client.peekAvailable();
+      size_t len = 0;
+      while (len < avail && headEol < end) {
+        char c = data[len++];
+        headEol = c == eoh[headEol]? headEol + 1: (c == '\r'? 1: 0);
+      }
+      if (head.length() + len > WEBSERVER_MAX_HEAD_LENGTH)
+        return false;
+      head.concat(data, len);
+      client.peekConsume(len);
+    } else {
+      int c = client.read();
+      if (c < 0)
+        break;
+      if (head.length() == WEBSERVER_MAX_HEAD_LENGTH)
+        return false;
+      headEol = c == eoh[headEol]? headEol + 1: (c == '\r'? 1: 0);
+      head += (char)c;
+    }
+  }
+  return true;
+}
+
+template <typename ServerType>
+void ESP8266WebServerTemplate<ServerType>::_resetHead(ClientSlot& slot) {
+  slot.head.clear(); // buffer is kept for the next request of this client
+  slot.headEol = 0;
+  slot.hooked = false;
+}
+
+template <typename ServerType>
+typename ESP8266WebServerTemplate<ServerType>::ClientFuture ESP8266WebServerTemplate<ServerType>::_callHook(ClientType& client, const String& head) {
+  // head only holds the request line: hooks can read the headers and
+  // the content from the client
+  int addr_start = head.indexOf(' ');
+  int addr_end = head.indexOf(' ', addr_start + 1);
+  if (addr_start == -1 || addr_end == -1) {
+    return CLIENT_REQUEST_CAN_CONTINUE; // rejected by _parseRequest()
+  }
+  int search = head.indexOf('?', addr_start + 1);
+  String methodStr = head.substring(0, addr_start);
+  String url = head.substring(addr_start + 1, (search != -1 && search < addr_end)? search: addr_end);
+  _currentUri = url;
+  return _hook(methodStr, url, &client, mime::getContentType);
+}
+
+// End of the line starting at line, nullptr if there is no CRLF before end
+static inline const char* findLineEnd(const char* line, const char* end)
+{
+  const char* cr;
+  while ((cr = (const char*)memchr(line, '\r', end - line)) && cr + 1 < end) {
+    if (cr[1] == '\n')
+      return cr;
+    line = cr + 1;
+  }
+  return nullptr;
+}
+
+template <typename ServerType>
+typename ESP8266WebServerTemplate<ServerType>::ClientFuture ESP8266WebServerTemplate<ServerType>::_badRequest() {
+  // Answered as HTTP/1.0, the connection is closed
+  using namespace mime;
+  _currentVersion = 0;
+  _keepAlive = false;
+  _chunked = false;
+  _contentLength = CONTENT_LENGTH_NOT_SET;
+  send(400, FPSTR(mimeTable[txt].mimeType), String(F("Bad Request")));
+  return CLIENT_MUST_STOP;
+}
+
+template <typename ServerType>
+typename ESP8266WebServerTemplate<ServerType>::ClientFuture ESP8266WebServerTemplate<ServerType>::_parseRequest(ClientType& client, const String& head) {
+  // Request head is complete in head (see _readHead()), it is parsed in
+  // place.  It comes from the network: a NUL byte is rejected, and all
+  // searches are bounded by its end.
+  const char* line = head.c_str();
+  const char* headEnd = line + head.length();
+  const char* lineEnd = findLineEnd(line, headEnd);
+  if (!lineEnd || memchr(line, 0, head.length())) {
+    DBGWS("Invalid request\n");
+    return _badRequest();
+  }
+  DBGWS("request: %.*s\n", (int)(lineEnd - line), line);
+
   //reset header value
   for (int i = 0; i < _headerKeysCount; ++i) {
     _currentHeaders[i].value.clear();
@@ -54,45 +145,41 @@ typename ESP8266WebServerTemplate<ServerType>::ClientFuture ESP8266WebServerTemp
 
   // First line of HTTP request looks like "GET /path HTTP/1.1"
   // Retrieve the "/path" part by finding the spaces
-  int addr_start = req.indexOf(' ');
-  int addr_end = req.indexOf(' ', addr_start + 1);
-  if (addr_start == -1 || addr_end == -1) {
+  const char* addr_start = (const char*)memchr(line, ' ', lineEnd - line);
+  const char* addr_end = addr_start? (const char*)memchr(addr_start + 1, ' ', lineEnd - addr_start - 1): nullptr;
+  if (!addr_end) {
     DBGWS("Invalid request\n");
-    return CLIENT_MUST_STOP;
+    return _badRequest();
   }
 
-  String methodStr = req.substring(0, addr_start);
-  String url = req.substring(addr_start + 1, addr_end);
-  String versionEnd = req.substring(addr_end + 8);
-  _currentVersion = atoi(versionEnd.c_str());
+  const char* version = addr_end + 1;
+  _currentVersion = (lineEnd - version > 7)? atoi(version + 7): 0;
+  const char* search = (const char*)memchr(addr_start + 1, '?', addr_end - addr_start - 1);
+  const char* pathEnd = search? search: addr_end;
   String searchStr;
-  int hasSearch = url.indexOf('?');
-  if (hasSearch != -1){
-    searchStr = url.substring(hasSearch + 1);
-    url = url.substring(0, hasSearch);
-  }
+  if (search)
+    searchStr.concat(search + 1, addr_end - search - 1);
+  String url;
+  url.concat(addr_start + 1, pathEnd - addr_start - 1);
   _currentUri = url;
   _chunked = false;
 
-  if (_hook)
-  {
-    auto whatNow = _hook(methodStr, url, &client, mime::getContentType);
-    if (whatNow != CLIENT_REQUEST_CAN_CONTINUE)
-        return whatNow;
-  }
-
+  auto isMethod = [line, addr_start](PGM_P name) {
+    size_t len = strlen_P(name);
+    return (size_t)(addr_start - line) == len && strncmp_P(line, name, len) == 0;
+  };
   HTTPMethod method = HTTP_GET;
-  if (methodStr == F("HEAD")) {
+  if (isMethod(PSTR("HEAD"))) {
     method = HTTP_HEAD;
-  } else if (methodStr == F("POST")) {
+  } else if (isMethod(PSTR("POST"))) {
     method = HTTP_POST;
-  } else if (methodStr == F("DELETE")) {
+  } else if (isMethod(PSTR("DELETE"))) {
     method = HTTP_DELETE;
-  } else if (methodStr == F("OPTIONS")) {
+  } else if (isMethod(PSTR("OPTIONS"))) {
     method = HTTP_OPTIONS;
-  } else if (methodStr == F("PUT")) {
+  } else if (isMethod(PSTR("PUT"))) {
     method = HTTP_PUT;
-  } else if (methodStr == F("PATCH")) {
+  } else if (isMethod(PSTR("PATCH"))) {
     method = HTTP_PATCH;
   }
   _currentMethod = method;
@@ -100,62 +187,75 @@ typename ESP8266WebServerTemplate<ServerType>::ClientFuture ESP8266WebServerTemp
   _keepAlive = _currentVersion > 0; // Keep the connection alive by default
                                     // if the protocol version is greater than HTTP 1.0
 
-  DBGWS("method: %s url: %s search: %s keepAlive=: %d\n",
-      methodStr.c_str(), url.c_str(), searchStr.c_str(), _keepAlive);
-
-  //attach handler
-  RequestHandlerType* handler;
-  for (handler = _firstHandler; handler; handler = handler->next()) {
-    if (handler->canHandle(_currentMethod, _currentUri))
+  DBGWS("method: %d url: %s search: %s keepAlive=: %d\n",
+      method, url.c_str(), searchStr.c_str(), _keepAlive);
+
+  //parse headers, only collected ones are copied
+  String boundaryStr;
+  bool isForm = false;
+  bool isEncoded = false;
+  uint32_t contentLength = 0;
+  _hostHeader.clear();
+  for (line = lineEnd + 2; line < headEnd; line = lineEnd + 2) {
+    lineEnd = findLineEnd(line, headEnd);
+    if (!lineEnd) {
+      DBGWS("Invalid header\n");
+      return _badRequest();
+    }
+    if (lineEnd == line) break; //no more headers
+    const char* headerDiv = (const char*)memchr(line, ':', lineEnd - line);
+    if (!headerDiv){
       break;
+    }
+    size_t nameLen = headerDiv - line;
+    const char* value = headerDiv + 1;
+    const char* valueEnd = lineEnd;
+    while (value < valueEnd && isspace(*value))
+      value++;
+    while (valueEnd > value && isspace(valueEnd[-1]))
+      valueEnd--;
+    size_t valueLen = valueEnd - value;
+    auto isHeader = [line, nameLen](PGM_P name) {
+      return strlen_P(name) == nameLen && strncasecmp_P(line, name, nameLen) == 0;
+    };
+    auto valueStartsWith = [value, valueLen](PGM_P prefix) {
+      size_t len = strlen_P(prefix);
+      return valueLen >= len && strncmp_P(value, prefix, len) == 0;
+    };
+    _collectHeader(line, nameLen, value, valueLen);
+
+    DBGWS("headerName: %.*s\nheaderValue: %.*s\n", (int)nameLen, line, (int)valueLen, value);
+
+    if (isHeader(Content_Type)){
+      using namespace mime;
+      if (valueStartsWith(mimeTable[txt].mimeType)){
+        isForm = false;
+      } else if (valueStartsWith(PSTR("application/x-www-form-urlencoded"))){
+        isForm = false;
+        isEncoded = true;
+      } else if (valueStartsWith(PSTR("multipart/"))){
+        const char* equal = (const char*)memchr(value, '=', valueLen);
+        boundaryStr.clear();
+        if (equal)
+          boundaryStr.concat(equal + 1, valueEnd - equal - 1);
+        boundaryStr.replace("\"","");
+        isForm = true;
+      }
+    } else if (isHeader(PSTR("Content-Length"))){
+      contentLength = atoi(value);
+    } else if (isHeader(PSTR("Host"))){
+      _hostHeader.clear();
+      _hostHeader.concat(value, valueLen);
+    } else if (isHeader(PSTR("Connection"))){
+      _keepAlive = valueLen == 10 && strncasecmp_P(value, PSTR("keep-alive"), valueLen) == 0;
+    }
   }
-  _currentHandler = handler;
 
-  String formData;
+  //attach handler
+  _currentHandler = _routes.find(_firstHandler, _currentMethod, _currentUri);
+
   // below is needed only when POST type request
   if (method == HTTP_POST || method == HTTP_PUT || method == HTTP_PATCH || method == HTTP_DELETE){
-    String boundaryStr;
-    String headerName;
-    String headerValue;
-    bool isForm = false;
-    bool isEncoded = false;
-    uint32_t contentLength = 0;
-    //parse headers
-    while(1){
-      req = client.readStringUntil('\r');
-      client.readStringUntil('\n');
-      if (req.isEmpty()) break; //no more headers
-      int headerDiv = req.indexOf(':');
-      if (headerDiv == -1){
-        break;
-      }
-      headerName = req.substring(0, headerDiv);
-      headerValue = req.substring(headerDiv + 1);
-      headerValue.trim();
-       _collectHeader(headerName.c_str(),headerValue.c_str());
-
-      DBGWS("headerName: %s\nheaderValue: %s\n", headerName.c_str(), headerValue.c_str());
-
-      if (headerName.equalsIgnoreCase(FPSTR(Content_Type))){
-        using namespace mime;
-        if (headerValue.startsWith(FPSTR(mimeTable[txt].mimeType))){
-          isForm = false;
-        } else if (headerValue.startsWith(F("application/x-www-form-urlencoded"))){
-          isForm = false;
-          isEncoded = true;
-        } else if (headerValue.startsWith(F("multipart/"))){
-          boundaryStr = headerValue.substring(headerValue.indexOf('=') + 1);
-          boundaryStr.replace("\"","");
-          isForm = true;
-        }
-      } else if (headerName.equalsIgnoreCase(F("Content-Length"))){
-        contentLength = headerValue.toInt();
-      } else if (headerName.equalsIgnoreCase(F("Host"))){
-        _hostHeader = headerValue;
-      } else if (headerName.equalsIgnoreCase(F("Connection"))){
-        _keepAlive = headerValue.equalsIgnoreCase(F("keep-alive"));
-      }
-    }
 
     String plainBuf;
     if (   !isForm
@@ -194,29 +294,6 @@ typename ESP8266WebServerTemplate<ServerType>::ClientFuture ESP8266WebServerTemp
       }
     }
   } else {
-    String headerName;
-    String headerValue;
-    //parse headers
-    while(1){
-      req = client.readStringUntil('\r');
-      client.readStringUntil('\n');
-      if (req.isEmpty()) break;//no moar headers
-      int headerDiv = req.indexOf(':');
-      if (headerDiv == -1){
-        break;
-      }
-      headerName = req.substring(0, headerDiv);
-      headerValue = req.substring(headerDiv + 2);
-      _collectHeader(headerName.c_str(),headerValue.c_str());
-
-      DBGWS("headerName: %s\nheaderValue: %s\n", headerName.c_str(), headerValue.c_str());
-
-      if (headerName.equalsIgnoreCase(F("Host"))){
-        _hostHeader = headerValue;
-      } else if (headerName.equalsIgnoreCase(F("Connection"))){
-        _keepAlive = headerValue.equalsIgnoreCase(F("keep-alive"));
-      }
-    }
     _parseArguments(searchStr);
   }
   client.flush();
@@ -235,9 +312,17 @@ typename ESP8266WebServerTemplate<ServerType>::ClientFuture ESP8266WebServerTemp
 
 template <typename ServerType>
 bool ESP8266WebServerTemplate<ServerType>::_collectHeader(const char* headerName, const char* headerValue) {
+  return _collectHeader(headerName, strlen(headerName), headerValue, strlen(headerValue));
+}
+
+template <typename ServerType>
+bool ESP8266WebServerTemplate<ServerType>::_collectHeader(const char* headerName, size_t nameLen, const char* headerValue, size_t valueLen) {
   for (int i = 0; i < _headerKeysCount; i++) {
-    if (_currentHeaders[i].key.equalsIgnoreCase(headerName)) {
-            _currentHeaders[i].value=headerValue;
+    const String& key = _currentHeaders[i].key;
+    if (key.length() == nameLen && strncasecmp(key.c_str(), headerName, nameLen) == 0) {
+            // value keeps its buffer from previous requests
+            _currentHeaders[i].value.clear();
+            _currentHeaders[i].value.concat(headerValue, valueLen);
             return true;
         }
   }
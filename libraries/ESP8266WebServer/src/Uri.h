@@ -16,12 +16,25 @@ class Uri {
         virtual ~Uri() {}
 
         virtual Uri* clone() const {
-            return new Uri(_uri);
+            Uri* uri = new Uri(_uri);
+            uri->_literal = true; // a plain path, as given to server.on()
+            return uri;
         };
 
         virtual bool canHandle(const String &requestUri, __attribute__((unused)) std::vector<String> &pathArgs) {
             return _uri == requestUri;
         }
+
+        // Pattern indexed by the server's route table: a path whose "{}"
+        // segments match any single segment, or nullptr when this uri can
+        // not be indexed (its canHandle() is then always called).  Only
+        // literal paths are indexed, subclasses opt in by overriding this.
+        virtual const String* routePattern() const {
+            return _literal? &_uri: nullptr;
+        }
+
+    private:
+        bool _literal = false;
 };
 
 #endif
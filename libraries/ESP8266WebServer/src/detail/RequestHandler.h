@@ -17,6 +17,11 @@ public:
     virtual bool handle(WebServerType& server, HTTPMethod requestMethod, const String& requestUri) { (void) server; (void) requestMethod; (void) requestUri; return false; }
     virtual void upload(WebServerType& server, const String& requestUri, HTTPUpload& upload) { (void) server; (void) requestUri; (void) upload; }
 
+    // route table indexing: handlers matching a Uri and a method return them,
+    // other handlers are tried one by one
+    virtual const Uri* routeUri() const { return nullptr; }
+    virtual HTTPMethod routeMethod() const { return HTTP_ANY; }
+
     RequestHandler<ServerType>* next() { return _next; }
     void next(RequestHandler<ServerType>* r) { _next = r; }
 
@@ -7,6 +7,10 @@
 #include "WString.h"
 #include "Uri.h"
 
+#ifndef WEBSERVER_STATIC_CACHE_SIZE
+#define WEBSERVER_STATIC_CACHE_SIZE 16 // resolved files per served directory
+#endif
+
 namespace esp8266webserver {
 
 template<typename ServerType>
@@ -55,6 +59,14 @@ public:
             _ufn();
     }
 
+    const Uri* routeUri() const override {
+        return _uri;
+    }
+
+    HTTPMethod routeMethod() const override {
+        return _method;
+    }
+
 protected:
     typename WebServerType::THandlerFunction _fn;
     typename WebServerType::THandlerFunction _ufn;
@@ -84,7 +96,55 @@ public:
         return mime::getContentType(path);
     }
 
+    // quoted base64 md5 of file content, f is rewound
+    static String calcETag(File& f) {
+        MD5Builder calcMD5;
+        calcMD5.begin();
+        calcMD5.addStream(f, f.size());
+        calcMD5.calculate();
+        f.seek(0);
+        uint8_t md5[16];
+        calcMD5.getBytes(md5);
+        return "\"" + base64::encode(md5, 16, false) + "\"";
+    }
+
+    // quoted base64 md5 of file content, empty on error
+    static String calcETag(FS& fs, const String& path) {
+        File f = fs.open(path, "r");
+        if (!f)
+            return emptyString;
+        String etag = calcETag(f);
+        f.close();
+        return etag;
+    }
+
 protected:
+    struct ETagCache {
+        String etag;
+        uint32_t generation = 0; // FS::generation() when checked
+        size_t size = 0;         // of the file when computed
+        time_t lastWrite = 0;
+    };
+
+    // The ETag is computed again only when the file size or modification
+    // time changed.  Without modification times (SPIFFS), any filesystem
+    // modification does it.
+    const String& _validETag(File& f, ETagCache& cache) {
+        uint32_t generation = _fs.generation();
+        if (cache.etag.length() && cache.generation == generation)
+            return cache.etag;
+
+        size_t size = f.size();
+        time_t lastWrite = f.getLastWrite();
+        if (!cache.etag.length() || !lastWrite || size != cache.size || lastWrite != cache.lastWrite) {
+            cache.etag = calcETag(f);
+            cache.size = size;
+            cache.lastWrite = lastWrite;
+        }
+        cache.generation = generation;
+        return cache.etag;
+    }
+
     FS _fs;
     String _uri;
     String _path;
@@ -116,6 +176,53 @@ public:
 
         DEBUGV("DirectoryRequestHandler::handle: request=%s _uri=%s\r\n", requestUri.c_str(), SRH::_uri.c_str());
 
+        // Cached resolutions are checked again when the filesystem is modified
+        CacheEntry* entry = _find(requestUri);
+        if (!entry || entry->generation != SRH::_fs.generation()) {
+            entry = _resolve(requestUri, entry);
+            if (!entry)
+                return false;
+        }
+
+        File f = SRH::_fs.open(entry->path, "r");
+        if (!f)
+            return false;
+
+        const String& etag = SRH::_validETag(f, entry->etag);
+        if (etag.length() && server.header("If-None-Match") == etag) {
+            f.close();
+            server.send(304);
+            return true;
+        }
+
+        if (SRH::_cache_header.length() != 0)
+            server.sendHeader("Cache-Control", SRH::_cache_header);
+
+        if (etag.length())
+            server.sendHeader("ETag", etag);
+
+        server.streamFile(f, entry->contentType, requestMethod);
+        return true;
+    }
+
+protected:
+    struct CacheEntry {
+        String uri;         // request
+        String path;        // resolved file, may be the .gz variant
+        String contentType; // of the requested file
+        uint32_t generation; // FS::generation() when resolved
+        typename SRH::ETagCache etag; // of path
+    };
+
+    CacheEntry* _find(const String& requestUri) {
+        for (auto& entry: _cache)
+            if (entry.uri == requestUri)
+                return &entry;
+        return nullptr;
+    }
+
+    // entry is the stale resolution of requestUri, if any
+    CacheEntry* _resolve(const String& requestUri, CacheEntry* entry) {
         String path;
         path.reserve(SRH::_path.length() + requestUri.length() + 32);
         path = SRH::_path;
@@ -148,23 +255,36 @@ public:
         }
 
         File f = SRH::_fs.open(path, "r");
-        if (!f)
-            return false;
-
-        if (!f.isFile()) {
-            f.close();
-            return false;
+        bool isFile = f && f.isFile();
+        f.close();
+        if (!isFile) {
+            if (entry)
+                entry->uri.clear();
+            return nullptr;
         }
 
-        if (SRH::_cache_header.length() != 0)
-            server.sendHeader("Cache-Control", SRH::_cache_header);
-
-        server.streamFile(f, contentType, requestMethod);
-        return true;
+        if (!entry) {
+            if (_cache.size() < WEBSERVER_STATIC_CACHE_SIZE) {
+                _cache.emplace_back();
+                entry = &_cache.back();
+            }
+            else
+                // full: replace entries in turn
+                entry = &_cache[_cacheNext++ % WEBSERVER_STATIC_CACHE_SIZE];
+            entry->uri = requestUri;
+        }
+        if (entry->path != path) {
+            entry->path = path;
+            entry->etag = typename SRH::ETagCache();
+        }
+        entry->contentType = contentType;
+        entry->generation = SRH::_fs.generation();
+        return entry;
     }
 
-protected:
     size_t _baseUriLength;
+    std::vector<CacheEntry> _cache;
+    size_t _cacheNext = 0;
 };
 
 template<typename ServerType>
@@ -180,13 +300,11 @@ public:
         :
     StaticRequestHandler<ServerType>{fs, path, uri, cache_header}
     {
-        File f = SRH::_fs.open(path, "r");
-        MD5Builder calcMD5;
-        calcMD5.begin();
-        calcMD5.addStream(f, f.size());
-        calcMD5.calculate();
-        calcMD5.getBytes(_ETag_md5);
-        f.close();
+        File f = SRH::_fs.open(SRH::_path, "r");
+        if (f) {
+            SRH::_validETag(f, _ETag);
+            f.close();
+        }
     }
 
     bool canHandle(HTTPMethod requestMethod, const String& requestUri) override  {
@@ -197,13 +315,6 @@ public:
         if (!canHandle(requestMethod, requestUri))
             return false;
 
-        const String etag = "\"" + base64::encode(_ETag_md5, 16, false) + "\"";
-
-        if(server.header("If-None-Match") == etag){
-            server.send(304);
-            return true;
-        }
-
         File f = SRH::_fs.open(SRH::_path, "r");
 
         if (!f)
@@ -214,6 +325,14 @@ public:
             return false;
         }
 
+        const String& etag = SRH::_validETag(f, _ETag);
+
+        if(etag.length() && server.header("If-None-Match") == etag){
+            f.close();
+            server.send(304);
+            return true;
+        }
+
         if (SRH::_cache_header.length() != 0)
             server.sendHeader("Cache-Control", SRH::_cache_header);
 
@@ -224,7 +343,7 @@ public:
     }
 
 protected:
-    uint8_t _ETag_md5[16];       
+    typename SRH::ETagCache _ETag;
 };
 
 } // namespace
@@ -0,0 +1,158 @@
+#ifndef ROUTETABLE_H
+#define ROUTETABLE_H
+
+#include <Arduino.h>
+#include <vector>
+#include <algorithm>
+#include "RequestHandler.h"
+
+namespace esp8266webserver {
+
+// Route table: handlers exposing an indexable Uri (literal path or "{}"
+// segments, see Uri::routePattern()) are stored in a trie of path segments,
+// so that finding candidates for a request only walks its path.  Other
+// handlers are tried one by one.  Registration order is preserved: the
+// first handler (in order of registration) accepting the request wins, and
+// its canHandle() is always called to confirm the match and fill pathArgs.
+
+template<typename ServerType>
+class RouteTable {
+    using RequestHandlerType = RequestHandler<ServerType>;
+
+public:
+    // to be called when handlers are added or removed,
+    // table is rebuilt on next lookup
+    void invalidate() { _valid = false; }
+
+    RequestHandlerType* find(RequestHandlerType* first, HTTPMethod method, const String& uri) {
+        if (!_valid)
+            build(first);
+
+        _candidates.clear();
+        const char* path = uri.c_str();
+        match(0, path, path + uri.length(), method);
+        std::sort(_candidates.begin(), _candidates.end(), [](const Entry& a, const Entry& b) { return a.order < b.order; });
+
+        // merge indexed candidates with unindexed handlers, in order
+        auto c = _candidates.begin();
+        auto u = _unindexed.begin();
+        while (c != _candidates.end() || u != _unindexed.end()) {
+            const Entry& e = (u == _unindexed.end() || (c != _candidates.end() && c->order < u->order))? *c++: *u++;
+            if (e.handler->canHandle(method, uri))
+                return e.handler;
+        }
+        return nullptr;
+    }
+
+protected:
+    struct Entry {
+        uint16_t order;
+        HTTPMethod method;
+        RequestHandlerType* handler;
+    };
+
+    struct Node {
+        String segment;          // literal segment
+        int16_t child = -1;      // first literal child
+        int16_t sibling = -1;    // next literal sibling
+        int16_t wildcard = -1;   // "{}" child
+        std::vector<Entry> entries; // handlers for the path ending here
+    };
+
+    void build(RequestHandlerType* first) {
+        _nodes.clear();
+        _unindexed.clear();
+        _nodes.emplace_back(); // root
+        uint16_t order = 0;
+        for (RequestHandlerType* handler = first; handler; handler = handler->next(), order++) {
+            const Uri* uri = handler->routeUri();
+            const String* pattern = uri? uri->routePattern(): nullptr;
+            Entry entry { order, handler->routeMethod(), handler };
+            if (pattern)
+                _nodes[insert(*pattern)].entries.push_back(entry);
+            else
+                _unindexed.push_back(entry);
+        }
+        _valid = true;
+    }
+
+    // returns the node matching the whole pattern
+    int16_t insert(const String& pattern) {
+        int16_t node = 0;
+        const char* seg = pattern.c_str();
+        const char* end = seg + pattern.length();
+        while (true) {
+            const char* segEnd = segmentEnd(seg, end);
+            size_t len = segEnd - seg;
+            int16_t next;
+            if (len == 2 && seg[0] == '{' && seg[1] == '}') {
+                next = _nodes[node].wildcard;
+                if (next < 0) {
+                    next = newNode();
+                    _nodes[node].wildcard = next;
+                }
+            }
+            else {
+                for (next = _nodes[node].child; next >= 0; next = _nodes[next].sibling)
+                    if (sameSegment(_nodes[next].segment, seg, len))
+                        break;
+                if (next < 0) {
+                    next = newNode();
+                    _nodes[next].segment.concat(seg, len);
+                    _nodes[next].sibling = _nodes[node].child;
+                    _nodes[node].child = next;
+                }
+            }
+            node = next;
+            if (segEnd == end)
+                return node;
+            seg = segEnd + 1;
+        }
+    }
+
+    int16_t newNode() {
+        _nodes.emplace_back();
+        return _nodes.size() - 1;
+    }
+
+    // collect handlers registered on paths matching [seg, end[ from node
+    void match(int16_t node, const char* seg, const char* end, HTTPMethod method) {
+        const char* segEnd = segmentEnd(seg, end);
+        size_t len = segEnd - seg;
+        for (int16_t n = _nodes[node].child; n >= 0; n = _nodes[n].sibling)
+            if (sameSegment(_nodes[n].segment, seg, len)) {
+                matched(n, segEnd, end, method);
+                break;
+            }
+        if (_nodes[node].wildcard >= 0)
+            matched(_nodes[node].wildcard, segEnd, end, method);
+    }
+
+    void matched(int16_t node, const char* segEnd, const char* end, HTTPMethod method) {
+        if (segEnd != end) {
+            match(node, segEnd + 1, end, method);
+            return;
+        }
+        for (const Entry& e: _nodes[node].entries)
+            if (e.method == HTTP_ANY || e.method == method)
+                _candidates.push_back(e);
+    }
+
+    static const char* segmentEnd(const char* seg, const char* end) {
+        const char* slash = (const char*)memchr(seg, '/', end - seg);
+        return slash? slash: end;
+    }
+
+    static bool sameSegment(const String& segment, const char* seg, size_t len) {
+        return segment.length() == len && memcmp(segment.c_str(), seg, len) == 0;
+    }
+
+    std::vector<Node> _nodes;
+    std::vector<Entry> _unindexed;
+    std::vector<Entry> _candidates;
+    bool _valid = false;
+};
+
+} // namespace
+
+#endif //ROUTETABLE_H
@@ -1,6 +1,8 @@
 #include "mimetable.h"
 #include "pgmspace.h"
 #include "WString.h"
+#include <algorithm>
+#include <vector>
 
 namespace mime
 {
@@ -88,14 +90,88 @@ const Entry mimeTable[maxType] PROGMEM =
     { kDefaultSuffix, kDefault }
 };
 
-    String getContentType(const String& path) {
-        for (size_t i = 0; i < maxType; i++) {
-            if (path.endsWith(FPSTR(mimeTable[i].endsWith))) {
-                return String(FPSTR(mimeTable[i].mimeType));
+// mimeTable entries sorted by suffix, for binary search
+static const uint8_t sortedTypes[] PROGMEM =
+{
+#ifndef MIMETYPE_MINIMAL
+    appcache, css, eot, gif,
+#endif // MIMETYPE_MINIMAL
+    gz, htm, html,
+#ifndef MIMETYPE_MINIMAL
+    ico, jpeg, jpg, js, json, otf, pdf, png, sfnt, svg, ttf,
+#endif // MIMETYPE_MINIMAL
+    txt,
+#ifndef MIMETYPE_MINIMAL
+    woff, woff2, xml, zip,
+#endif // MIMETYPE_MINIMAL
+};
+static_assert(sizeof(sortedTypes) == none, "every suffix but none's must be in sortedTypes");
+
+// types registered by application, sorted by suffix
+static std::vector<Entry> userTable;
+
+// suffix (".ext") of the last path segment, or nullptr
+static const char* suffix(const char* path)
+{
+    const char* dot = strrchr(path, '.');
+    if (!dot || strchr(dot, '/'))
+        return nullptr;
+    return dot;
+}
+
+// strcmp() for two strings in RAM or flash
+static int strcmp_PP(PGM_P a, PGM_P b)
+{
+    uint8_t ca, cb;
+    do {
+        ca = pgm_read_byte(a++);
+        cb = pgm_read_byte(b++);
+    } while (ca && ca == cb);
+    return ca - cb;
+}
+
+    PGM_P getContentType_P(const char* path) {
+        const char* ext = suffix(path);
+        if (ext) {
+            auto user = std::lower_bound(userTable.begin(), userTable.end(), ext,
+                [](const Entry& e, const char* ext) { return strcmp_P(ext, e.endsWith) > 0; });
+            if (user != userTable.end() && strcmp_P(ext, user->endsWith) == 0)
+                return user->mimeType;
+
+            size_t lo = 0, hi = sizeof(sortedTypes);
+            while (lo < hi) {
+                size_t mid = (lo + hi) / 2;
+                const Entry& e = mimeTable[pgm_read_byte(&sortedTypes[mid])];
+                int cmp = strcmp_P(ext, e.endsWith);
+                if (cmp == 0)
+                    return e.mimeType;
+                if (cmp < 0)
+                    hi = mid;
+                else
+                    lo = mid + 1;
             }
         }
         // Fall-through and just return default type
-        return String(FPSTR(kDefault));
+        return kDefault;
+    }
+
+    String getContentType(const String& path) {
+        return String(FPSTR(getContentType_P(path.c_str())));
+    }
+
+    bool registerType(const char* suffix, const char* mimeType) {
+        if (pgm_read_byte(suffix) != '.' || !pgm_read_byte(suffix + 1))
+            return false;
+        for (PGM_P c = suffix + 1; pgm_read_byte(c); c++)
+            if (pgm_read_byte(c) == '.' || pgm_read_byte(c) == '/')
+                return false;
+        auto user = std::lower_bound(userTable.begin(), userTable.end(), suffix,
+            [](const Entry& e, const char* suffix) { return strcmp_PP(e.endsWith, suffix) < 0; });
+        if (user != userTable.end() && strcmp_PP(user->endsWith, suffix) == 0)
+            user->mimeType = mimeType;
+        else
+            userTable.insert(user, { suffix, mimeType });
+        return true;
     }
 
 }
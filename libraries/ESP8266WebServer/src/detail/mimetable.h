@@ -2,6 +2,7 @@
 #define __MIMETABLE_H__
 
 #include "WString.h"
+#include <pgmspace.h>
 
 namespace mime
 {
@@ -46,7 +47,16 @@ struct Entry
 
 extern const Entry mimeTable[maxType];
 
+// Content type for path, found by its extension (case sensitive).
+// Returned string may be in flash (use FPSTR() or *_P functions).
+PGM_P getContentType_P(const char* path);
 String getContentType(const String& path);
+
+// Register an extra content type, or override a builtin one, for a
+// suffix like ".wasm" (a dot followed by an extension).
+// Strings are not copied, they can be in flash and must remain valid.
+// Returns false when suffix is not a single extension.
+bool registerType(const char* suffix, const char* mimeType);
 }
 
 #endif
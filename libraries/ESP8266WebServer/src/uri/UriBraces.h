@@ -13,6 +13,18 @@ class UriBraces : public Uri {
             return new UriBraces(_uri);
         };
 
+        const String* routePattern() const override final {
+            // indexable when braces are whole segments
+            int brace = -1;
+            while ((brace = _uri.indexOf('{', brace + 1)) >= 0) {
+                if (   (brace > 0 && _uri[brace - 1] != '/')
+                    || _uri[brace + 1] != '}'
+                    || (brace + 2 < (int)_uri.length() && _uri[brace + 2] != '/'))
+                    return nullptr;
+            }
+            return &_uri;
+        }
+
         bool canHandle(const String &requestUri, std::vector<String> &pathArgs) override final {
             if (Uri::canHandle(requestUri, pathArgs))
                 return true;
@@ -218,6 +218,16 @@ size_t WiFiClient::write(const uint8_t *buf, size_t size)
     return _client->write((const char*)buf, size);
 }
 
+size_t WiFiClient::write(const iov* v, size_t n, bool borrow)
+{
+    if (!_client || !n)
+    {
+        return 0;
+    }
+    _client->setTimeout(_timeout);
+    return _client->write(v, n, borrow);
+}
+
 size_t WiFiClient::write(Stream& stream)
 {
     // (this method is deprecated)
@@ -61,6 +61,20 @@ public:
   virtual size_t write_P(PGM_P buf, size_t size);
   size_t write(Stream& stream) [[ deprecated("use stream.sendHow(client...)") ]];
 
+  // scatter/gather element, buf can be in RAM or in flash (PROGMEM)
+  struct iov
+  {
+    const void* buf;
+    size_t len;
+  };
+
+  // gather-write: all elements are queued back to back into lwIP before
+  // output is triggered, so e.g. HTTP headers and body share segments.
+  // borrow=true: RAM elements are not copied into lwIP, the call returns once
+  // they are acknowledged by peer (as with setSync(true)). Elements in flash
+  // are always copied (through a small stack buffer).
+  size_t write(const iov* v, size_t n, bool borrow = false);
+
   virtual int available() override;
   virtual int read() override;
   virtual int read(uint8_t* buf, size_t size) override;
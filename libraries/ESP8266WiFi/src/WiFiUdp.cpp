@@ -44,7 +44,7 @@ template<>
 WiFiUDP* SList<WiFiUDP>::_s_first = 0;
 
 /* Constructor */
-WiFiUDP::WiFiUDP() : _ctx(0)
+WiFiUDP::WiFiUDP() : _ctx(0), _txPoolCount(0), _txPoolSize(0)
 {
     WiFiUDP::_add(this);
 }
@@ -52,6 +52,8 @@ WiFiUDP::WiFiUDP() : _ctx(0)
 WiFiUDP::WiFiUDP(const WiFiUDP& other)
 {
     _ctx = other._ctx;
+    _txPoolCount = other._txPoolCount;
+    _txPoolSize = other._txPoolSize;
     if (_ctx)
         _ctx->ref();
     WiFiUDP::_add(this);
@@ -60,6 +62,8 @@ WiFiUDP::WiFiUDP(const WiFiUDP& other)
 WiFiUDP& WiFiUDP::operator=(const WiFiUDP& rhs)
 {
     _ctx = rhs._ctx;
+    _txPoolCount = rhs._txPoolCount;
+    _txPoolSize = rhs._txPoolSize;
     if (_ctx)
         _ctx->ref();
     return *this;
@@ -72,6 +76,20 @@ WiFiUDP::~WiFiUDP()
         _ctx->unref();
 }
 
+bool WiFiUDP::_newContext()
+{
+    _ctx = new (std::nothrow) UdpContext;
+    if (!_ctx)
+        return false;
+    _ctx->ref();
+    // the transmit pool is set up again on every new context
+    if (!_txPoolCount || _ctx->setTxPool(_txPoolCount, _txPoolSize))
+        return true;
+    _ctx->unref();
+    _ctx = 0;
+    return false;
+}
+
 /* Start WiFiUDP socket, listening at local port */
 uint8_t WiFiUDP::begin(uint16_t port)
 {
@@ -80,8 +98,8 @@ uint8_t WiFiUDP::begin(uint16_t port)
         _ctx = 0;
     }
 
-    _ctx = new UdpContext;
-    _ctx->ref();
+    if (!_newContext())
+        return 0;
     return (_ctx->listen(IPAddress(), port)) ? 1 : 0;
 }
 
@@ -96,8 +114,8 @@ uint8_t WiFiUDP::beginMulticast(IPAddress interfaceAddr, IPAddress multicast, ui
         return 0;
     }
 
-    _ctx = new UdpContext;
-    _ctx->ref();
+    if (!_newContext())
+        return 0;
     ip_addr_t addr = IPADDR4_INIT(INADDR_ANY);
     if (!_ctx->listen(&addr, port)) {
         return 0;
@@ -146,9 +164,8 @@ int WiFiUDP::beginPacket(const char *host, uint16_t port)
 
 int WiFiUDP::beginPacket(IPAddress ip, uint16_t port)
 {
-    if (!_ctx) {
-        _ctx = new UdpContext;
-        _ctx->ref();
+    if (!_ctx && !_newContext()) {
+        return 0;
     }
     return (_ctx->connect(ip, port)) ? 1 : 0;
 }
@@ -156,9 +173,8 @@ int WiFiUDP::beginPacket(IPAddress ip, uint16_t port)
 int WiFiUDP::beginPacketMulticast(IPAddress multicastAddress, uint16_t port,
     IPAddress interfaceAddress, int ttl)
 {
-    if (!_ctx) {
-        _ctx = new UdpContext;
-        _ctx->ref();
+    if (!_ctx && !_newContext()) {
+        return 0;
     }
     if (!_ctx->connect(multicastAddress, port)) {
         return 0;
@@ -202,6 +218,68 @@ int WiFiUDP::parsePacket()
     return _ctx->getSize();
 }
 
+bool WiFiUDP::setRxQueue(size_t depth, bool dropOldest)
+{
+    if (!_ctx)
+        return false;
+
+    return _ctx->setRxQueue(depth, dropOldest? UdpContext::RxPolicy::DropOldest: UdpContext::RxPolicy::DropNewest);
+}
+
+uint32_t WiFiUDP::rxDropped() const
+{
+    if (!_ctx)
+        return 0;
+
+    return _ctx->getRxDropped();
+}
+
+size_t WiFiUDP::readBatch(Datagram* datagrams, size_t count)
+{
+    if (!_ctx)
+        return 0;
+
+    size_t n = 0;
+    for (; n < count && _ctx->next(); n++)
+    {
+        Datagram& d = datagrams[n];
+        d.size = _ctx->getSize();
+        _ctx->read(reinterpret_cast<char*>(d.buffer), std::min(d.size, d.bufferSize));
+        d.remoteIP = _ctx->getRemoteAddress();
+        d.remotePort = _ctx->getRemotePort();
+        d.destinationIP = _ctx->getDestAddress();
+    }
+    return n;
+}
+
+bool WiFiUDP::setTxPool(size_t count, size_t size)
+{
+    _txPoolCount = count;
+    _txPoolSize = size;
+    if (_ctx? _ctx->setTxPool(count, size): _newContext())
+        return true;
+    // not retried on next contexts
+    _txPoolCount = 0;
+    _txPoolSize = 0;
+    return false;
+}
+
+size_t WiFiUDP::sendBatch(const TxDatagram* datagrams, size_t count)
+{
+    if (!_ctx && !_newContext()) {
+        return 0;
+    }
+
+    size_t n = 0;
+    for (; n < count; n++)
+    {
+        const TxDatagram& d = datagrams[n];
+        if (!_ctx->sendDatagram(reinterpret_cast<const char*>(d.buffer), d.size, d.ip, d.port))
+            break;
+    }
+    return n;
+}
+
 int WiFiUDP::read()
 {
     if (!_ctx)
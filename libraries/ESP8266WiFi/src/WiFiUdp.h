@@ -32,6 +32,10 @@ class UdpContext;
 class WiFiUDP : public UDP, public SList<WiFiUDP> {
 private:
   UdpContext* _ctx;
+  size_t _txPoolCount;
+  size_t _txPoolSize;
+
+  bool _newContext();
 
 public:
   WiFiUDP();  // Constructor
@@ -104,6 +108,48 @@ public:
   // Return the local port for outgoing packets
   uint16_t localPort() const;
 
+  // Receive queue (available after begin()):
+  // at most <depth> unread packets are kept, when full the incoming packet
+  // is dropped, or the oldest unread one when dropOldest is true.
+  // Default depth is 4.
+  bool setRxQueue(size_t depth, bool dropOldest = false);
+  // Number of packets dropped because receive queue was full
+  uint32_t rxDropped() const;
+
+  struct Datagram
+  {
+    uint8_t* buffer;         // in: where payload is copied
+    size_t bufferSize;       // in: buffer capacity
+    size_t size;             // out: packet size (truncated when > bufferSize)
+    IPAddress remoteIP;      // out
+    uint16_t remotePort;     // out
+    IPAddress destinationIP; // out
+  };
+
+  // Receive up to count pending packets at once, the current packet is
+  // released.  Returns the number of filled datagrams.
+  size_t readBatch(Datagram* datagrams, size_t count);
+
+  // Transmit pool: <count> buffers of <size> bytes are allocated once and
+  // reused by beginPacket()/endPacket() and sendBatch() for packets
+  // fitting in them.  count=0 releases the pool.  The setting is kept
+  // across begin()/beginMulticast()/stop().  When the pool can not be
+  // allocated, false is returned and the instance is left without pool.
+  bool setTxPool(size_t count, size_t size);
+
+  struct TxDatagram
+  {
+    const uint8_t* buffer;
+    size_t size;
+    IPAddress ip;
+    uint16_t port;
+  };
+
+  // Send count packets at once, independently from the one being built
+  // with beginPacket()/write().  Returns the number of sent datagrams,
+  // stops at the first failure.
+  size_t sendBatch(const TxDatagram* datagrams, size_t count);
+
   static void stopAll();
   static void stopAllExcept(WiFiUDP * exC);
 
@@ -380,7 +380,16 @@ public:
         if (!_pcb) {
             return 0;
         }
-        return _write_from_source(ds, dl);
+        const WiFiClient::iov v = { ds, dl };
+        return _write_from_source(&v, 1, false);
+    }
+
+    size_t write(const WiFiClient::iov* v, size_t n, bool borrow)
+    {
+        if (!_pcb) {
+            return 0;
+        }
+        return _write_from_source(v, n, borrow);
     }
 
     void keepAlive (uint16_t idle_sec = TCP_DEFAULT_KEEPALIVE_IDLE_SEC, uint16_t intv_sec = TCP_DEFAULT_KEEPALIVE_INTERVAL_SEC, uint8_t count = TCP_DEFAULT_KEEPALIVE_COUNT)
@@ -464,13 +473,20 @@ protected:
         }
     }
 
-    size_t _write_from_source(const char* ds, const size_t dl)
+    size_t _write_from_source(const WiFiClient::iov* v, size_t n, bool borrow)
     {
         assert(_datasource == nullptr);
         assert(!_send_waiting);
-        _datasource = ds;
-        _datalen = dl;
+        _datasource = v;
+        _datacount = n;
+        _dataindex = 0;
+        _dataoffset = 0;
+        _datalen = 0;
+        for (size_t i = 0; i < n; i++) {
+            _datalen += v[i].len;
+        }
         _written = 0;
+        _borrow = borrow;
         _op_start_time = millis();
         do {
             if (_write_some()) {
@@ -482,6 +498,7 @@ protected:
                     DEBUGV(":wtmo\r\n");
                 }
                 _datasource = nullptr;
+                _datacount = 0;
                 _datalen = 0;
                 break;
             }
@@ -495,7 +512,8 @@ protected:
             _send_waiting = false;
         } while(true);
 
-        if (_sync)
+        if (_sync || _borrow)
+            // borrowed buffers are released to user only once acknowledged
             wait_until_acked();
 
         return _written;
@@ -510,15 +528,31 @@ protected:
         DEBUGV(":wr %d %d\r\n", _datalen - _written, _written);
 
         bool has_written = false;
+        // flash data cannot be handed over to lwIP which reads bytes
+        char flashbuf[128] __attribute__((aligned(4)));
 
-        while (_written < _datalen) {
+        while (_written < _datalen && _dataindex < _datacount) {
             if (state() == CLOSED)
                 return false;
+            const WiFiClient::iov& v = _datasource[_dataindex];
+            if (_dataoffset == v.len) {
+                // next element
+                _dataindex++;
+                _dataoffset = 0;
+                continue;
+            }
             const auto remaining = _datalen - _written;
-            size_t next_chunk_size = std::min((size_t)tcp_sndbuf(_pcb), remaining);
+            size_t next_chunk_size = std::min((size_t)tcp_sndbuf(_pcb), v.len - _dataoffset);
             if (!next_chunk_size)
                 break;
-            const char* buf = _datasource + _written;
+            const char* buf = (const char*)v.buf + _dataoffset;
+
+            const bool inRam = __byteAddressable(buf);
+            if (!inRam) {
+                next_chunk_size = std::min(next_chunk_size, sizeof(flashbuf));
+                memcpy_P(flashbuf, buf, next_chunk_size);
+                buf = flashbuf;
+            }
 
             uint8_t flags = 0;
             if (next_chunk_size < remaining)
@@ -528,9 +562,9 @@ protected:
                 //   #5173: windows needs this flag
                 //   more info: https://lists.gnu.org/archive/html/lwip-users/2009-11/msg00018.html
                 flags |= TCP_WRITE_FLAG_MORE; // do not tcp-PuSH (yet)
-            if (!_sync)
+            if (!inRam || !(_sync || _borrow))
                 // user data must be copied when data are sent but not yet acknowledged
-                // (with sync, we wait for acknowledgment before returning to user)
+                // (with sync or borrow, we wait for acknowledgment before returning to user)
                 flags |= TCP_WRITE_FLAG_COPY;
 
             err_t err = tcp_write(_pcb, buf, next_chunk_size, flags);
@@ -539,6 +573,7 @@ protected:
 
             if (err == ERR_OK) {
                 _written += next_chunk_size;
+                _dataoffset += next_chunk_size;
                 has_written = true;
             } else {
                 // ERR_MEM(-1) is a valid error meaning
@@ -695,9 +730,13 @@ private:
     discard_cb_t _discard_cb;
     void* _discard_cb_arg;
 
-    const char* _datasource = nullptr;
+    const WiFiClient::iov* _datasource = nullptr;
+    size_t _datacount = 0;
+    size_t _dataindex = 0;
+    size_t _dataoffset = 0;
     size_t _datalen = 0;
     size_t _written = 0;
+    bool _borrow = false;
     uint32_t _timeout_ms = 5000;
     uint32_t _op_start_time = 0;
     bool _send_waiting = false;
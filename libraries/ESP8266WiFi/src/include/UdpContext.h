@@ -32,20 +32,22 @@ void esp_schedule();
 #include <AddrList.h>
 #include <PolledTimeout.h>
 
-#define PBUF_ALIGNER_ADJUST 4
-#define PBUF_ALIGNER(x) ((void*)((((intptr_t)(x))+3)&~3))
-#define PBUF_HELPER_FLAG 0xff // lwIP pbuf flag: u8_t
-
 class UdpContext
 {
 public:
 
     typedef std::function<void(void)> rxhandler_t;
 
+    // what to do with a received datagram when receive queue is full
+    enum class RxPolicy
+    {
+        DropNewest, // discard it (default)
+        DropOldest, // discard the oldest unread one instead
+    };
+
     UdpContext()
     : _pcb(0)
     , _rx_buf(0)
-    , _first_buf_taken(false)
     , _rx_buf_offset(0)
     , _rx_buf_size(0)
     , _refcnt(0)
@@ -77,6 +79,9 @@ public:
             _rx_buf_offset = 0;
             _rx_buf_size = 0;
         }
+        _rx_queue_clear();
+        delete [] _rx_queue;
+        _tx_pool_release();
     }
 
     void ref()
@@ -107,6 +112,8 @@ public:
 
     bool listen(const IPAddress& addr, uint16_t port)
     {
+        if (!_rx_queue && !setRxQueue(rxQueueDefaultDepth, _rx_policy))
+            return false;
         udp_recv(_pcb, &_s_recv, (void *) this);
         err_t err = udp_bind(_pcb, addr, port);
         return err == ERR_OK;
@@ -182,6 +189,48 @@ public:
         _on_rx = handler;
     }
 
+    // Receive queue: up to <depth> unread datagrams are kept, with their
+    // metadata, in a table allocated here (not per datagram).
+    // Already queued datagrams are kept when possible.
+    bool setRxQueue(size_t depth, RxPolicy policy = RxPolicy::DropNewest)
+    {
+        if (!depth)
+            return false;
+        RxEntry* queue = new (std::nothrow) RxEntry[depth];
+        if (!queue)
+            return false;
+
+        size_t count = 0;
+        while (_rx_count)
+        {
+            RxEntry& e = _rx_queue[_rx_first];
+            if (count < depth)
+                queue[count++] = e;
+            else
+            {
+                pbuf_free(e.pb);
+                ++_rx_dropped;
+            }
+            e.pb = nullptr;
+            _rx_first = (_rx_first + 1) % _rx_depth;
+            --_rx_count;
+        }
+
+        delete [] _rx_queue;
+        _rx_queue = queue;
+        _rx_depth = depth;
+        _rx_first = 0;
+        _rx_count = count;
+        _rx_policy = policy;
+        return true;
+    }
+
+    // number of datagrams dropped because receive queue was full
+    uint32_t getRxDropped() const
+    {
+        return _rx_dropped;
+    }
+
 #ifdef DEBUG_ESP_CORE
     // this helper is ready to be used when debugging UDP
     void printChain (const pbuf* pb, const char* msg, size_t n) const
@@ -191,8 +240,8 @@ public:
         int l = snprintf(buf, sizeof(buf), "UDP: %s %u: ", msg, n);
         while (pb)
         {
-            l += snprintf(&buf[l], sizeof(buf) -l, "%p(H=%d,%d<=%d)-",
-                pb, pb->flags == PBUF_HELPER_FLAG, pb->len, pb->tot_len);
+            l += snprintf(&buf[l], sizeof(buf) -l, "%p(%d<=%d)-",
+                pb, pb->len, pb->tot_len);
             pb = pb->next;
         }
         l += snprintf(&buf[l], sizeof(buf) - l, "(end)");
@@ -229,6 +278,12 @@ public:
         return (pos <= _rx_buf_size);
     }
 
+    // current datagram, to be parsed in place (read(), seek() and flush() are not affected)
+    const pbuf* getRxBuffer() const
+    {
+        return _rx_buf;
+    }
+
     netif* getInputNetif() const
     {
         return _currentAddr.input_netif;
@@ -258,57 +313,27 @@ public:
 
     bool next()
     {
-        if (!_rx_buf)
-            return false;
-        if (!_first_buf_taken)
-        {
-            _first_buf_taken = true;
-            return true;
-        }
-
-        // We have interleaved information on addresses within received pbuf chain:
-        // (before ipv6 code we had: (data-pbuf) -> (data-pbuf) -> (data-pbuf) -> ... in the receiving order)
-        // Now:         (address-info-pbuf -> chained-data-pbuf [-> chained-data-pbuf...]) ->
-        //      (chained-address-info-pbuf -> chained-data-pbuf [-> chained...]) -> ...
-        // _rx_buf is currently adressing a data pbuf,
-        // in this function it is going to be discarded.
-
-        auto deleteme = _rx_buf;
-
-        // forward in the chain until next address-info pbuf or end of chain
-        while(_rx_buf && _rx_buf->flags != PBUF_HELPER_FLAG)
-            _rx_buf = _rx_buf->next;
-
+        // release current datagram
         if (_rx_buf)
         {
-            assert(_rx_buf->flags == PBUF_HELPER_FLAG);
-
-            // copy address helper to "current address"
-            auto helper = (AddrHelper*)PBUF_ALIGNER(_rx_buf->payload);
-            _currentAddr = *helper;
-
-            // destroy the helper in the about-to-be-released pbuf
-            helper->~AddrHelper();
-
-            // forward in rx_buf list, next one is effective data
-            // current (not ref'ed) one will be pbuf_free'd
-            // with the 'deleteme' pointer above
-            _rx_buf = _rx_buf->next;
-
-            // this rx_buf is not nullptr by construction,
-            assert(_rx_buf);
-            // ref'ing it to prevent release from the below pbuf_free(deleteme)
-            // (ref counter prevents release and will be decreased by pbuf_free)
-            pbuf_ref(_rx_buf);
+            pbuf_free(_rx_buf);
+            _rx_buf = 0;
         }
+        _rx_buf_offset = 0;
+        _rx_buf_size = 0;
 
-        // release in chain previous data, and if any:
-        // current helper, but not start of current data
-        pbuf_free(deleteme);
+        if (!_rx_count)
+            return false;
 
-        _rx_buf_offset = 0;
-        _rx_buf_size = _processSize(_rx_buf);
-        return _rx_buf != nullptr;
+        RxEntry& e = _rx_queue[_rx_first];
+        _rx_buf = e.pb;
+        _currentAddr = e.addr;
+        e.pb = nullptr;
+        _rx_first = (_rx_first + 1) % _rx_depth;
+        --_rx_count;
+
+        _rx_buf_size = _rx_buf->tot_len;
+        return true;
     }
 
     int read()
@@ -359,36 +384,93 @@ public:
         _consume(_rx_buf_size - _rx_buf_offset);
     }
 
-    size_t append(const char* data, size_t size)
+    // Transmit pool: <count> pbufs of <size> bytes are allocated once and
+    // reused for outgoing datagrams fitting in them, which are then sent
+    // without allocation nor copy.  A pbuf still referenced by lwIP or by
+    // the driver is not reused.  count=0 releases the pool.
+    bool setTxPool(size_t count, size_t size)
     {
-        if (!_tx_buf_head || _tx_buf_head->tot_len < _tx_buf_offset + size)
+        cancelBuffer();
+        _tx_pool_release();
+        if (!count)
+            return true;
+
+        _tx_pool = new (std::nothrow) TxSlot[count](); // pb=nullptr until allocated
+        if (!_tx_pool)
+            return false;
+        _tx_pool_count = count;
+        _tx_pool_size = size;
+        for (size_t i = 0; i < count; i++)
         {
-            _reserve(_tx_buf_offset + size);
+            pbuf* pb = pbuf_alloc(PBUF_TRANSPORT, size, PBUF_RAM);
+            if (!pb)
+            {
+                _tx_pool_release();
+                return false;
+            }
+            _tx_pool[i].pb = pb;
+            _tx_pool[i].payload = pb->payload;
         }
-        if (!_tx_buf_head || _tx_buf_head->tot_len < _tx_buf_offset + size)
+        return true;
+    }
+
+    // Send one datagram, independently from the one being built with
+    // append().  Transmit pool is used when possible, otherwise a single
+    // pbuf is allocated.
+    bool sendDatagram(const char* data, size_t size, const ip_addr_t* addr, uint16_t port)
+    {
+        TxSlot* slot = size <= _tx_pool_size? _tx_pool_get(): nullptr;
+        pbuf* pb;
+        if (slot)
         {
-            DEBUGV("failed _reserve");
-            return 0;
+            _tx_slot_reset(slot, size);
+            pb = slot->pb;
         }
+        else
+        {
+            pb = pbuf_alloc(PBUF_TRANSPORT, size, PBUF_RAM);
+            if (!pb)
+            {
+                DEBUGV("failed pbuf_alloc");
+                return false;
+            }
+        }
+        memcpy(pb->payload, data, size);
 
-        size_t left_to_copy = size;
-        while(left_to_copy)
+        err_t err = udp_sendto(_pcb, pb, addr, port);
+        if (err != ERR_OK) {
+            DEBUGV(":usd rc=%d\r\n", (int) err);
+        }
+
+        if (!slot)
+            pbuf_free(pb);
+        return err == ERR_OK;
+    }
+
+    size_t append(const char* data, size_t size)
+    {
+        if (_tx_pool_count && !_tx_buf_head)
         {
-            // size already used in current pbuf
-            size_t used_cur = _tx_buf_offset - (_tx_buf_head->tot_len - _tx_buf_cur->tot_len);
-            size_t free_cur = _tx_buf_cur->len - used_cur;
-            if (free_cur == 0)
+            if (!_tx_slot && (_tx_slot = _tx_pool_get()))
+                _tx_buf_offset = 0;
+            if (_tx_slot && _tx_buf_offset + size <= _tx_pool_size)
             {
-                _tx_buf_cur = _tx_buf_cur->next;
-                continue;
+                memcpy(reinterpret_cast<char*>(_tx_slot->payload) + _tx_buf_offset, data, size);
+                _tx_buf_offset += size;
+                return size;
+            }
+            if (_tx_slot)
+            {
+                // too large for the pool, move to a regular buffer
+                const char* pooled = reinterpret_cast<const char*>(_tx_slot->payload);
+                size_t pooled_size = _tx_buf_offset;
+                _tx_slot = nullptr;
+                _tx_buf_offset = 0;
+                if (pooled_size && _append(pooled, pooled_size) != pooled_size)
+                    return 0;
             }
-            size_t will_copy = (left_to_copy < free_cur) ? left_to_copy : free_cur;
-            memcpy(reinterpret_cast<char*>(_tx_buf_cur->payload) + used_cur, data, will_copy);
-            _tx_buf_offset += will_copy;
-            left_to_copy -= will_copy;
-            data += will_copy;
         }
-        return size;
+        return _append(data, size);
     }
 
     void cancelBuffer ()
@@ -398,6 +480,7 @@ public:
         _tx_buf_head = 0;
         _tx_buf_cur = 0;
         _tx_buf_offset = 0;
+        _tx_slot = nullptr;
     }
 
     bool send(const ip_addr_t* addr = 0, uint16_t port = 0)
@@ -419,8 +502,58 @@ public:
 
 private:
 
+    size_t _append(const char* data, size_t size)
+    {
+        if (!_tx_buf_head || _tx_buf_head->tot_len < _tx_buf_offset + size)
+        {
+            _reserve(_tx_buf_offset + size);
+        }
+        if (!_tx_buf_head || _tx_buf_head->tot_len < _tx_buf_offset + size)
+        {
+            DEBUGV("failed _reserve");
+            return 0;
+        }
+
+        size_t left_to_copy = size;
+        while(left_to_copy)
+        {
+            // size already used in current pbuf
+            size_t used_cur = _tx_buf_offset - (_tx_buf_head->tot_len - _tx_buf_cur->tot_len);
+            size_t free_cur = _tx_buf_cur->len - used_cur;
+            if (free_cur == 0)
+            {
+                _tx_buf_cur = _tx_buf_cur->next;
+                continue;
+            }
+            size_t will_copy = (left_to_copy < free_cur) ? left_to_copy : free_cur;
+            memcpy(reinterpret_cast<char*>(_tx_buf_cur->payload) + used_cur, data, will_copy);
+            _tx_buf_offset += will_copy;
+            left_to_copy -= will_copy;
+            data += will_copy;
+        }
+        return size;
+    }
+
     err_t trySend(const ip_addr_t* addr, uint16_t port, bool keepBufferOnError)
     {
+        if (!addr) {
+            addr = &_pcb->remote_ip;
+            port = _pcb->remote_port;
+        }
+
+        if (_tx_slot)
+        {
+            // pooled pbuf is sent as is
+            _tx_slot_reset(_tx_slot, _tx_buf_offset);
+            err_t err = udp_sendto(_pcb, _tx_slot->pb, addr, port);
+            if (err != ERR_OK) {
+                DEBUGV(":ust rc=%d\r\n", (int) err);
+            }
+            if (err == ERR_OK || !keepBufferOnError)
+                cancelBuffer();
+            return err;
+        }
+
         size_t data_size = _tx_buf_offset;
         pbuf* tx_copy = pbuf_alloc(PBUF_TRANSPORT, data_size, PBUF_RAM);
         if (tx_copy) {
@@ -441,11 +574,6 @@ private:
             return ERR_MEM;
         }
 
-        if (!addr) {
-            addr = &_pcb->remote_ip;
-            port = _pcb->remote_port;
-        }
-
         err_t err = udp_sendto(_pcb, tx_copy, addr, port);
         if (err != ERR_OK) {
             DEBUGV(":ust rc=%d\r\n", (int) err);
@@ -459,12 +587,55 @@ private:
         return err;
     }
 
-    size_t _processSize (const pbuf* pb)
+    struct TxSlot
     {
-        size_t ret = 0;
-        for (; pb && pb->flags != PBUF_HELPER_FLAG; pb = pb->next)
-            ret += pb->len;
-        return ret;
+        pbuf* pb;
+        void* payload; // as allocated, before lwIP adds headers
+    };
+
+    TxSlot* _tx_pool_get()
+    {
+        for (size_t i = 0; i < _tx_pool_count; i++)
+        {
+            TxSlot* slot = &_tx_pool[(_tx_pool_next + i) % _tx_pool_count];
+            if (slot != _tx_slot && slot->pb->ref == 1)
+            {
+                // not referenced by lwIP or driver anymore
+                _tx_pool_next = (_tx_pool_next + i + 1) % _tx_pool_count;
+                return slot;
+            }
+        }
+        return nullptr;
+    }
+
+    void _tx_slot_reset(TxSlot* slot, size_t size)
+    {
+        // undo headers added by a previous send,
+        // size is at most the allocated size of this single PBUF_RAM pbuf
+        slot->pb->payload = slot->payload;
+        slot->pb->len = slot->pb->tot_len = size;
+    }
+
+    void _tx_pool_release()
+    {
+        for (size_t i = 0; i < _tx_pool_count; i++)
+            if (_tx_pool[i].pb)
+                pbuf_free(_tx_pool[i].pb);
+        delete [] _tx_pool;
+        _tx_pool = nullptr;
+        _tx_pool_count = 0;
+        _tx_pool_size = 0;
+        _tx_pool_next = 0;
+    }
+
+    void _rx_queue_clear()
+    {
+        for (; _rx_count; --_rx_count)
+        {
+            pbuf_free(_rx_queue[_rx_first].pb);
+            _rx_queue[_rx_first].pb = nullptr;
+            _rx_first = (_rx_first + 1) % _rx_depth;
+        }
     }
 
     void _reserve(size_t size)
@@ -513,69 +684,31 @@ private:
             const ip_addr_t *srcaddr, u16_t srcport)
     {
         (void) upcb;
-        // check receive pbuf chain depth
-        // optimization path: cache the pbuf chain length
-        {
-            pbuf* p;
-            int count = 0;
-            for (p = _rx_buf; p && ++count < rxBufMaxDepth*2; p = p->next);
-            if (p)
-            {
-                // pbuf chain too deep, dropping
-                pbuf_free(pb);
-                DEBUGV(":udr\r\n");
-                return;
-            }
-        }
 
-        // chain this helper pbuf first
-        if (_rx_buf)
+        if (_rx_count == _rx_depth)
         {
-            // there is some unread data
-            // chain pbuf
-
-            // Addresses/ports are stored from this callback because lwIP's
-            // macro are valid only now.
-            //
-            // When peeking data from before payload start (like it was done
-            // before IPv6), there's no easy way to safely guess whether
-            // packet is from v4 or v6.
-            //
-            // Now storing data in an intermediate chained pbuf containing
-            // AddrHelper
-
-            // allocate new pbuf to store addresses/ports
-            pbuf* pb_helper = pbuf_alloc(PBUF_RAW, sizeof(AddrHelper) + PBUF_ALIGNER_ADJUST, PBUF_RAM);
-            if (!pb_helper)
+            ++_rx_dropped;
+            DEBUGV(":udr\r\n");
+            if (_rx_policy == RxPolicy::DropNewest)
             {
-                // memory issue - discard received data
                 pbuf_free(pb);
                 return;
             }
-            // construct in place
-            new(PBUF_ALIGNER(pb_helper->payload)) AddrHelper(srcaddr, ip_current_dest_addr(), srcport, ip_current_input_netif());
-            pb_helper->flags = PBUF_HELPER_FLAG; // mark helper pbuf
-            // chain it
-            pbuf_cat(_rx_buf, pb_helper);
-
-            // now chain the new data pbuf
-            DEBUGV(":urch %d, %d\r\n", _rx_buf->tot_len, pb->tot_len);
-            pbuf_cat(_rx_buf, pb);
-        }
-        else
-        {
-            _currentAddr.srcaddr = srcaddr;
-            _currentAddr.dstaddr = ip_current_dest_addr();
-            _currentAddr.srcport = srcport;
-            _currentAddr.input_netif = ip_current_input_netif();
-
-            DEBUGV(":urn %d\r\n", pb->tot_len);
-            _first_buf_taken = false;
-            _rx_buf = pb;
-            _rx_buf_offset = 0;
-            _rx_buf_size = pb->tot_len;
+            // make room
+            pbuf_free(_rx_queue[_rx_first].pb);
+            _rx_queue[_rx_first].pb = nullptr;
+            _rx_first = (_rx_first + 1) % _rx_depth;
+            --_rx_count;
         }
 
+        // Addresses/ports are stored from this callback because lwIP's
+        // macro are valid only now.
+        RxEntry& e = _rx_queue[(_rx_first + _rx_count) % _rx_depth];
+        e.pb = pb;
+        e.addr = AddrHelper(srcaddr, ip_current_dest_addr(), srcport, ip_current_input_netif());
+        ++_rx_count;
+        DEBUGV(":urn %d (%d)\r\n", pb->tot_len, _rx_count);
+
         if (_on_rx) {
             _on_rx();
         }
@@ -591,8 +724,7 @@ private:
 
 private:
     udp_pcb* _pcb;
-    pbuf* _rx_buf;
-    bool _first_buf_taken;
+    pbuf* _rx_buf; // current datagram
     size_t _rx_buf_offset;
     size_t _rx_buf_size;
     int _refcnt;
@@ -615,9 +747,29 @@ private:
     };
     AddrHelper _currentAddr;
 
-    // rx pbuf depth barrier (counter of buffered UDP received packets)
+    // receive queue, a ring of unread datagrams
+    struct RxEntry
+    {
+        pbuf* pb = nullptr;
+        AddrHelper addr;
+    };
+    RxEntry* _rx_queue = nullptr;
+    size_t _rx_depth = 0;
+    size_t _rx_first = 0;
+    size_t _rx_count = 0;
+    RxPolicy _rx_policy = RxPolicy::DropNewest;
+    uint32_t _rx_dropped = 0;
+
+    // transmit pool
+    TxSlot* _tx_pool = nullptr;
+    size_t _tx_pool_count = 0;
+    size_t _tx_pool_size = 0;
+    size_t _tx_pool_next = 0;
+    TxSlot* _tx_slot = nullptr; // pooled datagram being built
+
+    // default number of buffered UDP received packets
     // keep it small
-    static constexpr int rxBufMaxDepth = 4;
+    static constexpr size_t rxQueueDefaultDepth = 4;
 };
 
 
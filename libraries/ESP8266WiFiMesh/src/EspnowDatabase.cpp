@@ -41,9 +41,11 @@ namespace
   std::list<ResponseData> _responsesToSend = {};
   std::list<PeerRequestLog> _peerRequestConfirmationsToSend = {};
 
-  std::map<std::pair<macAndType_td, messageID_td>, MessageData> _receivedEspnowTransmissions = {};
-  std::map<std::pair<peerMac_td, messageID_td>, RequestData> _sentRequests = {};
-  std::map<std::pair<peerMac_td, messageID_td>, TimeTracker> _receivedRequests = {};
+  constexpr uint16_t defaultLogEntryCapacity = 32;
+  EspnowLogTable<macAndType_td, MessageData> _receivedEspnowTransmissions(defaultLogEntryCapacity);
+  EspnowLogTable<peerMac_td, RequestData> _sentRequests(defaultLogEntryCapacity);
+  EspnowLogTable<peerMac_td, TimeTracker> _receivedRequests(defaultLogEntryCapacity);
+  uint32_t _logEntriesEvictedReported = 0;
 
   std::shared_ptr<bool> _espnowConnectionQueueMutex = std::make_shared<bool>(false);
   std::shared_ptr<bool> _responsesToSendMutex = std::make_shared<bool>(false);
@@ -93,51 +95,27 @@ uint32_t EspnowDatabase::criticalHeapLevel()
 }
 
 template <typename T, typename U>
-void EspnowDatabase::deleteExpiredLogEntries(std::map<std::pair<U, uint64_t>, T> &logEntries, const uint32_t maxEntryLifetimeMs)
+void EspnowDatabase::deleteExpiredLogEntries(EspnowLogTable<U, T> &logEntries, const uint32_t maxEntryLifetimeMs)
 {
-  for(typename std::map<std::pair<U, uint64_t>, T>::iterator entryIterator = logEntries.begin(); 
-      entryIterator != logEntries.end(); )
-  {
-    if(entryIterator->second.getTimeTracker().timeSinceCreation() > maxEntryLifetimeMs)
-    {
-      entryIterator = logEntries.erase(entryIterator);
-    }
-    else
-      ++entryIterator;
-  }
+  logEntries.eraseExpired([](const typename EspnowLogTable<U, T>::value_type &entry) { return entry.second.getTimeTracker().timeSinceCreation(); }, 
+                          maxEntryLifetimeMs);
 }
 
 template <typename U>
-void EspnowDatabase::deleteExpiredLogEntries(std::map<std::pair<U, uint64_t>, TimeTracker> &logEntries, const uint32_t maxEntryLifetimeMs)
+void EspnowDatabase::deleteExpiredLogEntries(EspnowLogTable<U, TimeTracker> &logEntries, const uint32_t maxEntryLifetimeMs)
 {
-  for(typename std::map<std::pair<U, uint64_t>, TimeTracker>::iterator entryIterator = logEntries.begin(); 
-      entryIterator != logEntries.end(); )
-  {
-    if(entryIterator->second.timeSinceCreation() > maxEntryLifetimeMs)
-    {
-      entryIterator = logEntries.erase(entryIterator);
-    }
-    else
-      ++entryIterator;
-  }
+  logEntries.eraseExpired([](const typename EspnowLogTable<U, TimeTracker>::value_type &entry) { return entry.second.timeSinceCreation(); }, 
+                          maxEntryLifetimeMs);
 }
 
-void EspnowDatabase::deleteExpiredLogEntries(std::map<std::pair<peerMac_td, messageID_td>, RequestData> &logEntries, const uint32_t requestLifetimeMs, const uint32_t broadcastLifetimeMs)
+void EspnowDatabase::deleteExpiredLogEntries(EspnowLogTable<peerMac_td, RequestData> &logEntries, const uint32_t requestLifetimeMs, const uint32_t broadcastLifetimeMs)
 {
-  for(typename std::map<std::pair<peerMac_td, messageID_td>, RequestData>::iterator entryIterator = logEntries.begin(); 
-      entryIterator != logEntries.end(); )
-  {
-    bool broadcast = entryIterator->first.first == EspnowProtocolInterpreter::uint64BroadcastMac;
-    uint32_t timeSinceCreation = entryIterator->second.getTimeTracker().timeSinceCreation();
-    
-    if((!broadcast && timeSinceCreation > requestLifetimeMs) 
-        || (broadcast && timeSinceCreation > broadcastLifetimeMs))
-    {
-      entryIterator = logEntries.erase(entryIterator);
-    }
-    else
-      ++entryIterator;
-  }
+  // Requests and broadcasts are stored in the same table, so expired broadcasts may be behind requests which are still alive.
+  logEntries.eraseExpired([](const EspnowLogTable<peerMac_td, RequestData>::value_type &entry) { return entry.second.getTimeTracker().timeSinceCreation(); }, 
+                          std::min(requestLifetimeMs, broadcastLifetimeMs),
+                          [requestLifetimeMs, broadcastLifetimeMs](const EspnowLogTable<peerMac_td, RequestData>::value_type &entry) { 
+                            return entry.first.first == EspnowProtocolInterpreter::uint64BroadcastMac ? broadcastLifetimeMs : requestLifetimeMs; 
+                          });
 }
 
 template <typename T>
@@ -183,6 +161,19 @@ void EspnowDatabase::setBroadcastResponseTimeoutMs(const uint32_t broadcastRespo
 }
 uint32_t EspnowDatabase::broadcastResponseTimeoutMs() { return _broadcastResponseTimeoutMs; }
 
+void EspnowDatabase::setLogEntryCapacity(const uint16_t logEntryCapacity)
+{
+  receivedEspnowTransmissions().setCapacity(logEntryCapacity);
+  sentRequests().setCapacity(logEntryCapacity);
+  receivedRequests().setCapacity(logEntryCapacity);
+}
+uint16_t EspnowDatabase::logEntryCapacity() { return receivedRequests().capacity(); }
+
+uint32_t EspnowDatabase::logEntriesEvicted()
+{
+  return receivedEspnowTransmissions().evicted() + sentRequests().evicted() + receivedRequests().evicted();
+}
+
 String EspnowDatabase::getScheduledResponseMessage(const uint32_t responseIndex)
 {
   return getScheduledResponse(responseIndex)->getMessage();
@@ -270,6 +261,14 @@ void EspnowDatabase::clearOldLogEntries(bool forced)
   deleteExpiredLogEntries(sentRequests(), logEntryLifetimeMs(), broadcastResponseTimeoutMs());
   deleteExpiredLogEntries(responsesToSend(), logEntryLifetimeMs());
   deleteExpiredLogEntries(peerRequestConfirmationsToSend(), getEncryptionRequestTimeout());
+
+  uint32_t evicted = logEntriesEvicted();
+  if(evicted != _logEntriesEvictedReported)
+  {
+    ConditionalPrinter::warningPrint(String(F("WARNING! ")) + String(evicted - _logEntriesEvictedReported) 
+                                     + String(F(" ESP-NOW log entries were evicted before expiring. Consider increasing logEntryCapacity().")));
+    _logEntriesEvictedReported = evicted;
+  }
 }
 
 std::list<ResponseData>::const_iterator EspnowDatabase::getScheduledResponse(const uint32_t responseIndex)
@@ -342,7 +341,7 @@ void EspnowDatabase::storeReceivedRequest(const uint64_t senderBSSID, const uint
 
 EspnowMeshBackend *EspnowDatabase::getOwnerOfSentRequest(const uint64_t requestMac, const uint64_t requestID)
 {
-  std::map<std::pair<peerMac_td, messageID_td>, RequestData>::iterator sentRequest = sentRequests().find(std::make_pair(requestMac, requestID));
+  auto sentRequest = sentRequests().find(std::make_pair(requestMac, requestID));
   
   if(sentRequest != sentRequests().end())
   {
@@ -359,25 +358,12 @@ size_t EspnowDatabase::deleteSentRequest(const uint64_t requestMac, const uint64
 
 size_t EspnowDatabase::deleteSentRequestsByOwner(const EspnowMeshBackend *instancePointer)
 {
-  size_t numberDeleted = 0;
-  
-  for(std::map<std::pair<peerMac_td, messageID_td>, RequestData>::iterator requestIterator = sentRequests().begin(); 
-      requestIterator != sentRequests().end(); )
-  {
-    if(&requestIterator->second.getMeshInstance() == instancePointer) // If instance at instancePointer made the request
-    {
-      requestIterator = sentRequests().erase(requestIterator);
-      numberDeleted++;
-    }
-    else
-      ++requestIterator;
-  }
-
-  return numberDeleted;
+  // If instance at instancePointer made the request
+  return sentRequests().eraseIf([instancePointer](const EspnowLogTable<peerMac_td, RequestData>::value_type &entry) { return &entry.second.getMeshInstance() == instancePointer; });
 }
 
 std::list<ResponseData> & EspnowDatabase::responsesToSend() { return _responsesToSend; }
 std::list<PeerRequestLog> & EspnowDatabase::peerRequestConfirmationsToSend() { return _peerRequestConfirmationsToSend; }
-std::map<std::pair<macAndType_td, messageID_td>, MessageData> & EspnowDatabase::receivedEspnowTransmissions() { return _receivedEspnowTransmissions; }
-std::map<std::pair<peerMac_td, messageID_td>, RequestData> & EspnowDatabase::sentRequests() { return _sentRequests; }
-std::map<std::pair<peerMac_td, messageID_td>, TimeTracker> & EspnowDatabase::receivedRequests() { return _receivedRequests; }
+EspnowLogTable<macAndType_td, MessageData> & EspnowDatabase::receivedEspnowTransmissions() { return _receivedEspnowTransmissions; }
+EspnowLogTable<peerMac_td, RequestData> & EspnowDatabase::sentRequests() { return _sentRequests; }
+EspnowLogTable<peerMac_td, TimeTracker> & EspnowDatabase::receivedRequests() { return _receivedRequests; }
@@ -24,7 +24,7 @@
 #include "RequestData.h"
 #include "EspnowProtocolInterpreter.h"
 #include <list>
-#include <map>
+#include "EspnowLogTable.h"
 #include "MessageData.h"
 #include "MutexTracker.h"
 #include "PeerRequestLog.h"
@@ -72,9 +72,26 @@ public:
   static size_t deleteSentRequestsByOwner(const EspnowMeshBackend *instancePointer);
   static std::list<ResponseData> & responsesToSend();
   static std::list<PeerRequestLog> & peerRequestConfirmationsToSend();
-  static std::map<std::pair<macAndType_td, messageID_td>, MessageData> & receivedEspnowTransmissions();
-  static std::map<std::pair<peerMac_td, messageID_td>, RequestData> & sentRequests();
-  static std::map<std::pair<peerMac_td, messageID_td>, TimeTracker> & receivedRequests();
+  static EspnowLogTable<macAndType_td, MessageData> & receivedEspnowTransmissions();
+  static EspnowLogTable<peerMac_td, RequestData> & sentRequests();
+  static EspnowLogTable<peerMac_td, TimeTracker> & receivedRequests();
+
+  /**
+   * Set the maximum number of entries in each of the receivedEspnowTransmissions, sentRequests and receivedRequests logs.
+   * When a log is full, its oldest entry is removed to make room for a new one. Defaults to 32.
+   * The logs used to be unbounded, entries only being removed after logEntryLifetimeMs(), so traffic which needs more entries
+   * than that now evicts them early. Such evictions are counted by logEntriesEvicted() and reported with a warning print.
+   * The storage of a log is allocated when its first entry is added, and released when ESP-NOW is deactivated.
+   *
+   * @param logEntryCapacity The maximum number of entries in a log. Clamped to [1, 8192].
+   */
+  static void setLogEntryCapacity(const uint16_t logEntryCapacity);
+  static uint16_t logEntryCapacity();
+
+  /**
+   * @return The number of entries removed from the logs before their expiry, to make room for new ones.
+   */
+  static uint32_t logEntriesEvicted();
   
   static bool requestReceived(const uint64_t requestMac, const uint64_t requestID);
 
@@ -127,67 +144,33 @@ public:
   uint8 getWiFiChannel() const;
   
   /**
-   * Remove all entries which target peerMac in the logEntries map.
+   * Remove all entries which target peerMac in the logEntries table.
    * Optionally deletes only entries sent/received by encrypted transmissions.
    * 
-   * @param logEntries The map to process.
+   * @param logEntries The table to process.
    * @param peerMac The MAC address of the peer node.
    * @param encryptedOnly If true, only entries sent/received by encrypted transmissions will be deleted.
    */
   template <typename T>
-  static void deleteEntriesByMac(std::map<std::pair<macAndType_td, uint64_t>, T> &logEntries, const uint8_t *peerMac, const bool encryptedOnly)
-  {    
-    bool macFound = false;
+  static void deleteEntriesByMac(EspnowLogTable<macAndType_td, T> &logEntries, const uint8_t *peerMac, const bool encryptedOnly)
+  {
+    uint64_t uint64PeerMac = MeshTypeConversionFunctions::macToUint64(peerMac);
     
-    for(typename std::map<std::pair<macAndType_td, uint64_t>, T>::iterator entryIterator = logEntries.begin(); 
-        entryIterator != logEntries.end(); )
-    {
-      if(macAndTypeToUint64Mac(entryIterator->first.first) == MeshTypeConversionFunctions::macToUint64(peerMac))
-      {
-        macFound = true;
-           
-        if(!encryptedOnly || EspnowProtocolInterpreter::usesEncryption(entryIterator->first.second))
-        {
-          entryIterator = logEntries.erase(entryIterator);
-          continue;
-        }
-      }
-      else if(macFound)
-      {
-        // Since the map is sorted by MAC, we know here that no more matching MAC will be found.
-        return;
-      }
-  
-      ++entryIterator;
-    }
+    logEntries.eraseIf([uint64PeerMac, encryptedOnly](const typename EspnowLogTable<macAndType_td, T>::value_type &entry) {
+      return macAndTypeToUint64Mac(entry.first.first) == uint64PeerMac 
+             && (!encryptedOnly || EspnowProtocolInterpreter::usesEncryption(entry.first.second));
+    });
   }
   
   template <typename T>
-  static void deleteEntriesByMac(std::map<std::pair<uint64_t, uint64_t>, T> &logEntries, const uint8_t *peerMac, const bool encryptedOnly)
-  {    
-    bool macFound = false;
+  static void deleteEntriesByMac(EspnowLogTable<uint64_t, T> &logEntries, const uint8_t *peerMac, const bool encryptedOnly)
+  {
+    uint64_t uint64PeerMac = MeshTypeConversionFunctions::macToUint64(peerMac);
     
-    for(typename std::map<std::pair<uint64_t, uint64_t>, T>::iterator entryIterator = logEntries.begin(); 
-        entryIterator != logEntries.end(); )
-    {
-      if(entryIterator->first.first == MeshTypeConversionFunctions::macToUint64(peerMac))
-      {
-        macFound = true;
-           
-        if(!encryptedOnly || EspnowProtocolInterpreter::usesEncryption(entryIterator->first.second))
-        {
-          entryIterator = logEntries.erase(entryIterator);
-          continue;
-        }
-      }
-      else if(macFound)
-      {
-        // Since the map is sorted by MAC, we know here that no more matching MAC will be found.
-        return;
-      }
-  
-      ++entryIterator;
-    }
+    logEntries.eraseIf([uint64PeerMac, encryptedOnly](const typename EspnowLogTable<uint64_t, T>::value_type &entry) {
+      return entry.first.first == uint64PeerMac 
+             && (!encryptedOnly || EspnowProtocolInterpreter::usesEncryption(entry.first.second));
+    });
   }
 
 protected:
@@ -204,12 +187,12 @@ private:
   uint32_t _autoEncryptionDuration = 50;
   
   template <typename T, typename U>
-  static void deleteExpiredLogEntries(std::map<std::pair<U, uint64_t>, T> &logEntries, const uint32_t maxEntryLifetimeMs);
+  static void deleteExpiredLogEntries(EspnowLogTable<U, T> &logEntries, const uint32_t maxEntryLifetimeMs);
 
   template <typename U>
-  static void deleteExpiredLogEntries(std::map<std::pair<U, uint64_t>, TimeTracker> &logEntries, const uint32_t maxEntryLifetimeMs);
+  static void deleteExpiredLogEntries(EspnowLogTable<U, TimeTracker> &logEntries, const uint32_t maxEntryLifetimeMs);
 
-  static void deleteExpiredLogEntries(std::map<std::pair<peerMac_td, messageID_td>, RequestData> &logEntries, const uint32_t requestLifetimeMs, const uint32_t broadcastLifetimeMs);
+  static void deleteExpiredLogEntries(EspnowLogTable<peerMac_td, RequestData> &logEntries, const uint32_t requestLifetimeMs, const uint32_t broadcastLifetimeMs);
 
   template <typename T>
   static void deleteExpiredLogEntries(std::list<T> &logEntries, const uint32_t maxEntryLifetimeMs);
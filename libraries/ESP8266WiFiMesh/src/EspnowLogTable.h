@@ -0,0 +1,334 @@
+/*
+  Copyright (C) 2020 esp8266/Arduino
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __ESPNOWLOGTABLE_H__
+#define __ESPNOWLOGTABLE_H__
+
+#include <stdint.h>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/**
+ * Fixed-capacity hash table used for the ESP-NOW logs (received transmissions, sent and received requests).
+ *
+ * Keys are (U, uint64_t) pairs, U being an uint64_t or an enum based on it. Lookups use open addressing (linear probing)
+ * in a bucket array twice as large as the capacity, so they are O(1). Entries are also linked from the oldest to the newest,
+ * which is the order used for iteration and allows expired entries to be removed without visiting the others.
+ *
+ * Storage is allocated on first insertion and released by clear(). When the table is full, inserting a new entry erases the oldest one,
+ * which is counted by evicted().
+ * Entries are never moved while stored, so iterators remain valid until their entry is erased.
+ */
+template <typename U, typename T>
+class EspnowLogTable
+{
+
+public:
+
+  using key_type = std::pair<U, uint64_t>;
+  using value_type = std::pair<const key_type, T>;
+
+  static constexpr uint16_t maxCapacity = 8192;
+
+  class iterator
+  {
+  public:
+    iterator(EspnowLogTable *table, const int16_t index) : _table(table), _index(index) {}
+    value_type &operator*() const { return *_table->_entries[_index].value; }
+    value_type *operator->() const { return &*_table->_entries[_index].value; }
+    iterator &operator++() { _index = _table->_entries[_index].newer; return *this; }
+    bool operator==(const iterator &other) const { return _index == other._index; }
+    bool operator!=(const iterator &other) const { return _index != other._index; }
+
+  private:
+    friend class EspnowLogTable;
+    EspnowLogTable *_table;
+    int16_t _index;
+  };
+
+  explicit EspnowLogTable(const uint16_t capacity) : _capacity(capacity) {}
+
+  /**
+   * Change the maximum number of entries. Stored entries are kept, except the oldest ones if they do not fit.
+   */
+  void setCapacity(uint16_t capacity)
+  {
+    if(capacity < 1)
+      capacity = 1;
+    else if(capacity > maxCapacity)
+      capacity = maxCapacity;
+
+    if(capacity == _capacity)
+      return;
+
+    EspnowLogTable resized(capacity);
+    for(int16_t index = _oldest; index >= 0; index = _entries[index].newer)
+      resized.insert(std::move(*_entries[index].value));
+    resized._evicted += _evicted;
+    *this = std::move(resized);
+  }
+
+  uint16_t capacity() const { return _capacity; }
+  uint16_t size() const { return _size; }
+  bool empty() const { return _size == 0; }
+
+  // Number of entries erased to make room for new ones, since the table was created. Not reset by clear().
+  uint32_t evicted() const { return _evicted; }
+
+  // From the oldest to the newest entry
+  iterator begin() { return iterator(this, _oldest); }
+  iterator end() { return iterator(this, -1); }
+
+  iterator find(const key_type &key)
+  {
+    int32_t bucket = findBucket(key);
+    return iterator(this, bucket < 0 ? -1 : _buckets[bucket]);
+  }
+
+  size_t count(const key_type &key) const { return findBucket(key) < 0 ? 0 : 1; }
+
+  /**
+   * Does nothing if key is already stored.
+   *
+   * @return An iterator to the entry with the same key, and whether the entry was inserted.
+   */
+  std::pair<iterator, bool> insert(value_type &&value)
+  {
+    return emplace(value.first, std::move(value.second));
+  }
+
+  std::pair<iterator, bool> insert(const value_type &value)
+  {
+    return emplace(value.first, value.second);
+  }
+
+  /**
+   * Construct a new entry in place, from args. Does nothing if key is already stored.
+   *
+   * @return An iterator to the entry with the same key, and whether the entry was inserted.
+   */
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(const key_type &key, Args&&... args)
+  {
+    int32_t bucket = findBucket(key);
+    if(bucket >= 0)
+      return std::make_pair(iterator(this, _buckets[bucket]), false);
+
+    if(_entries.empty())
+      allocate();
+    else if(_size == _capacity)
+    {
+      erase(begin());
+      ++_evicted;
+    }
+
+    int16_t index = _free;
+    Entry &entry = _entries[index];
+    _free = entry.newer;
+    entry.value.emplace(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+
+    for(bucket = home(key); _buckets[bucket] >= 0; bucket = (bucket + 1) & mask()) {}
+    _buckets[bucket] = index;
+
+    entry.older = _newest;
+    entry.newer = -1;
+    if(_newest >= 0)
+      _entries[_newest].newer = index;
+    else
+      _oldest = index;
+    _newest = index;
+    ++_size;
+
+    return std::make_pair(iterator(this, index), true);
+  }
+
+  /**
+   * @return An iterator to the entry following the erased one.
+   */
+  iterator erase(const iterator position)
+  {
+    iterator next(this, _entries[position._index].newer);
+    eraseBucket(findBucket(position->first));
+    return next;
+  }
+
+  size_t erase(const key_type &key)
+  {
+    int32_t bucket = findBucket(key);
+    if(bucket < 0)
+      return 0;
+
+    eraseBucket(bucket);
+    return 1;
+  }
+
+  /**
+   * Erase all entries for which predicate(entry) is true.
+   *
+   * @return The number of entries erased.
+   */
+  template <typename Predicate>
+  size_t eraseIf(Predicate predicate)
+  {
+    size_t numberErased = 0;
+
+    for(iterator entryIterator = begin(); entryIterator != end(); )
+    {
+      if(predicate(*entryIterator))
+      {
+        entryIterator = erase(entryIterator);
+        ++numberErased;
+      }
+      else
+        ++entryIterator;
+    }
+
+    return numberErased;
+  }
+
+  /**
+   * Erase entries whose age is above lifetimeMs(entry). Entries are visited from the oldest, and only while their age
+   * is above minLifetimeMs, so the cost depends on the number of entries which can have expired, not on the table size.
+   * Entries must be inserted in the order of their creation time.
+   *
+   * @param age Function returning the age in ms of an entry.
+   * @param minLifetimeMs The shortest lifetime any entry can have.
+   * @param lifetimeMs Function returning the lifetime in ms of an entry.
+   */
+  template <typename Age, typename Lifetime>
+  void eraseExpired(Age age, const uint32_t minLifetimeMs, Lifetime lifetimeMs)
+  {
+    for(iterator entryIterator = begin(); entryIterator != end(); )
+    {
+      uint32_t entryAge = age(*entryIterator);
+
+      if(entryAge <= minLifetimeMs)
+        return;
+
+      if(entryAge > lifetimeMs(*entryIterator))
+        entryIterator = erase(entryIterator);
+      else
+        ++entryIterator;
+    }
+  }
+
+  template <typename Age>
+  void eraseExpired(Age age, const uint32_t lifetimeMs)
+  {
+    eraseExpired(age, lifetimeMs, [lifetimeMs](const value_type &) { return lifetimeMs; });
+  }
+
+  // Also releases storage
+  void clear()
+  {
+    std::vector<Entry>().swap(_entries);
+    std::vector<int16_t>().swap(_buckets);
+    _oldest = _newest = _free = -1;
+    _size = 0;
+  }
+
+private:
+
+  struct Entry
+  {
+    std::optional<value_type> value;
+    int16_t older = -1;
+    int16_t newer = -1; // Also links free entries
+  };
+
+  void allocate()
+  {
+    _entries.resize(_capacity);
+    for(uint16_t index = 0; index < _capacity; ++index)
+      _entries[index].newer = index + 1 < _capacity ? index + 1 : -1;
+    _free = 0;
+
+    uint32_t buckets = 2;
+    while(buckets < 2 * (uint32_t)_capacity)
+      buckets *= 2;
+    _buckets.assign(buckets, -1);
+  }
+
+  uint32_t mask() const { return _buckets.size() - 1; }
+
+  uint32_t home(const key_type &key) const
+  {
+    uint64_t hash = static_cast<uint64_t>(key.first) * 0x9E3779B97F4A7C15ULL ^ key.second;
+    hash ^= hash >> 29;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    return (hash ^ (hash >> 32)) & mask();
+  }
+
+  int32_t findBucket(const key_type &key) const
+  {
+    if(_size == 0)
+      return -1;
+
+    for(uint32_t bucket = home(key); _buckets[bucket] >= 0; bucket = (bucket + 1) & mask())
+    {
+      if(_entries[_buckets[bucket]].value->first == key)
+        return bucket;
+    }
+
+    return -1;
+  }
+
+  void eraseBucket(uint32_t bucket)
+  {
+    int16_t index = _buckets[bucket];
+    Entry &entry = _entries[index];
+
+    if(entry.older >= 0)
+      _entries[entry.older].newer = entry.newer;
+    else
+      _oldest = entry.newer;
+    if(entry.newer >= 0)
+      _entries[entry.newer].older = entry.older;
+    else
+      _newest = entry.older;
+
+    entry.value.reset();
+    entry.older = -1;
+    entry.newer = _free;
+    _free = index;
+    --_size;
+
+    // Backward shift deletion: move following entries of the probe sequence into the hole when their home bucket allows it
+    for(uint32_t next = (bucket + 1) & mask(); _buckets[next] >= 0; next = (next + 1) & mask())
+    {
+      uint32_t nextHome = home(_entries[_buckets[next]].value->first);
+      if(((next - nextHome) & mask()) >= ((next - bucket) & mask()))
+      {
+        _buckets[bucket] = _buckets[next];
+        bucket = next;
+      }
+    }
+    _buckets[bucket] = -1;
+  }
+
+  std::vector<Entry> _entries;
+  std::vector<int16_t> _buckets;
+  int16_t _oldest = -1;
+  int16_t _newest = -1;
+  int16_t _free = -1;
+  uint16_t _capacity;
+  uint16_t _size = 0;
+  uint32_t _evicted = 0;
+};
+
+#endif
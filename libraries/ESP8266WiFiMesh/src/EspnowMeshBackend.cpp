@@ -402,7 +402,7 @@ void EspnowMeshBackend::espnowReceiveCallback(const uint8_t *macaddr, uint8_t *d
       if(acceptBroadcast)
       {
         // Does nothing if key already in receivedEspnowTransmissions
-        EspnowDatabase::receivedEspnowTransmissions().insert(std::make_pair(key, MessageData(message, getTransmissionsRemaining(dataArray))));
+        EspnowDatabase::receivedEspnowTransmissions().emplace(key, message, getTransmissionsRemaining(dataArray));
       }
       else
       {
@@ -412,12 +412,12 @@ void EspnowMeshBackend::espnowReceiveCallback(const uint8_t *macaddr, uint8_t *d
     else
     {  
       // Does nothing if key already in receivedEspnowTransmissions
-      EspnowDatabase::receivedEspnowTransmissions().insert(std::make_pair(std::make_pair(macAndType, messageID), MessageData(dataArray, len)));
+      EspnowDatabase::receivedEspnowTransmissions().emplace(std::make_pair(macAndType, messageID), dataArray, len);
     }
   }
   else
   {
-    std::map<std::pair<macAndType_td, messageID_td>, MessageData>::iterator storedMessageIterator = EspnowDatabase::receivedEspnowTransmissions().find(std::make_pair(macAndType, messageID));
+    auto storedMessageIterator = EspnowDatabase::receivedEspnowTransmissions().find(std::make_pair(macAndType, messageID));
 
     if(storedMessageIterator == EspnowDatabase::receivedEspnowTransmissions().end()) // If we have not stored the key already, we missed the first message part.
     {
@@ -446,7 +446,7 @@ void EspnowMeshBackend::espnowReceiveCallback(const uint8_t *macaddr, uint8_t *d
     return;
   }
 
-  std::map<std::pair<macAndType_td, messageID_td>, MessageData>::iterator storedMessageIterator = EspnowDatabase::receivedEspnowTransmissions().find(std::make_pair(macAndType, messageID));
+  auto storedMessageIterator = EspnowDatabase::receivedEspnowTransmissions().find(std::make_pair(macAndType, messageID));
   assert(storedMessageIterator != EspnowDatabase::receivedEspnowTransmissions().end());
 
   // Copy totalMessage in case user callbacks (request/responseHandler) do something odd with receivedEspnowTransmissions list.
@@ -522,6 +522,13 @@ void EspnowMeshBackend::setLogEntryLifetimeMs(const uint32_t logEntryLifetimeMs)
 }
 uint32_t EspnowMeshBackend::logEntryLifetimeMs() { return EspnowDatabase::logEntryLifetimeMs(); }
 
+void EspnowMeshBackend::setLogEntryCapacity(const uint16_t logEntryCapacity)
+{
+  EspnowDatabase::setLogEntryCapacity(logEntryCapacity);
+}
+uint16_t EspnowMeshBackend::logEntryCapacity() { return EspnowDatabase::logEntryCapacity(); }
+uint32_t EspnowMeshBackend::logEntriesEvicted() { return EspnowDatabase::logEntriesEvicted(); }
+
 void EspnowMeshBackend::setBroadcastResponseTimeoutMs(const uint32_t broadcastResponseTimeoutMs)
 {
   EspnowDatabase::setBroadcastResponseTimeoutMs(broadcastResponseTimeoutMs);
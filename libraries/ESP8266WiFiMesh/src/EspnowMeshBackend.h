@@ -341,6 +341,23 @@ public:
   static void setLogEntryLifetimeMs(const uint32_t logEntryLifetimeMs);
   static uint32_t logEntryLifetimeMs();
 
+  /**
+   * Set the maximum number of entries in each ESP-NOW message log (received transmissions, sent requests and received requests).
+   * When a log is full, its oldest entry is removed to make room for a new one, which may make the node receive the same transmission multiple times.
+   * 
+   * Set to 32 by default. Before this setting existed the logs had no size limit, entries were only removed after logEntryLifetimeMs().
+   * If logEntriesEvicted() keeps increasing (a warning is also printed), the capacity is too small for the ESP-NOW traffic of the node.
+   * 
+   * @param logEntryCapacity The maximum number of entries in each log. Clamped to [1, 8192].
+   */
+  static void setLogEntryCapacity(const uint16_t logEntryCapacity);
+  static uint16_t logEntryCapacity();
+
+  /**
+   * @return The number of entries removed from the ESP-NOW message logs before their expiry, because a log was full.
+   */
+  static uint32_t logEntriesEvicted();
+
   /**
    * Set the duration during which sent ESP-NOW broadcast are stored in the log and can receive responses.
    * This is shorter by default than logEntryLifetimeMs() in order to preserve RAM since broadcasts are always kept in the log until they expire,
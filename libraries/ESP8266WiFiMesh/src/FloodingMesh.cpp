@@ -25,6 +25,8 @@
 #include "FloodingMesh.h"
 #include "TypeConversionFunctions.h"
 #include "JsonTranslator.h"
+#include "TlvTranslator.h"
+#include "FloodingMeshMetadata.h"
 #include "Serializer.h"
 
 namespace
@@ -132,22 +134,28 @@ void FloodingMesh::performMeshInstanceMaintenance()
 {
   EspnowMeshBackend::performEspnowMaintenance(); 
   
-  for(std::list<std::pair<String, bool>>::iterator backlogIterator = getForwardingBacklog().begin();  backlogIterator != getForwardingBacklog().end(); )
+  String message;
+  bool encrypted;
+  
+  // Messages are removed from the backlog before being sent, since sending may add new messages to it.
+  while(getForwardingBacklog().pop(message, encrypted))
   {
-    std::pair<String, bool> &messageData = *backlogIterator;
-    if(messageData.second) // message encrypted
+    if(encrypted) // message encrypted
     {
-      getMacIgnoreList() = messageData.first.substring(0, 12) + ','; // The message should contain the messageID first
-      encryptedBroadcastKernel(messageData.first); 
+      uint64_t messageID = 0;
+      uint8_t originMacArray[6] = { 0 };
+      if(TlvTranslator::decode(message, FloodingMeshMetadata::messageIdType, messageID))
+        getMacIgnoreList() = TypeCast::macToString(TypeCast::uint64ToMac(messageID >> 16, originMacArray)) + ',';
+      else
+        getMacIgnoreList() = message.substring(0, 12) + ','; // The message should contain the messageID first
+      encryptedBroadcastKernel(message); 
       getMacIgnoreList() = emptyString;
     }
     else
     {
-      broadcastKernel(messageData.first);
+      broadcastKernel(message);
     }
 
-    backlogIterator = getForwardingBacklog().erase(backlogIterator);
-    
     EspnowMeshBackend::performEspnowMaintenance(); // It is best to performEspnowMaintenance frequently to keep the Espnow backend responsive. Especially if each encryptedBroadcast takes a lot of time.
   }
 }
@@ -183,15 +191,27 @@ String FloodingMesh::generateMessageID()
   return TypeCast::macToString(WiFi.softAPmacAddress(apMac)) + String(messageCountArray); // We use the AP MAC address as ID since it is what shows up during WiFi scans
 }
 
+uint64_t FloodingMesh::generateBinaryMessageID()
+{
+  uint8_t apMac[6] {0};
+  return TypeCast::macToUint64(WiFi.softAPmacAddress(apMac)) << 16 | _messageCount++;
+}
+
 void FloodingMesh::broadcast(const String &message)
 {
   assert(message.length() <= maxUnencryptedMessageLength());
   
-  String messageID = generateMessageID();
-
   // Remove getEspnowMeshBackend().getMeshName() from the metadata below to broadcast to all ESP-NOW nodes regardless of MeshName.
   String targetMeshName = getEspnowMeshBackend().getMeshName();
 
+  if(metadataFormat() == MetadataFormat::BINARY)
+  {
+    broadcastKernel(FloodingMeshMetadata::createBinaryMessage(&targetMeshName, generateBinaryMessageID(), message));
+    return;
+  }
+
+  String messageID = generateMessageID();
+
   broadcastKernel(targetMeshName + String(metadataDelimiter()) + messageID + String(metadataDelimiter()) + message);
 }
 
@@ -211,6 +231,12 @@ void FloodingMesh::encryptedBroadcast(const String &message)
 {
   assert(message.length() <= maxEncryptedMessageLength());
 
+  if(metadataFormat() == MetadataFormat::BINARY)
+  {
+    encryptedBroadcastKernel(FloodingMeshMetadata::createBinaryMessage(nullptr, generateBinaryMessageID(), message));
+    return;
+  }
+
   String messageID = generateMessageID();
   
   encryptedBroadcastKernel(messageID + String(metadataDelimiter()) + message);  
@@ -224,7 +250,6 @@ void FloodingMesh::encryptedBroadcastKernel(const String &message)
 void FloodingMesh::clearMessageLogs()
 {
   _messageIDs.clear();
-  std::queue<messageQueueElementType>().swap(_messageIdOrder);
 }
 
 void FloodingMesh::clearForwardingBacklog()
@@ -247,17 +272,26 @@ uint8_t *FloodingMesh::getOriginMac(uint8_t *macArray) const
   return macArray;
 }
 
-std::list<std::pair<String, bool>> &  FloodingMesh::getForwardingBacklog() { return _forwardingBacklog; }
+ForwardingBacklog & FloodingMesh::getForwardingBacklog() { return _forwardingBacklog; }
 
 String & FloodingMesh::getMacIgnoreList() { return _macIgnoreList; }
 
 uint32_t FloodingMesh::maxUnencryptedMessageLength() const
 {
+  if(metadataFormat() == MetadataFormat::BINARY)
+  {
+    String targetMeshName = getEspnowMeshBackendConst().getMeshName();
+    return getEspnowMeshBackendConst().getMaxMessageLength() - FloodingMeshMetadata::binaryMetadataLength(&targetMeshName);
+  }
+  
   return getEspnowMeshBackendConst().getMaxMessageLength() - MESSAGE_ID_LENGTH - (getEspnowMeshBackendConst().getMeshName().length() + 1); // Need room for mesh name + delimiter
 }
 
 uint32_t FloodingMesh::maxEncryptedMessageLength() const
 {
+  if(metadataFormat() == MetadataFormat::BINARY)
+    return getEspnowMeshBackendConst().getMaxMessageLength() - FloodingMeshMetadata::binaryMetadataLength(nullptr);
+
   // Need 1 extra delimiter character for maximum metadata efficiency (makes it possible to store exactly 18 MACs in metadata by adding an extra transmission)
   return getEspnowMeshBackendConst().getMaxMessageLength() - MESSAGE_ID_LENGTH - 1;
 }
@@ -265,9 +299,16 @@ uint32_t FloodingMesh::maxEncryptedMessageLength() const
 void FloodingMesh::setMessageLogSize(const uint16_t messageLogSize) 
 { 
   assert(messageLogSize >= 1);
-  _messageLogSize = messageLogSize; 
+  _messageIDs.setCapacity(messageLogSize); 
 }
-uint16_t FloodingMesh::messageLogSize() const { return _messageLogSize; }
+uint16_t FloodingMesh::messageLogSize() const { return _messageIDs.capacity(); }
+
+void FloodingMesh::setForwardingBacklogSize(const uint32_t forwardingBacklogSize) 
+{ 
+  getForwardingBacklog().setCapacity(forwardingBacklogSize); 
+}
+uint32_t FloodingMesh::forwardingBacklogSize() const { return _forwardingBacklog.capacity(); }
+uint32_t FloodingMesh::droppedForwardingMessages() const { return _forwardingBacklog.droppedMessages(); }
 
 void FloodingMesh::setMetadataDelimiter(const char metadataDelimiter) 
 { 
@@ -279,10 +320,16 @@ void FloodingMesh::setMetadataDelimiter(const char metadataDelimiter)
 
   // Reserved for encryptedBroadcast for now
   assert(metadataDelimiter != ',');
+
+  // Marks MetadataFormat::BINARY messages
+  assert(metadataDelimiter != TlvTranslator::tlvMarker);
   
   _metadataDelimiter = metadataDelimiter; 
 }
 char FloodingMesh::metadataDelimiter() { return _metadataDelimiter; }
+
+void FloodingMesh::setMetadataFormat(const MetadataFormat metadataFormat) { _metadataFormat = metadataFormat; }
+FloodingMesh::MetadataFormat FloodingMesh::metadataFormat() const { return _metadataFormat; }
   
 EspnowMeshBackend &FloodingMesh::getEspnowMeshBackend()
 {
@@ -300,12 +347,12 @@ bool FloodingMesh::insertPreliminaryMessageID(const uint64_t messageID)
   if(messageID >> 16 == TypeCast::macToUint64(WiFi.softAPmacAddress(apMacArray)))
     return false; // The node should not receive its own messages.
   
-  auto insertionResult = _messageIDs.emplace(messageID, 0); // Returns std::pair<iterator,bool>
+  uint8_t *receptions = _messageIDs.find(messageID);
 
-  if(insertionResult.second) // Insertion succeeded.
-    updateMessageQueue(insertionResult.first);
-  else if(insertionResult.first->second < getBroadcastReceptionRedundancy()) // messageID exists but not with desired redundancy
-    insertionResult.first->second++;
+  if(!receptions)
+    _messageIDs.insert(messageID, 0);
+  else if(*receptions < getBroadcastReceptionRedundancy()) // messageID exists but not with desired redundancy
+    ++*receptions;
   else
     return false; // messageID already existed in _messageIDs with desired redundancy
 
@@ -318,31 +365,18 @@ bool FloodingMesh::insertCompletedMessageID(const uint64_t messageID)
   if(messageID >> 16 == TypeCast::macToUint64(WiFi.softAPmacAddress(apMacArray)))
     return false; // The node should not receive its own messages.
   
-  auto insertionResult = _messageIDs.emplace(messageID, MESSAGE_COMPLETE); // Returns std::pair<iterator,bool>
+  uint8_t *receptions = _messageIDs.find(messageID);
 
-  if(insertionResult.second) // Insertion succeeded.
-    updateMessageQueue(insertionResult.first);
-  else if(insertionResult.first->second < MESSAGE_COMPLETE) // messageID exists but is not complete
-    insertionResult.first->second = MESSAGE_COMPLETE;
+  if(!receptions)
+    _messageIDs.insert(messageID, MESSAGE_COMPLETE);
+  else if(*receptions < MESSAGE_COMPLETE) // messageID exists but is not complete
+    *receptions = MESSAGE_COMPLETE;
   else
     return false; // messageID already existed in _messageIDs and is complete
 
   return true;
 }
 
-void FloodingMesh::updateMessageQueue(const messageQueueElementType messageIterator)
-{
-  _messageIdOrder.emplace(messageIterator);
-  
-  if(_messageIDs.size() > messageLogSize())
-  {
-    _messageIDs.erase(_messageIdOrder.front());
-    _messageIdOrder.pop();
-    assert(_messageIDs.size() == messageLogSize()); // If this is false we either have too many elements in messageIDs or we deleted too many elements.
-    assert(_messageIDs.size() == _messageIdOrder.size()); // The containers should always be in sync
-  }
-}
-
 void FloodingMesh::restoreDefaultRequestHandler()
 {
   getEspnowMeshBackend().setRequestHandler([this](const String &request, MeshBackendBase &meshInstance){ return _defaultRequestHandler(request, meshInstance); });
@@ -392,40 +426,58 @@ String FloodingMesh::_defaultRequestHandler(const String &request, MeshBackendBa
 {
   (void)meshInstance; // This is useful to remove a "unused parameter" compiler warning. Does nothing else.
   
-  String broadcastTarget;
-  String remainingRequest = request;
-  
-  if(request.charAt(0) == metadataDelimiter())
-  {
-    int32_t broadcastTargetEndIndex = request.indexOf(metadataDelimiter(), 1);
+  uint32_t metadataStartIndex = 0; // Excludes the broadcast identifier added by _defaultBroadcastFilter
+  int32_t messageStartIndex = -1;
+  uint64_t messageID = 0;
 
-    if(broadcastTargetEndIndex == -1)
-      return emptyString; // metadataDelimiter not found
+  if(TlvTranslator::isTlv(request))
+  {
+    messageStartIndex = FloodingMeshMetadata::getBinaryMessageIndex(request, messageID);
     
-    broadcastTarget = request.substring(1, broadcastTargetEndIndex + 1); // Include delimiter
-    remainingRequest.remove(0, broadcastTargetEndIndex + 1);
+    if(messageStartIndex < 0)
+      return emptyString; // Malformed metadata
   }
-  
-  int32_t messageIDEndIndex = remainingRequest.indexOf(metadataDelimiter());
+  else
+  {
+    int32_t messageIDStartIndex = 0;
+    
+    if(request.charAt(0) == metadataDelimiter())
+    {
+      int32_t broadcastTargetEndIndex = request.indexOf(metadataDelimiter(), 1);
 
-  if(messageIDEndIndex == -1)
-    return emptyString; // metadataDelimiter not found
+      if(broadcastTargetEndIndex == -1)
+        return emptyString; // metadataDelimiter not found
+      
+      metadataStartIndex = 1;
+      messageIDStartIndex = broadcastTargetEndIndex + 1; // Include delimiter in the broadcast target
+    }
+    
+    int32_t messageIDEndIndex = request.indexOf(metadataDelimiter(), messageIDStartIndex);
+
+    if(messageIDEndIndex == -1)
+      return emptyString; // metadataDelimiter not found
 
-  uint64_t messageID = TypeCast::stringToUint64(remainingRequest.substring(0, messageIDEndIndex));
+    messageID = TypeCast::stringToUint64(request.substring(messageIDStartIndex, messageIDEndIndex));
+    messageStartIndex = messageIDEndIndex + 1;
+  }
 
   if(insertCompletedMessageID(messageID))
   {
     uint8_t originMacArray[6] = { 0 };
     setOriginMac(TypeCast::uint64ToMac(messageID >> 16, originMacArray)); // messageID consists of MAC + 16 bit counter
   
-    String message = remainingRequest;
-    message.remove(0, messageIDEndIndex + 1); // This approach avoids the null value removal of substring()
+    String message = request;
+    message.remove(0, messageStartIndex); // This approach avoids the null value removal of substring()
     
     if(getMessageHandler()(message, *this))
     {
-      message = broadcastTarget + remainingRequest.substring(0, messageIDEndIndex + 1) + message;
-      assert(message.length() <= _espnowBackend.getMaxMessageLength());
-      getForwardingBacklog().emplace_back(message, getEspnowMeshBackend().receivedEncryptedTransmission());
+      // Forward the message with the metadata it was received with
+      String forwardedMessage;
+      forwardedMessage.reserve(messageStartIndex - metadataStartIndex + message.length());
+      forwardedMessage.concat(request.c_str() + metadataStartIndex, messageStartIndex - metadataStartIndex);
+      forwardedMessage += message;
+      assert(forwardedMessage.length() <= _espnowBackend.getMaxMessageLength());
+      getForwardingBacklog().push(forwardedMessage, getEspnowMeshBackend().receivedEncryptedTransmission());
     }
   }
   
@@ -502,6 +554,17 @@ bool FloodingMesh::_defaultBroadcastFilter(String &firstTransmission, EspnowMesh
   // and insertPreliminaryMessageID(messageID) returns true.
 
   // Broadcast firstTransmission String structure: targetMeshName+messageID+message.
+
+  if(TlvTranslator::isTlv(firstTransmission))
+  {
+    uint64_t messageID = 0;
+    
+    if(!FloodingMeshMetadata::acceptBinaryBroadcast(firstTransmission, meshInstance.getMeshName(), messageID))
+      return false; // Malformed metadata, or broadcast is for another mesh network
+
+    // No broadcast identifier is needed, since the target mesh name record is kept in the stored message.
+    return insertPreliminaryMessageID(messageID);
+  }
    
   int32_t metadataEndIndex = firstTransmission.indexOf(metadataDelimiter());
 
@@ -26,8 +26,9 @@
 #define __FLOODINGMESH_H__
 
 #include "EspnowMeshBackend.h"
+#include "MessageIdLog.h"
+#include "ForwardingBacklog.h"
 #include <set>
-#include <queue>
 
 /**
  * An alternative to standard delay(). Will continuously call performMeshMaintenance() during the waiting time, so that the FloodingMesh node remains responsive.
@@ -46,6 +47,12 @@ public:
 
   using messageHandlerType = std::function<bool(String &, FloodingMesh &)>;
 
+  enum class MetadataFormat
+  {
+    TEXT    = 0, // Delimited text, understood by every FloodingMesh version
+    BINARY  = 1  // TLV records, see TlvTranslator
+  };
+
   /**
    * FloodingMesh constructor method. Creates a FloodingMesh node, ready to be initialised.
    *
@@ -230,7 +237,8 @@ public:
  * The number of received messageID:s that will be stored by the node. Used to remember which messages have been received. 
  * Setting this too low will cause the same message to be received many times.
  * Setting this too high will cause the node to run out of RAM.
- * In practice, setting this value to more than 1337 is probably a bad idea since the node will run out of RAM quickly and crash as a result.
+ * Each messageID uses between 9 and 13 bytes, and the whole log is allocated when the first messageID is received.
+ * Changing the log size clears the log.
  * 
  * Defaults to 100.
  * 
@@ -241,6 +249,23 @@ public:
   void setMessageLogSize(const uint16_t messageLogSize);
   uint16_t messageLogSize() const;
 
+  /**
+   * The number of bytes used to store received messages waiting to be forwarded by the node. 
+   * Each message uses its length + 3 bytes. Messages received while there is no room left are not forwarded.
+   * Changing the size removes the messages waiting to be forwarded.
+   * 
+   * Defaults to 4096.
+   * 
+   * @param forwardingBacklogSize The size of the forwarding backlog in bytes.
+   */
+  void setForwardingBacklogSize(const uint32_t forwardingBacklogSize);
+  uint32_t forwardingBacklogSize() const;
+
+  /**
+   * @return The number of received messages which could not be forwarded because the forwarding backlog was full.
+   */
+  uint32_t droppedForwardingMessages() const;
+
   /**
    * Hint: Use String.length() to get the ASCII length of a String.
    * 
@@ -268,6 +293,17 @@ public:
   static void setMetadataDelimiter(const char metadataDelimiter);
   static char metadataDelimiter();
 
+  /**
+   * Set the format of the metadata (target mesh name and messageID) of the messages broadcast by this node.
+   * MetadataFormat::BINARY stores the metadata as TLV records instead of delimited hexadecimal text. This saves 4 bytes per message 
+   * and avoids converting messageIDs to and from text, but nodes using an older version of this library will ignore such messages.
+   * Messages are accepted in both formats, and forwarded in the format they were received in.
+   * 
+   * @param metadataFormat The metadata format to use. Defaults to MetadataFormat::TEXT.
+   */
+  void setMetadataFormat(const MetadataFormat metadataFormat);
+  MetadataFormat metadataFormat() const;
+
   /*
    * Gives you access to the EspnowMeshBackend used by the mesh node.
    * The backend handles all mesh communication, and modifying it allows you to change every aspect of the mesh behaviour.
@@ -286,11 +322,10 @@ public:
 
 protected:
 
-  using messageQueueElementType = std::map<uint64_t, uint8_t>::iterator;
-
   static std::set<FloodingMesh *> availableFloodingMeshes;
   
   String generateMessageID();
+  uint64_t generateBinaryMessageID();
 
   void broadcastKernel(const String &message);
 
@@ -298,7 +333,6 @@ protected:
 
   bool insertPreliminaryMessageID(const uint64_t messageID);
   bool insertCompletedMessageID(const uint64_t messageID);
-  void updateMessageQueue(const messageQueueElementType messageIterator);
   
   void loadMeshState(const String &serializedMeshState);
 
@@ -309,7 +343,7 @@ protected:
    */
   void setOriginMac(const uint8_t *macArray);
 
-  std::list<std::pair<String, bool>> & getForwardingBacklog();
+  ForwardingBacklog & getForwardingBacklog();
   
   String & getMacIgnoreList(); // Experimental, may break in the future.
   
@@ -319,9 +353,8 @@ private:
 
   messageHandlerType _messageHandler;
 
-  std::map<uint64_t, uint8_t> _messageIDs = {};
-  std::queue<messageQueueElementType> _messageIdOrder = {};
-  std::list<std::pair<String, bool>> _forwardingBacklog = {};
+  MessageIdLog _messageIDs{100};
+  ForwardingBacklog _forwardingBacklog{4096};
 
   String _macIgnoreList;
   
@@ -335,7 +368,8 @@ private:
   uint8_t _originMac[6] = {0};
   
   uint16_t _messageCount = 0;
-  uint16_t _messageLogSize = 100;
+
+  MetadataFormat _metadataFormat = MetadataFormat::TEXT;
 
   uint8_t _broadcastReceptionRedundancy = 2;
 };
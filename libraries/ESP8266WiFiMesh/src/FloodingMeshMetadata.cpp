@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2020 esp8266/Arduino
+ *
+ * License (MIT license):
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "FloodingMeshMetadata.h"
+#include "TlvTranslator.h"
+
+namespace FloodingMeshMetadata
+{
+  uint32_t binaryMetadataLength(const String *targetMeshName)
+  {
+    return 2 + (targetMeshName ? TlvTranslator::recordLength(targetMeshName->length()) : 0) + TlvTranslator::recordLength(8);
+  }
+
+  String createBinaryMessage(const String *targetMeshName, const uint64_t messageID, const String &message)
+  {
+    String binaryMessage;
+    if(!binaryMessage.reserve(binaryMetadataLength(targetMeshName) + message.length()))
+      return emptyString;
+
+    binaryMessage += TlvTranslator::tlvMarker;
+    if(targetMeshName)
+      TlvTranslator::appendRecord(binaryMessage, targetMeshNameType, *targetMeshName);
+    TlvTranslator::appendRecord(binaryMessage, messageIdType, messageID);
+    binaryMessage += TlvTranslator::endOfRecords;
+    binaryMessage += message;
+
+    return binaryMessage;
+  }
+
+  bool acceptBinaryBroadcast(const String &firstTransmission, const String &meshName, uint64_t &messageID)
+  {
+    uint16_t targetMeshNameLength = 0;
+    int32_t targetMeshNameIndex = TlvTranslator::getValueIndex(firstTransmission, targetMeshNameType, targetMeshNameLength);
+
+    if(targetMeshNameIndex < 0 || !TlvTranslator::decode(firstTransmission, messageIdType, messageID))
+      return false; // Malformed metadata
+
+    if(targetMeshNameLength != 0 && (targetMeshNameLength != meshName.length()
+                                     || memcmp(firstTransmission.c_str() + targetMeshNameIndex, meshName.c_str(), targetMeshNameLength) != 0))
+    {
+      return false; // Broadcast is for another mesh network
+    }
+
+    return true;
+  }
+
+  int32_t getBinaryMessageIndex(const String &request, uint64_t &messageID)
+  {
+    int32_t messageStartIndex = TlvTranslator::getEndIndex(request);
+
+    if(messageStartIndex < 0 || !TlvTranslator::decode(request, messageIdType, messageID))
+      return -1; // Malformed metadata
+
+    return messageStartIndex;
+  }
+}
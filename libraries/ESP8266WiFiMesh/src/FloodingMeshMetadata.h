@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2020 esp8266/Arduino
+ *
+ * License (MIT license):
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef __FLOODINGMESHMETADATA_H__
+#define __FLOODINGMESHMETADATA_H__
+
+#include <WString.h>
+
+/**
+ * FloodingMesh::MetadataFormat::BINARY messages: tlvMarker, target mesh name record (broadcasts only), messageID record, endOfRecords, message.
+ * See TlvTranslator.
+ */
+namespace FloodingMeshMetadata
+{
+  constexpr uint8_t targetMeshNameType = 1;
+  constexpr uint8_t messageIdType = 2;
+
+  /**
+   * @return The number of metadata bytes added to a message. targetMeshName is nullptr for encrypted broadcasts.
+   */
+  uint32_t binaryMetadataLength(const String *targetMeshName);
+
+  /**
+   * @return The message with its metadata, or an empty String if memory could not be allocated.
+   */
+  String createBinaryMessage(const String *targetMeshName, const uint64_t messageID, const String &message);
+
+  /**
+   * Broadcast filter part: checks the metadata of the first transmission of a broadcast.
+   *
+   * @param messageID Is set to the messageID of the broadcast if it is accepted.
+   *
+   * @return True if the metadata is valid and the target mesh name is empty or equal to meshName.
+   */
+  bool acceptBinaryBroadcast(const String &firstTransmission, const String &meshName, uint64_t &messageID);
+
+  /**
+   * Request handler part: decodes the messageID of a complete message.
+   *
+   * @return The index of the message body, or a negative value if the metadata is malformed.
+   */
+  int32_t getBinaryMessageIndex(const String &request, uint64_t &messageID);
+}
+
+#endif
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2020 esp8266/Arduino
+ *
+ * License (MIT license):
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "ForwardingBacklog.h"
+
+ForwardingBacklog::ForwardingBacklog(const uint32_t capacity) : _capacity(capacity)
+{
+}
+
+void ForwardingBacklog::setCapacity(const uint32_t capacity)
+{
+  _buffer.reset();
+  _capacity = capacity;
+  clear();
+}
+
+uint32_t ForwardingBacklog::capacity() const { return _capacity; }
+bool ForwardingBacklog::empty() const { return _size == 0; }
+uint32_t ForwardingBacklog::size() const { return _size; }
+uint32_t ForwardingBacklog::droppedMessages() const { return _droppedMessages; }
+
+bool ForwardingBacklog::push(const String &message, const bool encrypted)
+{
+  uint32_t length = message.length();
+  uint32_t recordLength = recordHeaderLength + length;
+  uint32_t position;
+
+  if(length > UINT16_MAX)
+    position = UINT32_MAX;
+  else if(!_wrapped && _capacity - _tail >= recordLength)
+    position = _tail;
+  else if(!_wrapped && _head >= recordLength)
+    position = 0; // Wrap around
+  else if(_wrapped && _head - _tail >= recordLength)
+    position = _tail;
+  else
+    position = UINT32_MAX;
+
+  if(position == UINT32_MAX)
+  {
+    ++_droppedMessages;
+    return false;
+  }
+
+  if(!_buffer)
+  {
+    _buffer.reset(new (std::nothrow) uint8_t[_capacity]);
+    if(!_buffer)
+    {
+      ++_droppedMessages;
+      return false;
+    }
+  }
+
+  if(position == 0 && _tail != 0)
+  {
+    _end = _tail;
+    _wrapped = true;
+  }
+
+  uint8_t *record = _buffer.get() + position;
+  record[0] = length;
+  record[1] = length >> 8;
+  record[2] = encrypted;
+  memcpy(record + recordHeaderLength, message.c_str(), length);
+
+  _tail = position + recordLength;
+  if(!_wrapped)
+    _end = _tail;
+  ++_size;
+
+  return true;
+}
+
+bool ForwardingBacklog::pop(String &message, bool &encrypted)
+{
+  if(_size == 0)
+    return false;
+
+  const uint8_t *record = _buffer.get() + _head;
+  uint32_t length = record[0] | (record[1] << 8);
+  encrypted = record[2];
+  if(length == 0)
+  {
+    message = emptyString;
+  }
+  else
+  {
+    message.clear(); // Keeps the buffer
+    message.concat((const char *)record + recordHeaderLength, length);
+  }
+
+  _head += recordHeaderLength + length;
+  if(_wrapped && _head == _end)
+  {
+    _head = 0;
+    _wrapped = false;
+    _end = _tail;
+  }
+
+  if(--_size == 0)
+    clear();
+
+  return true;
+}
+
+void ForwardingBacklog::clear()
+{
+  _head = _tail = _end = 0;
+  _size = 0;
+  _wrapped = false;
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2020 esp8266/Arduino
+ *
+ * License (MIT license):
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef __FLOODINGMESHFORWARDINGBACKLOG_H__
+#define __FLOODINGMESHFORWARDINGBACKLOG_H__
+
+#include <Arduino.h>
+#include <memory>
+
+/**
+ * FIFO of messages waiting to be forwarded by a FloodingMesh node.
+ *
+ * Messages are stored as raw bytes in a ring buffer of fixed size, allocated on first use, so that a burst of
+ * received messages cannot exhaust the heap. A message which does not fit in the remaining space is dropped.
+ */
+class ForwardingBacklog {
+
+public:
+
+  explicit ForwardingBacklog(const uint32_t capacity);
+
+  /**
+   * Change the size of the buffer, in bytes. Messages already stored are discarded.
+   */
+  void setCapacity(const uint32_t capacity);
+  uint32_t capacity() const;
+
+  bool empty() const;
+  uint32_t size() const; // Number of messages
+  uint32_t droppedMessages() const; // Number of messages dropped because the buffer was full
+
+  /**
+   * @return True if the message was stored. False if it was dropped.
+   */
+  bool push(const String &message, const bool encrypted);
+
+  /**
+   * Remove the oldest message.
+   *
+   * @param message Filled with the message. Its buffer is reused, so the same String should be given to successive calls.
+   * @param encrypted Set to whether the message was received in an encrypted transmission.
+   * @return False if the backlog is empty.
+   */
+  bool pop(String &message, bool &encrypted);
+
+  void clear();
+
+private:
+
+  static constexpr uint32_t recordHeaderLength = 3; // uint16_t length and flags
+
+  std::unique_ptr<uint8_t[]> _buffer;
+  uint32_t _capacity;
+  uint32_t _head = 0; // oldest message
+  uint32_t _tail = 0; // where next message is written
+  uint32_t _end = 0;  // end of data before the ring wraps
+  uint32_t _size = 0;
+  uint32_t _droppedMessages = 0;
+  bool _wrapped = false;
+};
+
+#endif
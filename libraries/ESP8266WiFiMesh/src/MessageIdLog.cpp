@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2020 esp8266/Arduino
+ *
+ * License (MIT license):
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "MessageIdLog.h"
+
+MessageIdLog::MessageIdLog(const uint16_t capacity) : _capacity(capacity)
+{
+}
+
+void MessageIdLog::setCapacity(const uint16_t capacity)
+{
+  clear();
+  _capacity = capacity;
+}
+
+uint16_t MessageIdLog::capacity() const { return _capacity; }
+uint16_t MessageIdLog::size() const { return _size; }
+
+uint32_t MessageIdLog::hash(const uint64_t messageID)
+{
+  uint64_t hash = messageID * 0x9E3779B97F4A7C15ULL;
+  return hash ^ (hash >> 32);
+}
+
+uint32_t MessageIdLog::home(const uint32_t hash) const
+{
+  // The low bits of the message ID counter end up in the high bits of the hash
+  return (hash ^ (hash >> 16)) & _bucketMask;
+}
+
+void MessageIdLog::allocate()
+{
+  uint32_t buckets = 2;
+  while(buckets < 2 * (uint32_t)_capacity)
+    buckets *= 2;
+
+  _hashes.reset(new uint32_t[_capacity]);
+  _states.reset(new uint8_t[_capacity]);
+  _buckets.reset(new uint16_t[buckets]());
+  _bucketMask = buckets - 1;
+}
+
+uint8_t *MessageIdLog::find(const uint64_t messageID)
+{
+  if(_size == 0)
+    return nullptr;
+
+  uint32_t idHash = hash(messageID);
+  for(uint32_t bucket = home(idHash); _buckets[bucket]; bucket = (bucket + 1) & _bucketMask)
+  {
+    uint16_t position = _buckets[bucket] - 1;
+    if(_hashes[position] == idHash)
+      return &_states[position];
+  }
+
+  return nullptr;
+}
+
+uint8_t *MessageIdLog::insert(const uint64_t messageID, const uint8_t state)
+{
+  if(!_hashes)
+    allocate();
+  else if(_size == _capacity)
+    eraseOldest();
+
+  uint16_t position = _next;
+  _next = _next + 1 < _capacity ? _next + 1 : 0;
+  ++_size;
+
+  uint32_t idHash = hash(messageID);
+  _hashes[position] = idHash;
+  _states[position] = state;
+
+  uint32_t bucket = home(idHash);
+  while(_buckets[bucket])
+    bucket = (bucket + 1) & _bucketMask;
+  _buckets[bucket] = position + 1;
+
+  return &_states[position];
+}
+
+void MessageIdLog::eraseOldest()
+{
+  uint16_t position = _next;
+  uint32_t bucket = home(_hashes[position]);
+  while(_buckets[bucket] != position + 1)
+    bucket = (bucket + 1) & _bucketMask;
+  --_size;
+
+  // Backward shift deletion: move following entries of the probe sequence into the hole when their home bucket allows it
+  for(uint32_t next = (bucket + 1) & _bucketMask; _buckets[next]; next = (next + 1) & _bucketMask)
+  {
+    uint32_t nextHome = home(_hashes[_buckets[next] - 1]);
+    if(((next - nextHome) & _bucketMask) >= ((next - bucket) & _bucketMask))
+    {
+      _buckets[bucket] = _buckets[next];
+      bucket = next;
+    }
+  }
+  _buckets[bucket] = 0;
+}
+
+void MessageIdLog::clear()
+{
+  _hashes.reset();
+  _states.reset();
+  _buckets.reset();
+  _bucketMask = 0;
+  _size = 0;
+  _next = 0;
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2020 esp8266/Arduino
+ *
+ * License (MIT license):
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef __FLOODINGMESHMESSAGEIDLOG_H__
+#define __FLOODINGMESHMESSAGEIDLOG_H__
+
+#include <stdint.h>
+#include <memory>
+
+/**
+ * Bounded log of received FloodingMesh message IDs, with a state byte for each ID.
+ *
+ * IDs are stored as 32 bit hashes in a ring of fixed capacity, the oldest ID being replaced when the ring is full.
+ * An open addressing index makes lookups O(1). Memory usage is 9 to 13 bytes per ID, allocated on first insertion.
+ * Two different IDs sharing the same hash while both being in the log would be considered equal, which is very unlikely
+ * with a few hundred IDs.
+ */
+class MessageIdLog {
+
+public:
+
+  explicit MessageIdLog(const uint16_t capacity);
+
+  /**
+   * Change the number of IDs remembered. This clears the log.
+   */
+  void setCapacity(const uint16_t capacity);
+  uint16_t capacity() const;
+  uint16_t size() const;
+
+  /**
+   * @return A pointer to the state of messageID, or nullptr if messageID is not in the log.
+   */
+  uint8_t *find(const uint64_t messageID);
+
+  /**
+   * Add messageID to the log, replacing the oldest ID if the log is full. messageID must not already be in the log.
+   *
+   * @return A pointer to the state of messageID.
+   */
+  uint8_t *insert(const uint64_t messageID, const uint8_t state);
+
+  void clear();
+
+private:
+
+  static uint32_t hash(const uint64_t messageID);
+  uint32_t home(const uint32_t hash) const;
+  void allocate();
+  void eraseOldest();
+
+  std::unique_ptr<uint32_t[]> _hashes; // ring of IDs
+  std::unique_ptr<uint8_t[]> _states;
+  std::unique_ptr<uint16_t[]> _buckets; // ring position + 1, 0 when empty
+  uint32_t _bucketMask = 0;
+  uint16_t _capacity;
+  uint16_t _size = 0;
+  uint16_t _next = 0; // ring position of the next ID, which is also the oldest when the ring is full
+};
+
+#endif
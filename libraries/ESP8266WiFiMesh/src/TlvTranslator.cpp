@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2020 esp8266/Arduino
+ *
+ * License (MIT license):
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "TlvTranslator.h"
+
+namespace
+{
+  /**
+   * Read the record starting at recordIndex.
+   *
+   * @return The index of the next record, or a negative value if the record is truncated.
+   */
+  int32_t readRecord(const String &tlvString, uint32_t recordIndex, uint8_t &type, uint32_t &valueIndex, uint16_t &valueLength)
+  {
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(tlvString.c_str());
+    const uint32_t length = tlvString.length();
+
+    if(recordIndex + 2 > length)
+      return -1;
+
+    type = data[recordIndex];
+    valueLength = data[recordIndex + 1];
+    valueIndex = recordIndex + 2;
+
+    if(valueLength & 0x80)
+    {
+      if(valueIndex >= length)
+        return -1;
+
+      valueLength = (valueLength & 0x7F) << 8 | data[valueIndex++];
+    }
+
+    if(valueIndex + valueLength > length)
+      return -1;
+
+    return valueIndex + valueLength;
+  }
+
+  /**
+   * Walk the records of tlvString until one of the given type is found, or until endOfRecords if type is 0.
+   *
+   * @return For a record, the index of its value. For endOfRecords, the index following it. A negative value if not found.
+   */
+  int32_t findRecord(const String &tlvString, const uint8_t type, uint16_t &valueLength)
+  {
+    if(!TlvTranslator::isTlv(tlvString))
+      return -1;
+
+    int32_t recordIndex = 1;
+
+    while((uint32_t)recordIndex < tlvString.length())
+    {
+      if(tlvString[recordIndex] == TlvTranslator::endOfRecords)
+        return type == 0 ? recordIndex + 1 : -1;
+
+      uint8_t recordType = 0;
+      uint32_t valueIndex = 0;
+      recordIndex = readRecord(tlvString, recordIndex, recordType, valueIndex, valueLength);
+
+      if(recordIndex < 0)
+        return -1;
+
+      if(recordType == type)
+        return valueIndex;
+    }
+
+    return -1; // endOfRecords missing
+  }
+}
+
+namespace TlvTranslator
+{
+  bool isTlv(const String &tlvString)
+  {
+    return tlvString.length() > 0 && tlvString[0] == tlvMarker;
+  }
+
+  uint16_t recordLength(const uint16_t valueLength)
+  {
+    return (valueLength < 0x80 ? 2 : 3) + valueLength;
+  }
+
+  bool appendRecord(String &tlvString, const uint8_t type, const uint8_t *value, const uint16_t valueLength)
+  {
+    assert(type != 0);
+    assert(valueLength <= maxValueLength);
+
+    char header[3] = { (char)type, (char)valueLength, 0 };
+    uint8_t headerLength = 2;
+
+    if(valueLength >= 0x80)
+    {
+      header[1] = (char)(0x80 | valueLength >> 8);
+      header[2] = (char)(valueLength & 0xFF);
+      headerLength = 3;
+    }
+
+    if(!tlvString.reserve(tlvString.length() + headerLength + valueLength))
+      return false;
+
+    tlvString.concat(header, headerLength);
+    tlvString.concat(reinterpret_cast<const char *>(value), valueLength);
+    return true;
+  }
+
+  bool appendRecord(String &tlvString, const uint8_t type, const String &value)
+  {
+    return appendRecord(tlvString, type, reinterpret_cast<const uint8_t *>(value.c_str()), value.length());
+  }
+
+  bool appendRecord(String &tlvString, const uint8_t type, const uint64_t value)
+  {
+    uint8_t valueArray[8];
+    for(uint8_t i = 0; i < 8; ++i)
+      valueArray[i] = value >> (56 - 8*i);
+
+    return appendRecord(tlvString, type, valueArray, sizeof valueArray);
+  }
+
+  int32_t getValueIndex(const String &tlvString, const uint8_t type, uint16_t &valueLength)
+  {
+    assert(type != 0);
+
+    return findRecord(tlvString, type, valueLength);
+  }
+
+  int32_t getEndIndex(const String &tlvString)
+  {
+    uint16_t valueLength = 0;
+    return findRecord(tlvString, 0, valueLength);
+  }
+
+  bool decode(const String &tlvString, const uint8_t type, String &value)
+  {
+    uint16_t valueLength = 0;
+    int32_t valueIndex = getValueIndex(tlvString, type, valueLength);
+    if(valueIndex < 0)
+      return false;
+
+    if(valueLength == 0)
+    {
+      value = emptyString;
+    }
+    else
+    {
+      value.clear();
+      value.concat(tlvString.c_str() + valueIndex, valueLength); // substring() would stop at the first null value
+    }
+
+    return true;
+  }
+
+  bool decode(const String &tlvString, const uint8_t type, uint64_t &value)
+  {
+    uint16_t valueLength = 0;
+    int32_t valueIndex = getValueIndex(tlvString, type, valueLength);
+    if(valueIndex < 0 || valueLength < 1 || valueLength > 8)
+      return false;
+
+    const uint8_t *valueArray = reinterpret_cast<const uint8_t *>(tlvString.c_str() + valueIndex);
+    uint64_t result = 0;
+    for(uint16_t i = 0; i < valueLength; ++i)
+      result = result << 8 | valueArray[i];
+
+    value = result;
+    return true;
+  }
+}
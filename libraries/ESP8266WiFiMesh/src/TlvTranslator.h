@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2020 esp8266/Arduino
+ *
+ * License (MIT license):
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef __ESPNOWTLVTRANSLATOR_H__
+#define __ESPNOWTLVTRANSLATOR_H__
+
+#include <WString.h>
+
+/**
+ * Compact binary alternative to JsonTranslator, for metadata which is sent with every message.
+ *
+ * A TLV String starts with tlvMarker, followed by any number of records and ends with endOfRecords.
+ * Each record consists of a type byte (1 to 255), the length of the value (one byte if below 128, otherwise
+ * two bytes with the MSB of the first one set) and the value bytes. Values may contain any byte, including 0.
+ * Anything following endOfRecords is not part of the encoding, so a message body can be appended without any length field.
+ */
+namespace TlvTranslator
+{
+  constexpr char tlvMarker = 1; // Start of Heading (SOH) control character in ASCII
+  constexpr char endOfRecords = 0;
+  constexpr uint16_t maxValueLength = 0x7FFF;
+
+  /**
+   * @return True if tlvString starts with tlvMarker.
+   */
+  bool isTlv(const String &tlvString);
+
+  /**
+   * @return The number of bytes used by a record with a value of valueLength bytes.
+   */
+  uint16_t recordLength(const uint16_t valueLength);
+
+  /**
+   * Append a record to tlvString. tlvString should already contain tlvMarker.
+   *
+   * @param tlvString The String to append to.
+   * @param type The record type. Must not be 0.
+   * @param value The value bytes.
+   * @param valueLength The number of value bytes. Must not exceed maxValueLength.
+   *
+   * @return True if the record was appended. False if memory could not be allocated.
+   */
+  bool appendRecord(String &tlvString, const uint8_t type, const uint8_t *value, const uint16_t valueLength);
+  bool appendRecord(String &tlvString, const uint8_t type, const String &value);
+
+  /**
+   * Append a record containing value as 8 bytes, most significant byte first.
+   */
+  bool appendRecord(String &tlvString, const uint8_t type, const uint64_t value);
+
+  /**
+   * Provides the index within tlvString where the value of the first record of the given type starts.
+   *
+   * @param tlvString The String to search within.
+   * @param type The record type to search for.
+   * @param valueLength Is set to the length of the value if the record was found.
+   *
+   * @return An int32_t containing the index within tlvString where the value starts, or a negative value if the record was not found or tlvString is malformed.
+   */
+  int32_t getValueIndex(const String &tlvString, const uint8_t type, uint16_t &valueLength);
+
+  /**
+   * Provides the index within tlvString following endOfRecords, i.e. where any appended message body starts.
+   *
+   * @return An int32_t containing the index, or a negative value if tlvString is malformed.
+   */
+  int32_t getEndIndex(const String &tlvString);
+
+  /**
+   * Get the value of a record from a TLV String.
+   *
+   * @param tlvString The String to search within.
+   * @param type The record type to search for.
+   * @param value The variable to put the result in.
+   *
+   * @return True if a value was found. False otherwise. The value argument is not modified if false is returned.
+   */
+  bool decode(const String &tlvString, const uint8_t type, String &value);
+
+  /**
+   * Get the value of a record from a TLV String. The value must be 1 to 8 bytes long, most significant byte first.
+   *
+   * @return True if a value was found. False otherwise. The value argument is not modified if false is returned.
+   */
+  bool decode(const String &tlvString, const uint8_t type, uint64_t &value);
+}
+
+#endif
@@ -135,6 +135,8 @@ String ESP8266HTTPUpdate::getLastErrorString(void)
         return F("New Binary Does Not Fit Flash Size");
     case HTTP_UE_SERVER_UNAUTHORIZED:
         return F("Unauthorized (401)");
+    case HTTP_UE_RESUME_FAILED:
+        return F("Resumed Update Does Not Match");
     }
 
     return String();
@@ -170,6 +172,8 @@ HTTPUpdateResult ESP8266HTTPUpdate::handleUpdate(HTTPClient& http, const String&
         http.addHeader(F("x-ESP8266-mode"), F("spiffs"));
     } else {
         http.addHeader(F("x-ESP8266-mode"), F("sketch"));
+        // a delta patch against the running sketch may be sent instead (see tools/delta.py)
+        http.addHeader(F("x-ESP8266-delta"), F("1"));
     }
 
     if(currentVersion && currentVersion[0] != 0x00) {
@@ -186,7 +190,19 @@ HTTPUpdateResult ESP8266HTTPUpdate::handleUpdate(HTTPClient& http, const String&
         http.setAuthorization(_auth.c_str());
     }
 
-    const char * headerkeys[] = { "x-MD5" };
+    int command = spiffs ? U_FS : U_FLASH;
+    String resumeMD5;
+    size_t resumeSize = 0;
+    size_t resumeFrom = 0;
+    if(_resumeUpdates) {
+        resumeFrom = UpdaterClass::resumableProgress(&resumeMD5, &resumeSize, command);
+        if(resumeFrom) {
+            DEBUG_HTTP_UPDATE("[httpUpdate] resume from %zu of %zu\n", resumeFrom, resumeSize);
+            http.addHeader(F("Range"), String(F("bytes=")) + resumeFrom + '-');
+        }
+    }
+
+    const char * headerkeys[] = { "x-MD5", "Content-Range" };
     size_t headerkeyssize = sizeof(headerkeys) / sizeof(char*);
 
     // track these headers
@@ -221,19 +237,38 @@ HTTPUpdateResult ESP8266HTTPUpdate::handleUpdate(HTTPClient& http, const String&
         DEBUG_HTTP_UPDATE("[httpUpdate]  - current version: %s\n", currentVersion.c_str() );
     }
 
+    // the rest of the interrupted update: the same image, from where it stopped
+    uint32_t offset = 0;
+    if(code == HTTP_CODE_PARTIAL_CONTENT && resumeFrom) {
+        unsigned first, last, total;
+        if(sscanf(http.header("Content-Range").c_str(), "bytes %u-%u/%u", &first, &last, &total) == 3
+                && first == resumeFrom && total == resumeSize && len > 0 && (size_t)len == total - first
+                && http.header("x-MD5").equalsIgnoreCase(resumeMD5)) {
+            offset = first;
+            code = HTTP_CODE_OK;
+        } else {
+            DEBUG_HTTP_UPDATE("[httpUpdate] partial content does not match the interrupted update\n");
+            UpdaterClass::clearResumable();
+            _setLastError(HTTP_UE_RESUME_FAILED);
+            http.end();
+            return HTTP_UPDATE_FAILED;
+        }
+    }
+
     switch(code) {
     case HTTP_CODE_OK:  ///< OK (Start Update)
         if(len > 0) {
             bool startUpdate = true;
+            uint32_t size = offset + len;
             if(spiffs) {
                 size_t spiffsSize = ((size_t)FS_end - (size_t)FS_start);
-                if(len > (int) spiffsSize) {
-                    DEBUG_HTTP_UPDATE("[httpUpdate] spiffsSize to low (%d) needed: %d\n", spiffsSize, len);
+                if(size > spiffsSize) {
+                    DEBUG_HTTP_UPDATE("[httpUpdate] spiffsSize to low (%d) needed: %d\n", spiffsSize, size);
                     startUpdate = false;
                 }
             } else {
-                if(len > (int) ESP.getFreeSketchSpace()) {
-                    DEBUG_HTTP_UPDATE("[httpUpdate] FreeSketchSpace to low (%d) needed: %d\n", ESP.getFreeSketchSpace(), len);
+                if(size > ESP.getFreeSketchSpace()) {
+                    DEBUG_HTTP_UPDATE("[httpUpdate] FreeSketchSpace to low (%d) needed: %d\n", ESP.getFreeSketchSpace(), size);
                     startUpdate = false;
                 }
             }
@@ -256,17 +291,14 @@ HTTPUpdateResult ESP8266HTTPUpdate::handleUpdate(HTTPClient& http, const String&
 
                 delay(100);
 
-                int command;
-
                 if(spiffs) {
-                    command = U_FS;
                     DEBUG_HTTP_UPDATE("[httpUpdate] runUpdate filesystem...\n");
                 } else {
-                    command = U_FLASH;
                     DEBUG_HTTP_UPDATE("[httpUpdate] runUpdate flash...\n");
                 }
 
-                if(!spiffs) {
+                // a resumed update doesn't start with the header, checked the first time
+                if(!spiffs && !offset) {
                     uint8_t buf[4];
                     if(tcp->peekBytes(&buf[0], 4) != 4) {
                         DEBUG_HTTP_UPDATE("[httpUpdate] peekBytes magic header failed\n");
@@ -276,7 +308,7 @@ HTTPUpdateResult ESP8266HTTPUpdate::handleUpdate(HTTPClient& http, const String&
                     }
 
                     // check for valid first magic byte
-                    if(buf[0] != 0xE9 && buf[0] != 0x1f) {
+                    if(buf[0] != 0xE9 && buf[0] != 0x1f && buf[0] != UPDATE_DELTA_MAGIC) {
                         DEBUG_HTTP_UPDATE("[httpUpdate] Magic header does not start with 0xE9\n");
                         _setLastError(HTTP_UE_BIN_VERIFY_HEADER_FAILED);
                         http.end();
@@ -300,7 +332,7 @@ HTTPUpdateResult ESP8266HTTPUpdate::handleUpdate(HTTPClient& http, const String&
                     }
 #endif
                 }
-                if(runUpdate(*tcp, len, http.header("x-MD5"), command)) {
+                if(runUpdate(*tcp, size, http.header("x-MD5"), command, offset)) {
                     ret = HTTP_UPDATE_OK;
                     DEBUG_HTTP_UPDATE("[httpUpdate] Update ok\n");
                     http.end();
@@ -361,9 +393,11 @@ HTTPUpdateResult ESP8266HTTPUpdate::handleUpdate(HTTPClient& http, const String&
  * @param in Stream&
  * @param size uint32_t
  * @param md5 String
+ * @param command int
+ * @param offset uint32_t where an interrupted update is resumed, the stream holds the rest
  * @return true if Update ok
  */
-bool ESP8266HTTPUpdate::runUpdate(Stream& in, uint32_t size, const String& md5, int command)
+bool ESP8266HTTPUpdate::runUpdate(Stream& in, uint32_t size, const String& md5, int command, uint32_t offset)
 {
 
     StreamString error;
@@ -372,7 +406,16 @@ bool ESP8266HTTPUpdate::runUpdate(Stream& in, uint32_t size, const String& md5,
         Update.onProgress(_cbProgress);
     }
 
-    if(!Update.begin(size, command, _ledPin, _ledOn)) {
+    if(!offset && _resumeUpdates) {
+        // a new update, whatever was interrupted before
+        // (RTC user memory is left alone when updates are not resumed)
+        UpdaterClass::clearResumable();
+    }
+
+    bool resumable = _resumeUpdates && md5.length() == 32;
+    bool started = resumable ? Update.beginResumable(size, md5.c_str(), command, _ledPin, _ledOn)
+                             : Update.begin(size, command, _ledPin, _ledOn);
+    if(!started) {
         _setLastError(Update.getError());
         Update.printError(error);
         error.trim(); // remove line ending
@@ -380,11 +423,21 @@ bool ESP8266HTTPUpdate::runUpdate(Stream& in, uint32_t size, const String& md5,
         return false;
     }
 
+    if(Update.progress() != offset) {
+        Update.end();
+        if(_resumeUpdates) {
+            UpdaterClass::clearResumable();
+        }
+        _setLastError(HTTP_UE_RESUME_FAILED);
+        DEBUG_HTTP_UPDATE("[httpUpdate] Update resumed at %zu instead of %u\n", Update.progress(), offset);
+        return false;
+    }
+
     if (_cbProgress) {
-        _cbProgress(0, size);
+        _cbProgress(offset, size);
     }
 
-    if(md5.length()) {
+    if(!resumable && md5.length()) {
         if(!Update.setMD5(md5.c_str())) {
             _setLastError(HTTP_UE_SERVER_FAULTY_MD5);
             DEBUG_HTTP_UPDATE("[httpUpdate] Update.setMD5 failed! (%s)\n", md5.c_str());
@@ -392,7 +445,7 @@ bool ESP8266HTTPUpdate::runUpdate(Stream& in, uint32_t size, const String& md5,
         }
     }
 
-    if(Update.writeStream(in) != size) {
+    if(Update.writeStream(in) != size - offset) {
         _setLastError(Update.getError());
         Update.printError(error);
         error.trim(); // remove line ending
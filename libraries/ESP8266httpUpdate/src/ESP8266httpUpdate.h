@@ -53,6 +53,7 @@ constexpr int HTTP_UE_SERVER_FAULTY_MD5         = (-105);
 constexpr int HTTP_UE_BIN_VERIFY_HEADER_FAILED  = (-106);
 constexpr int HTTP_UE_BIN_FOR_WRONG_FLASH       = (-107);
 constexpr int HTTP_UE_SERVER_UNAUTHORIZED       = (-108);
+constexpr int HTTP_UE_RESUME_FAILED            = (-109);
 
 enum HTTPUpdateResult {
     HTTP_UPDATE_FAILED,
@@ -102,6 +103,15 @@ public:
         _closeConnectionsOnUpdate = sever;
     }
 
+    /**
+     * Resume an interrupted update where it stopped, with an HTTP range
+     * request, when the server sends the same image (x-MD5) again.
+     */
+    void resumeUpdates(bool resume)
+    {
+        _resumeUpdates = resume;
+    }
+
     void setLedPin(int ledPin = -1, uint8_t ledOn = HIGH)
     {
         _ledPin = ledPin;
@@ -127,7 +137,7 @@ public:
 
 protected:
     t_httpUpdate_return handleUpdate(HTTPClient& http, const String& currentVersion, bool spiffs = false);
-    bool runUpdate(Stream& in, uint32_t size, const String& md5, int command = U_FLASH);
+    bool runUpdate(Stream& in, uint32_t size, const String& md5, int command = U_FLASH, uint32_t offset = 0);
 
     // Set the error and potentially use a CB to notify the application
     void _setLastError(int err) {
@@ -139,6 +149,7 @@ protected:
     int _lastError;
     bool _rebootOnUpdate = true;
     bool _closeConnectionsOnUpdate = true;
+    bool _resumeUpdates = false;
     String _user;
     String _password;
     String _auth;
@@ -134,6 +134,8 @@ bool MDNSResponder::close(void)
         _releaseServices();
         _releaseUDPContext();
         _releaseHostname();
+        m_AnswerCache.clear();
+        m_Arena.clear();
 
         bResult = true;
     }
@@ -304,6 +306,7 @@ bool MDNSResponder::setServiceName(const MDNSResponder::hMDNSService p_hService,
                         (MDNS_DOMAIN_LABEL_MAXLENGTH >= os_strlen(p_pcInstanceName))) &&
                        ((pService = _findService(p_hService))) &&
                        (pService->setName(p_pcInstanceName)) &&
+                       (m_AnswerCache.invalidate()) &&
                        ((pService->m_ProbeInformation.m_ProbingStatus = ProbingStatus_ReadyToStart)));
     DEBUG_EX_ERR(if (!bResult)
 {
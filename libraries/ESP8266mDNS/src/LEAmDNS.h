@@ -170,6 +170,30 @@ namespace MDNSImplementation
 */
 #define MDNS_UDPCONTEXT_TIMEOUT  50
 
+/*
+    Size of the arena holding the records read from received messages
+    (records not fitting into the arena are allocated on the heap; 0: no arena)
+*/
+#ifndef MDNS_ARENA_SIZE
+#define MDNS_ARENA_SIZE                 1536
+#endif
+/*
+    Maximum number of host and service domains remembered for name compression in one message
+*/
+#ifndef MDNS_DOMAIN_CACHE_SIZE
+#define MDNS_DOMAIN_CACHE_SIZE          12
+#endif
+/*
+    Number of prebuilt answer messages (0: answers are always composed)
+*/
+#ifndef MDNS_ANSWER_CACHE_SIZE
+#define MDNS_ANSWER_CACHE_SIZE          4
+#endif
+/*
+    Maximum length of the key identifying a prebuilt answer message (6 bytes + 1 byte per service)
+*/
+#define MDNS_ANSWER_CACHE_KEY_LENGTH    24
+
 /**
     MDNSResponder
 */
@@ -611,10 +635,82 @@ public:
     };
 protected:
 
+    /**
+        stcMDNSPacketReader
+
+        Bounds checked reading of the received message, directly from its pbuf chain
+        (the message isn't copied). Offsets are relative to the message start.
+    */
+    struct stcMDNSPacketReader
+    {
+        const pbuf*             m_pFirst;           // First pbuf of the message
+        const pbuf*             m_pCurrent;         // pbuf holding (or preceding) the read position
+        uint16_t                m_u16CurrentStart;  // Message offset of m_pCurrent
+        uint16_t                m_u16Offset;        // Read position
+        uint16_t                m_u16Length;        // Message length
+
+        stcMDNSPacketReader(void);
+
+        bool begin(const pbuf* p_pFirst);
+        bool end(void);
+
+        uint16_t tell(void) const;
+        uint16_t available(void) const;
+        bool seek(uint16_t p_u16Offset);
+        bool skip(uint16_t p_u16Length);
+
+        bool read(unsigned char* p_pBuffer,
+                  uint16_t p_u16Length);
+    };
+
+    /**
+        stcMDNSArena
+    */
+    struct stcMDNSArena
+    {
+        stcMDNSArena*           m_pNext;            // All arenas (to find the owner of an allocation)
+        uint8_t*                m_pu8Buffer;        // Allocated with the first allocation, kept until clear()
+        uint16_t                m_u16Offset;        // Start of the free part of the buffer
+        uint16_t                m_u16Allocations;   // Live allocations, the arena is reset when reaching 0
+
+        stcMDNSArena(void);
+        ~stcMDNSArena(void);
+
+        bool clear(void);
+
+        void* alloc(size_t p_stSize);
+        bool owns(const void* p_pMemory) const;
+        bool release(const void* p_pMemory);
+
+        static stcMDNSArena* owner(const void* p_pMemory);
+        static char* allocChars(const void* p_pOwner,
+                                size_t p_stLength);
+        static void releaseChars(char* p_pcChars);
+
+    protected:
+        static stcMDNSArena*    s_pArenas;
+    };
+
+    /**
+        stcMDNSArenaObject
+
+        Objects created with 'new (arena) T' are placed in the arena (or on the heap, if the arena is full).
+        'delete' works for both.
+    */
+    struct stcMDNSArenaObject
+    {
+        static void* operator new(size_t p_stSize) noexcept;
+        static void* operator new(size_t p_stSize,
+                                  stcMDNSArena& p_rArena) noexcept;
+        static void operator delete(void* p_pObject);
+        static void operator delete(void* p_pObject,
+                                    stcMDNSArena& p_rArena);
+    };
+
     /**
         stcMDNSServiceTxt
     */
-    struct stcMDNSServiceTxt
+    struct stcMDNSServiceTxt : public stcMDNSArenaObject
     {
         stcMDNSServiceTxt* m_pNext;
         char*              m_pcKey;
@@ -824,7 +920,7 @@ protected:
     /**
         stcMDNS_RRAnswer
     */
-    struct stcMDNS_RRAnswer
+    struct stcMDNS_RRAnswer : public stcMDNSArenaObject
     {
         stcMDNS_RRAnswer*   m_pNext;
         const enuAnswerType m_AnswerType;
@@ -1164,14 +1260,9 @@ protected:
         */
         struct stcDomainCacheItem
         {
-            stcDomainCacheItem*     m_pNext;
             const void*             m_pHostnameOrService;   // Opaque id for host or service domain (pointer)
             bool                    m_bAdditionalData;      // Opaque flag for special info (service domain included)
             uint16_t                m_u16Offset;            // Offset in UDP output buffer
-
-            stcDomainCacheItem(const void* p_pHostnameOrService,
-                               bool p_bAdditionalData,
-                               uint32_t p_u16Offset);
         };
 
     public:
@@ -1185,7 +1276,8 @@ protected:
         bool                    m_bUnicast;                 // Flag: Unicast response
         bool                    m_bUnannounce;              // Flag: Unannounce service
         uint16_t                m_u16Offset;                // Current offset in UDP write buffer (mainly for domain cache)
-        stcDomainCacheItem*     m_pDomainCacheItems;        // Cached host and service domains
+        stcDomainCacheItem      m_aDomainCacheItems[MDNS_DOMAIN_CACHE_SIZE];   // Cached host and service domains
+        uint8_t                 m_u8DomainCacheItems;       // Number of cached domains
 
         stcMDNSSendParameter(void);
         ~stcMDNSSendParameter(void);
@@ -1202,6 +1294,56 @@ protected:
                                         bool p_bAdditionalData) const;
     };
 
+    /**
+        stcMDNSAnswerCache
+
+        Prebuilt (name compressed) answer messages, for the answers not depending on a query ID
+        or on dynamic TXT items.
+        An entry is identified by a key made of the interface IP address, the host and service
+        reply masks and the flags of the send parameter; it is rebuilt, when host, service or TXT
+        data changed since it was built (the cache generation is increased on every change).
+    */
+    struct stcMDNSAnswerCache
+    {
+        /**
+            stcEntry
+        */
+        struct stcEntry
+        {
+            uint8_t                 m_au8Key[MDNS_ANSWER_CACHE_KEY_LENGTH];
+            uint8_t                 m_u8KeyLength;
+            uint32_t                m_u32Generation;    // Cache generation when built
+            uint32_t                m_u32LastUse;       // For replacement
+            unsigned char*          m_pucMessage;
+            uint16_t                m_u16Length;        // Message length
+            uint16_t                m_u16Size;          // Allocated size of m_pucMessage
+
+            stcEntry(void);
+            ~stcEntry(void);
+
+            bool clear(void);
+            bool append(const unsigned char* p_pcBuffer,
+                        size_t p_stLength);
+        };
+
+        stcEntry                    m_aEntries[MDNS_ANSWER_CACHE_SIZE];
+        uint32_t                    m_u32Generation;
+        uint32_t                    m_u32Uses;
+        stcEntry*                   m_pBuilding;        // Entry currently filled by _udpAppendBuffer
+        bool                        m_bBuildFailed;
+
+        stcMDNSAnswerCache(void);
+
+        bool clear(void);
+        bool invalidate(void);
+
+        const stcEntry* find(const uint8_t* p_pu8Key,
+                             uint8_t p_u8KeyLength);
+        stcEntry* startBuilding(const uint8_t* p_pu8Key,
+                                uint8_t p_u8KeyLength);
+        bool finishBuilding(bool p_bSuccess);
+    };
+
     // Instance variables
     stcMDNSService*                 m_pServices;
     UdpContext*                     m_pUDPContext;
@@ -1209,6 +1351,9 @@ protected:
     stcMDNSServiceQuery*            m_pServiceQueries;
     MDNSDynamicServiceTxtCallbackFunc m_fnServiceTxtCallback;
     stcProbeInformation             m_HostProbeInformation;
+    stcMDNSArena                    m_Arena;
+    stcMDNSAnswerCache              m_AnswerCache;
+    stcMDNSPacketReader             m_Reader;
 
     /** CONTROL **/
     /* MAINTENANCE */
@@ -1218,6 +1363,8 @@ protected:
     /* RECEIVING */
     bool _parseMessage(void);
     bool _parseQuery(const stcMDNS_MsgHeader& p_Header);
+    bool _readKnownRRAnswer(const stcMDNSSendParameter& p_SendParameter,
+                            stcMDNS_RRAnswer*& p_rpKnownRRAnswer);
 
     bool _parseResponse(const stcMDNS_MsgHeader& p_Header);
     bool _processAnswers(const stcMDNS_RRAnswer* p_pPTRAnswers);
@@ -1258,6 +1405,11 @@ protected:
     bool _sendMDNSMessage_Multicast(MDNSResponder::stcMDNSSendParameter& p_rSendParameter);
     bool _prepareMDNSMessage(stcMDNSSendParameter& p_SendParameter,
                              IPAddress p_IPAddress);
+    bool _composeMDNSMessage(stcMDNSSendParameter& p_SendParameter,
+                             IPAddress p_IPAddress);
+    uint8_t _answerCacheKey(const stcMDNSSendParameter& p_SendParameter,
+                            IPAddress p_IPAddress,
+                            uint8_t* p_pu8Key) const;
     bool _sendMDNSServiceQuery(const stcMDNSServiceQuery& p_ServiceQuery);
     bool _sendMDNSQuery(const stcMDNS_RRDomain& p_QueryDomain,
                         uint16_t p_u16QueryType,
@@ -1272,6 +1424,14 @@ protected:
     /* RESOURCE RECORD */
     bool _readRRQuestion(stcMDNS_RRQuestion& p_rQuestion);
     bool _readRRAnswer(stcMDNS_RRAnswer*& p_rpAnswer);
+    bool _readRRAnswerHeader(stcMDNS_RRHeader& p_rHeader,
+                             uint32_t& p_ru32TTL,
+                             uint16_t& p_ru16RDLength);
+    bool _readRRAnswerContent(const stcMDNS_RRHeader& p_Header,
+                              uint32_t p_u32TTL,
+                              uint16_t p_u16RDLength,
+                              stcMDNS_RRAnswer*& p_rpAnswer);
+    bool _skipRRAnswerContent(uint16_t p_u16RDLength);
 #ifdef MDNS_IP4_SUPPORT
     bool _readRRAnswerA(stcMDNS_RRAnswerA& p_rRRAnswerA,
                         uint16_t p_u16RDLength);
@@ -1291,8 +1451,6 @@ protected:
 
     bool _readRRHeader(stcMDNS_RRHeader& p_rHeader);
     bool _readRRDomain(stcMDNS_RRDomain& p_rRRDomain);
-    bool _readRRDomain_Loop(stcMDNS_RRDomain& p_rRRDomain,
-                            uint8_t p_u8Depth);
     bool _readRRAttributes(stcMDNS_RRAttributes& p_rAttributes);
 
     /* DOMAIN NAMES */
@@ -122,6 +122,7 @@ bool MDNSResponder::_parseMessage(void)
     bool    bResult = false;
 
     stcMDNS_MsgHeader   header;
+    m_Reader.begin(m_pUDPContext->getRxBuffer());   // The message is parsed in place
     if (_readMDNSMsgHeader(header))
     {
         if (0 == header.m_4bOpcode)     // A standard query
@@ -148,6 +149,7 @@ bool MDNSResponder::_parseMessage(void)
         DEBUG_EX_ERR(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _parseMessage: FAILED to read header\n")););
         m_pUDPContext->flush();
     }
+    m_Reader.end();
     DEBUG_EX_INFO(
         unsigned    uFreeHeap = ESP.getFreeHeap();
         DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _parseMessage: Done (%s after %lu ms, ate %i bytes, remaining %u)\n\n"), (bResult ? "Succeeded" : "FAILED"), (millis() - ulStartTime), (uStartMemory - uFreeHeap), uFreeHeap);
@@ -312,8 +314,8 @@ bool MDNSResponder::_parseQuery(const MDNSResponder::stcMDNS_MsgHeader& p_MsgHea
     for (uint32_t an = 0; ((bResult) && (an < u32Answers)); ++an)
     {
         stcMDNS_RRAnswer*   pKnownRRAnswer = 0;
-        if (((bResult = _readRRAnswer(pKnownRRAnswer))) &&
-                (pKnownRRAnswer))
+        if (((bResult = _readKnownRRAnswer(sendParameter, pKnownRRAnswer))) &&
+                (pKnownRRAnswer))                                       // Not skipped
         {
 
             if ((DNS_RRTYPE_ANY != pKnownRRAnswer->m_Header.m_Attributes.m_u16Type) &&      // No ANY type answer
@@ -527,7 +529,7 @@ bool MDNSResponder::_parseQuery(const MDNSResponder::stcMDNS_MsgHeader& p_MsgHea
                 }   // for services
             }   // ANY answers
         }
-        else
+        else if (!bResult)
         {
             DEBUG_EX_ERR(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _parseQuery: FAILED to read known answer!\n")););
         }
@@ -592,6 +594,53 @@ bool MDNSResponder::_parseQuery(const MDNSResponder::stcMDNS_MsgHeader& p_MsgHea
     return bResult;
 }
 
+/*
+    MDNSResponder::_readKnownRRAnswer
+
+    Reads a known answer of a query, if it might be of interest for '_parseQuery':
+    it matches a planned (host or service) reply and has got a long enough TTL, or a tiebreak
+    is needed for its domain. Else the answer content is skipped (without allocating the answer)
+    and 'p_rpKnownRRAnswer' stays 0.
+
+*/
+bool MDNSResponder::_readKnownRRAnswer(const MDNSResponder::stcMDNSSendParameter& p_SendParameter,
+                                       MDNSResponder::stcMDNS_RRAnswer*& p_rpKnownRRAnswer)
+{
+
+    stcMDNS_RRHeader    header;
+    uint32_t            u32TTL;
+    uint16_t            u16RDLength;
+    bool    bResult = _readRRAnswerHeader(header, u32TTL, u16RDLength);
+    if (bResult)
+    {
+        bool    bInteresting = false;
+        if ((DNS_RRTYPE_ANY != header.m_Attributes.m_u16Type) &&    // ANY type or class answers are ignored
+                (DNS_RRCLASS_ANY != header.m_Attributes.m_u16Class))
+        {
+            stcMDNS_RRDomain    domain;
+
+            bInteresting = (((p_SendParameter.m_u8HostReplyMask & _replyMaskForHost(header)) &&
+                             ((MDNS_HOST_TTL / 2) <= u32TTL)) ||
+                            ((m_HostProbeInformation.m_bTiebreakNeeded) &&
+                             (_buildDomainForHost(m_pcHostname, domain)) &&
+                             (header.m_Domain == domain)));
+            for (stcMDNSService* pService = m_pServices; ((!bInteresting) && (pService)); pService = pService->m_pNext)
+            {
+                bInteresting = (((pService->m_u8ReplyMask & _replyMaskForService(header, *pService)) &&
+                                 ((MDNS_SERVICE_TTL / 2) <= u32TTL)) ||
+                                ((pService->m_ProbeInformation.m_bTiebreakNeeded) &&
+                                 (_buildDomainForService(*pService, true, domain)) &&
+                                 (header.m_Domain == domain)));
+            }
+        }
+        bResult = ((bInteresting)
+                   ? _readRRAnswerContent(header, u32TTL, u16RDLength, p_rpKnownRRAnswer)
+                   : _skipRRAnswerContent(u16RDLength));
+    }
+    DEBUG_EX_ERR(if (!bResult) DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readKnownRRAnswer: FAILED!\n")););
+    return bResult;
+}
+
 /*
     MDNSResponder::_parseResponse
 
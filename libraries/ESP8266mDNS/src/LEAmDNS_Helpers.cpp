@@ -361,6 +361,7 @@ bool MDNSResponder::_setHostname(const char* p_pcHostname)
     bool    bResult = false;
 
     _releaseHostname();
+    m_AnswerCache.invalidate();
 
     size_t  stLength = 0;
     if ((p_pcHostname) &&
@@ -432,6 +433,7 @@ MDNSResponder::stcMDNSService* MDNSResponder::_allocService(const char* p_pcName
         // Add to list (or start list)
         pService->m_pNext = m_pServices;
         m_pServices = pService;
+        m_AnswerCache.invalidate();
     }
     return pService;
 }
@@ -446,6 +448,8 @@ bool MDNSResponder::_releaseService(MDNSResponder::stcMDNSService* p_pService)
 
     if (p_pService)
     {
+        m_AnswerCache.invalidate();
+
         stcMDNSService* pPred = m_pServices;
         while ((pPred) &&
                 (pPred->m_pNext != p_pService))
@@ -579,6 +583,10 @@ MDNSResponder::stcMDNSServiceTxt* MDNSResponder::_allocServiceTxt(MDNSResponder:
 
             // Add to list (or start list)
             p_pService->m_Txts.add(pTxt);
+            if (!p_bTemp)   // Dynamic TXT items are never part of prebuilt answers
+            {
+                m_AnswerCache.invalidate();
+            }
         }
     }
     return pTxt;
@@ -591,6 +599,11 @@ bool MDNSResponder::_releaseServiceTxt(MDNSResponder::stcMDNSService* p_pService
                                        MDNSResponder::stcMDNSServiceTxt* p_pTxt)
 {
 
+    if ((p_pTxt) &&
+            (!p_pTxt->m_bTemp))
+    {
+        m_AnswerCache.invalidate();
+    }
     return ((p_pService) &&
             (p_pTxt) &&
             (p_pService->m_Txts.remove(p_pTxt)));
@@ -611,6 +624,11 @@ MDNSResponder::stcMDNSServiceTxt* MDNSResponder::_updateServiceTxt(MDNSResponder
                                            (p_pTxt->m_pcValue ? strlen(p_pTxt->m_pcValue) : 0) +
                                            (p_pcValue ? strlen(p_pcValue) : 0))))
     {
+        if ((!p_bTemp) ||
+                (!p_pTxt->m_bTemp))
+        {
+            m_AnswerCache.invalidate();
+        }
         p_pTxt->update(p_pcValue);
         p_pTxt->m_bTemp = p_bTemp;
     }
@@ -22,6 +22,8 @@
 
 */
 
+#include <new>
+
 #include "ESP8266mDNS.h"
 #include "LEAmDNS_Priv.h"
 #include "LEAmDNS_lwIPdefs.h"
@@ -39,6 +41,359 @@ namespace MDNSImplementation
     STRUCTS
 */
 
+/**
+    MDNSResponder::stcMDNSPacketReader
+
+    Reads the received message directly from the pbuf chain of the UDP context.
+    Every access is checked against the message length; the current pbuf is remembered,
+    so sequential reads don't walk the chain from its start. Moving backwards (for
+    compression pointers) restarts the walk at the first pbuf.
+*/
+
+/*
+    MDNSResponder::stcMDNSPacketReader::stcMDNSPacketReader constructor
+*/
+MDNSResponder::stcMDNSPacketReader::stcMDNSPacketReader(void)
+{
+
+    end();
+}
+
+/*
+    MDNSResponder::stcMDNSPacketReader::begin
+*/
+bool MDNSResponder::stcMDNSPacketReader::begin(const pbuf* p_pFirst)
+{
+
+    m_pFirst = p_pFirst;
+    m_pCurrent = p_pFirst;
+    m_u16CurrentStart = 0;
+    m_u16Offset = 0;
+    m_u16Length = (p_pFirst ? p_pFirst->tot_len : 0);
+    return (0 != m_pFirst);
+}
+
+/*
+    MDNSResponder::stcMDNSPacketReader::end
+*/
+bool MDNSResponder::stcMDNSPacketReader::end(void)
+{
+
+    begin(0);
+    return true;
+}
+
+/*
+    MDNSResponder::stcMDNSPacketReader::tell
+*/
+uint16_t MDNSResponder::stcMDNSPacketReader::tell(void) const
+{
+
+    return m_u16Offset;
+}
+
+/*
+    MDNSResponder::stcMDNSPacketReader::available
+*/
+uint16_t MDNSResponder::stcMDNSPacketReader::available(void) const
+{
+
+    return (m_u16Length - m_u16Offset);
+}
+
+/*
+    MDNSResponder::stcMDNSPacketReader::seek
+*/
+bool MDNSResponder::stcMDNSPacketReader::seek(uint16_t p_u16Offset)
+{
+
+    bool    bResult = (p_u16Offset <= m_u16Length);
+    if (bResult)
+    {
+        if (p_u16Offset < m_u16CurrentStart)
+        {
+            // Backwards beyond the current pbuf: restart at the first one
+            m_pCurrent = m_pFirst;
+            m_u16CurrentStart = 0;
+        }
+        m_u16Offset = p_u16Offset;
+    }
+    return bResult;
+}
+
+/*
+    MDNSResponder::stcMDNSPacketReader::skip
+*/
+bool MDNSResponder::stcMDNSPacketReader::skip(uint16_t p_u16Length)
+{
+
+    return ((p_u16Length <= available()) &&
+            (seek(m_u16Offset + p_u16Length)));
+}
+
+/*
+    MDNSResponder::stcMDNSPacketReader::read
+*/
+bool MDNSResponder::stcMDNSPacketReader::read(unsigned char* p_pBuffer,
+                                              uint16_t p_u16Length)
+{
+
+    bool    bResult = (p_u16Length <= available());
+    while ((bResult) &&
+            (p_u16Length))
+    {
+        // Move to the pbuf holding the read position
+        while ((m_pCurrent) &&
+                ((m_u16CurrentStart + m_pCurrent->len) <= m_u16Offset))
+        {
+            m_u16CurrentStart += m_pCurrent->len;
+            m_pCurrent = m_pCurrent->next;
+        }
+        if ((bResult = (0 != m_pCurrent)))
+        {
+            uint16_t    u16InPBuf = (m_u16Offset - m_u16CurrentStart);
+            uint16_t    u16Chunk = (m_pCurrent->len - u16InPBuf);
+            if (u16Chunk > p_u16Length)
+            {
+                u16Chunk = p_u16Length;
+            }
+
+            memcpy(p_pBuffer, ((const unsigned char*)m_pCurrent->payload) + u16InPBuf, u16Chunk);
+            p_pBuffer += u16Chunk;
+            p_u16Length -= u16Chunk;
+            m_u16Offset += u16Chunk;
+        }
+    }
+    return bResult;
+}
+
+
+/**
+    MDNSResponder::stcMDNSArena
+
+    A simple 'bump' allocator for the records read from received messages.
+    These records only live while the message is processed; placing them in one
+    buffer (allocated with the first record and then kept) avoids fragmenting the
+    heap with many small, short-living objects.
+    Allocations are counted; when the last one is released, the whole buffer is
+    reused. If the buffer is full, the allocations are done on the heap.
+    All arenas are chained, so that the arena owning some memory can be found
+    when releasing it.
+*/
+
+static_assert(MDNS_ARENA_SIZE <= 0xFFFF, "MDNS_ARENA_SIZE must fit into 16 bits");
+
+MDNSResponder::stcMDNSArena* MDNSResponder::stcMDNSArena::s_pArenas = 0;
+
+/*
+    MDNSResponder::stcMDNSArena::stcMDNSArena constructor
+*/
+MDNSResponder::stcMDNSArena::stcMDNSArena(void)
+    :   m_pNext(s_pArenas),
+        m_pu8Buffer(0),
+        m_u16Offset(0),
+        m_u16Allocations(0)
+{
+
+    s_pArenas = this;
+}
+
+/*
+    MDNSResponder::stcMDNSArena::~stcMDNSArena destructor
+*/
+MDNSResponder::stcMDNSArena::~stcMDNSArena(void)
+{
+
+    clear();
+
+    stcMDNSArena**  ppArena = &s_pArenas;
+    while ((*ppArena) &&
+            (*ppArena != this))
+    {
+        ppArena = &((*ppArena)->m_pNext);
+    }
+    if (*ppArena)
+    {
+        *ppArena = m_pNext;
+    }
+}
+
+/*
+    MDNSResponder::stcMDNSArena::clear
+
+    Releases the buffer, if no allocation is alive.
+*/
+bool MDNSResponder::stcMDNSArena::clear(void)
+{
+
+    if ((m_pu8Buffer) &&
+            (0 == m_u16Allocations))
+    {
+        delete[] m_pu8Buffer;
+        m_pu8Buffer = 0;
+        m_u16Offset = 0;
+    }
+    return (0 == m_u16Allocations);
+}
+
+/*
+    MDNSResponder::stcMDNSArena::alloc
+
+    Returns 0, if the arena is full.
+*/
+void* MDNSResponder::stcMDNSArena::alloc(size_t p_stSize)
+{
+
+    void*   pResult = 0;
+
+    size_t  stAlignedSize = ((p_stSize + (alignof(max_align_t) - 1)) & ~(alignof(max_align_t) - 1));
+    if ((p_stSize) &&
+            (stAlignedSize <= (size_t)(MDNS_ARENA_SIZE - m_u16Offset)) &&
+            ((m_pu8Buffer) ||
+             ((m_pu8Buffer = new uint8_t[MDNS_ARENA_SIZE]))))
+    {
+
+        pResult = (m_pu8Buffer + m_u16Offset);
+        m_u16Offset += stAlignedSize;
+        ++m_u16Allocations;
+    }
+    return pResult;
+}
+
+/*
+    MDNSResponder::stcMDNSArena::owns
+*/
+bool MDNSResponder::stcMDNSArena::owns(const void* p_pMemory) const
+{
+
+    return ((m_pu8Buffer) &&
+            ((const uint8_t*)p_pMemory >= m_pu8Buffer) &&
+            ((const uint8_t*)p_pMemory < (m_pu8Buffer + MDNS_ARENA_SIZE)));
+}
+
+/*
+    MDNSResponder::stcMDNSArena::release
+
+    Returns false, if the memory isn't owned by the arena.
+*/
+bool MDNSResponder::stcMDNSArena::release(const void* p_pMemory)
+{
+
+    bool    bResult = false;
+
+    if ((owns(p_pMemory)) &&
+            (m_u16Allocations))
+    {
+        if (0 == --m_u16Allocations)
+        {
+            m_u16Offset = 0;
+        }
+        bResult = true;
+    }
+    return bResult;
+}
+
+/*
+    MDNSResponder::stcMDNSArena::owner (static)
+*/
+/*static*/ MDNSResponder::stcMDNSArena* MDNSResponder::stcMDNSArena::owner(const void* p_pMemory)
+{
+
+    stcMDNSArena*   pArena = s_pArenas;
+    while ((pArena) &&
+            (!pArena->owns(p_pMemory)))
+    {
+        pArena = pArena->m_pNext;
+    }
+    return pArena;
+}
+
+/*
+    MDNSResponder::stcMDNSArena::allocChars (static)
+
+    Allocates the chars in the same arena as their owner (or on the heap).
+*/
+/*static*/ char* MDNSResponder::stcMDNSArena::allocChars(const void* p_pOwner,
+        size_t p_stLength)
+{
+
+    stcMDNSArena*   pArena = owner(p_pOwner);
+    char*           pcResult = (pArena ? (char*)pArena->alloc(p_stLength) : 0);
+    return (pcResult ? : new char[p_stLength]);
+}
+
+/*
+    MDNSResponder::stcMDNSArena::releaseChars (static)
+*/
+/*static*/ void MDNSResponder::stcMDNSArena::releaseChars(char* p_pcChars)
+{
+
+    stcMDNSArena*   pArena = (p_pcChars ? owner(p_pcChars) : 0);
+    if (pArena)
+    {
+        pArena->release(p_pcChars);
+    }
+    else
+    {
+        delete[] p_pcChars;
+    }
+}
+
+
+/**
+    MDNSResponder::stcMDNSArenaObject
+
+    Base for the objects, which might be placed in an arena.
+*/
+
+/*
+    MDNSResponder::stcMDNSArenaObject::operator new
+*/
+void* MDNSResponder::stcMDNSArenaObject::operator new(size_t p_stSize) noexcept
+{
+
+    return ::operator new(p_stSize, std::nothrow);
+}
+
+/*
+    MDNSResponder::stcMDNSArenaObject::operator new (arena)
+*/
+void* MDNSResponder::stcMDNSArenaObject::operator new(size_t p_stSize,
+        MDNSResponder::stcMDNSArena& p_rArena) noexcept
+{
+
+    void*   pResult = p_rArena.alloc(p_stSize);
+    return (pResult ? : ::operator new(p_stSize, std::nothrow));
+}
+
+/*
+    MDNSResponder::stcMDNSArenaObject::operator delete
+*/
+void MDNSResponder::stcMDNSArenaObject::operator delete(void* p_pObject)
+{
+
+    stcMDNSArena*   pArena = (p_pObject ? stcMDNSArena::owner(p_pObject) : 0);
+    if (pArena)
+    {
+        pArena->release(p_pObject);
+    }
+    else
+    {
+        ::operator delete(p_pObject);
+    }
+}
+
+/*
+    MDNSResponder::stcMDNSArenaObject::operator delete (arena)
+*/
+void MDNSResponder::stcMDNSArenaObject::operator delete(void* p_pObject,
+        MDNSResponder::stcMDNSArena& /*p_rArena*/)
+{
+
+    stcMDNSArenaObject::operator delete(p_pObject);
+}
+
+
 /**
     MDNSResponder::stcMDNSServiceTxt
 
@@ -121,7 +476,7 @@ char* MDNSResponder::stcMDNSServiceTxt::allocKey(size_t p_stLength)
     releaseKey();
     if (p_stLength)
     {
-        m_pcKey = new char[p_stLength + 1];
+        m_pcKey = stcMDNSArena::allocChars(this, p_stLength + 1);
     }
     return m_pcKey;
 }
@@ -165,7 +520,7 @@ bool MDNSResponder::stcMDNSServiceTxt::releaseKey(void)
 
     if (m_pcKey)
     {
-        delete[] m_pcKey;
+        stcMDNSArena::releaseChars(m_pcKey);
         m_pcKey = 0;
     }
     return true;
@@ -180,7 +535,7 @@ char* MDNSResponder::stcMDNSServiceTxt::allocValue(size_t p_stLength)
     releaseValue();
     if (p_stLength)
     {
-        m_pcValue = new char[p_stLength + 1];
+        m_pcValue = stcMDNSArena::allocChars(this, p_stLength + 1);
     }
     return m_pcValue;
 }
@@ -228,7 +583,7 @@ bool MDNSResponder::stcMDNSServiceTxt::releaseValue(void)
 
     if (m_pcValue)
     {
-        delete[] m_pcValue;
+        stcMDNSArena::releaseChars(m_pcValue);
         m_pcValue = 0;
     }
     return true;
@@ -1271,7 +1626,7 @@ bool MDNSResponder::stcMDNS_RRAnswerGeneric::clear(void)
 
     if (m_pu8RDData)
     {
-        delete[] m_pu8RDData;
+        stcMDNSArena::releaseChars((char*)m_pu8RDData);
         m_pu8RDData = 0;
     }
     m_u16RDLength = 0;
@@ -2343,23 +2698,10 @@ MDNSResponder::stcMDNSServiceQuery::stcAnswer* MDNSResponder::stcMDNSServiceQuer
     MDNSResponder::stcMDNSSendParameter::stcDomainCacheItem
 
     A cached host or service domain, incl. the offset in the UDP output buffer.
+    The items are stored in a fixed size array (MDNS_DOMAIN_CACHE_SIZE).
 
 */
 
-/*
-    MDNSResponder::stcMDNSSendParameter::stcDomainCacheItem::stcDomainCacheItem constructor
-*/
-MDNSResponder::stcMDNSSendParameter::stcDomainCacheItem::stcDomainCacheItem(const void* p_pHostnameOrService,
-        bool p_bAdditionalData,
-        uint32_t p_u16Offset)
-    :   m_pNext(0),
-        m_pHostnameOrService(p_pHostnameOrService),
-        m_bAdditionalData(p_bAdditionalData),
-        m_u16Offset(p_u16Offset)
-{
-
-}
-
 /**
     MDNSResponder::stcMDNSSendParameter
 */
@@ -2369,7 +2711,7 @@ MDNSResponder::stcMDNSSendParameter::stcDomainCacheItem::stcDomainCacheItem(cons
 */
 MDNSResponder::stcMDNSSendParameter::stcMDNSSendParameter(void)
     :   m_pQuestions(0),
-        m_pDomainCacheItems(0)
+        m_u8DomainCacheItems(0)
 {
 
     clear();
@@ -2418,14 +2760,7 @@ bool MDNSResponder::stcMDNSSendParameter::clearCachedNames(void)
 {
 
     m_u16Offset = 0;
-
-    while (m_pDomainCacheItems)
-    {
-        stcDomainCacheItem* pNext = m_pDomainCacheItems->m_pNext;
-        delete m_pDomainCacheItems;
-        m_pDomainCacheItems = pNext;
-    }
-    m_pDomainCacheItems = nullptr;
+    m_u8DomainCacheItems = 0;
 
     return true;
 }
@@ -2442,6 +2777,9 @@ bool MDNSResponder::stcMDNSSendParameter::shiftOffset(uint16_t p_u16Shift)
 
 /*
     MDNSResponder::stcMDNSSendParameter::addDomainCacheItem
+
+    If the cache is full, the domain is not cached (and will be written
+    uncompressed the next time); this is not an error.
 */
 bool MDNSResponder::stcMDNSSendParameter::addDomainCacheItem(const void* p_pHostnameOrService,
         bool p_bAdditionalData,
@@ -2450,14 +2788,17 @@ bool MDNSResponder::stcMDNSSendParameter::addDomainCacheItem(const void* p_pHost
 
     bool    bResult = false;
 
-    stcDomainCacheItem* pNewItem = 0;
     if ((p_pHostnameOrService) &&
-            (p_u16Offset) &&
-            ((pNewItem = new stcDomainCacheItem(p_pHostnameOrService, p_bAdditionalData, p_u16Offset))))
+            (p_u16Offset))
     {
-
-        pNewItem->m_pNext = m_pDomainCacheItems;
-        bResult = ((m_pDomainCacheItems = pNewItem));
+        if (MDNS_DOMAIN_CACHE_SIZE > m_u8DomainCacheItems)
+        {
+            stcDomainCacheItem& rNewItem = m_aDomainCacheItems[m_u8DomainCacheItems++];
+            rNewItem.m_pHostnameOrService = p_pHostnameOrService;
+            rNewItem.m_bAdditionalData = p_bAdditionalData;
+            rNewItem.m_u16Offset = p_u16Offset;
+        }
+        bResult = true;
     }
     return bResult;
 }
@@ -2469,17 +2810,245 @@ uint16_t MDNSResponder::stcMDNSSendParameter::findCachedDomainOffset(const void*
         bool p_bAdditionalData) const
 {
 
-    const stcDomainCacheItem*   pCacheItem = m_pDomainCacheItems;
+    for (uint8_t u = 0; u < m_u8DomainCacheItems; ++u)
+    {
+        if ((m_aDomainCacheItems[u].m_pHostnameOrService == p_pHostnameOrService) &&
+                (m_aDomainCacheItems[u].m_bAdditionalData == p_bAdditionalData))   // Found cache item
+        {
+            return m_aDomainCacheItems[u].m_u16Offset;
+        }
+    }
+    return 0;
+}
+
+
+/**
+    MDNSResponder::stcMDNSAnswerCache
+
+    Prebuilt answer messages (see _prepareMDNSMessage).
+    An entry is filled while the message is composed (by _udpAppendBuffer) and
+    becomes valid, when the message was composed successfully. Entries built in
+    an older cache generation are replaced first, else the least recently used one.
+
+*/
+
+/**
+    MDNSResponder::stcMDNSAnswerCache::stcEntry
+*/
+
+/*
+    MDNSResponder::stcMDNSAnswerCache::stcEntry::stcEntry constructor
+*/
+MDNSResponder::stcMDNSAnswerCache::stcEntry::stcEntry(void)
+    :   m_u8KeyLength(0),
+        m_u32Generation(0),
+        m_u32LastUse(0),
+        m_pucMessage(0),
+        m_u16Length(0),
+        m_u16Size(0)
+{
+
+}
+
+/*
+    MDNSResponder::stcMDNSAnswerCache::stcEntry::~stcEntry destructor
+*/
+MDNSResponder::stcMDNSAnswerCache::stcEntry::~stcEntry(void)
+{
+
+    clear();
+}
+
+/*
+    MDNSResponder::stcMDNSAnswerCache::stcEntry::clear
+*/
+bool MDNSResponder::stcMDNSAnswerCache::stcEntry::clear(void)
+{
+
+    if (m_pucMessage)
+    {
+        delete[] m_pucMessage;
+        m_pucMessage = 0;
+    }
+    m_u8KeyLength = 0;
+    m_u32Generation = 0;
+    m_u32LastUse = 0;
+    m_u16Length = 0;
+    m_u16Size = 0;
+    return true;
+}
+
+/*
+    MDNSResponder::stcMDNSAnswerCache::stcEntry::append
+
+    The message buffer is reused when the entry is rebuilt, and only grows if needed.
+*/
+bool MDNSResponder::stcMDNSAnswerCache::stcEntry::append(const unsigned char* p_pcBuffer,
+        size_t p_stLength)
+{
+
+    bool    bResult = true;
 
-    for (; pCacheItem; pCacheItem = pCacheItem->m_pNext)
+    size_t  stNeededSize = (m_u16Length + p_stLength);
+    if (stNeededSize > m_u16Size)
     {
-        if ((pCacheItem->m_pHostnameOrService == p_pHostnameOrService) &&
-                (pCacheItem->m_bAdditionalData == p_bAdditionalData))   // Found cache item
+        size_t  stSize = (m_u16Size ? : 128);
+        while (stSize < stNeededSize)
         {
+            stSize *= 2;
+        }
+        unsigned char*  pucMessage = 0;
+        if ((bResult = ((0xFFFF >= stSize) &&
+                        ((pucMessage = new unsigned char[stSize])))))
+        {
+            if (m_u16Length)
+            {
+                memcpy(pucMessage, m_pucMessage, m_u16Length);
+            }
+            delete[] m_pucMessage;
+            m_pucMessage = pucMessage;
+            m_u16Size = stSize;
+        }
+    }
+    if (bResult)
+    {
+        memcpy(m_pucMessage + m_u16Length, p_pcBuffer, p_stLength);
+        m_u16Length += p_stLength;
+    }
+    return bResult;
+}
+
+/**
+    MDNSResponder::stcMDNSAnswerCache
+*/
+
+/*
+    MDNSResponder::stcMDNSAnswerCache::stcMDNSAnswerCache constructor
+*/
+MDNSResponder::stcMDNSAnswerCache::stcMDNSAnswerCache(void)
+    :   m_u32Generation(1),
+        m_u32Uses(0),
+        m_pBuilding(0),
+        m_bBuildFailed(false)
+{
+
+}
+
+/*
+    MDNSResponder::stcMDNSAnswerCache::clear
+
+    Releases all prebuilt messages.
+*/
+bool MDNSResponder::stcMDNSAnswerCache::clear(void)
+{
+
+    for (stcEntry& rEntry : m_aEntries)
+    {
+        rEntry.clear();
+    }
+    m_pBuilding = 0;
+    return invalidate();
+}
+
+/*
+    MDNSResponder::stcMDNSAnswerCache::invalidate
+
+    To be called, when host, service or TXT data changed.
+*/
+bool MDNSResponder::stcMDNSAnswerCache::invalidate(void)
+{
+
+    if (0 == ++m_u32Generation)     // 0 is reserved for invalid entries
+    {
+        ++m_u32Generation;
+    }
+    return true;
+}
+
+/*
+    MDNSResponder::stcMDNSAnswerCache::find
+*/
+const MDNSResponder::stcMDNSAnswerCache::stcEntry* MDNSResponder::stcMDNSAnswerCache::find(const uint8_t* p_pu8Key,
+        uint8_t p_u8KeyLength)
+{
+
+    for (stcEntry& rEntry : m_aEntries)
+    {
+        if ((rEntry.m_u32Generation == m_u32Generation) &&
+                (rEntry.m_u8KeyLength == p_u8KeyLength) &&
+                (0 == memcmp(rEntry.m_au8Key, p_pu8Key, p_u8KeyLength)))
+        {
+            rEntry.m_u32LastUse = ++m_u32Uses;
+            return &rEntry;
+        }
+    }
+    return 0;
+}
+
+/*
+    MDNSResponder::stcMDNSAnswerCache::startBuilding
+*/
+MDNSResponder::stcMDNSAnswerCache::stcEntry* MDNSResponder::stcMDNSAnswerCache::startBuilding(const uint8_t* p_pu8Key,
+        uint8_t p_u8KeyLength)
+{
+
+    m_pBuilding = 0;
+    m_bBuildFailed = false;
+
+    for (stcEntry& rEntry : m_aEntries)
+    {
+        if (rEntry.m_u32Generation != m_u32Generation)     // Outdated or empty
+        {
+            m_pBuilding = &rEntry;
             break;
         }
+        if ((!m_pBuilding) ||
+                (rEntry.m_u32LastUse < m_pBuilding->m_u32LastUse))
+        {
+            m_pBuilding = &rEntry;
+        }
+    }
+    if ((m_pBuilding) &&
+            (MDNS_ANSWER_CACHE_KEY_LENGTH >= p_u8KeyLength))
+    {
+        memcpy(m_pBuilding->m_au8Key, p_pu8Key, p_u8KeyLength);
+        m_pBuilding->m_u8KeyLength = p_u8KeyLength;
+        m_pBuilding->m_u32Generation = 0;   // Not valid until finished
+        m_pBuilding->m_u16Length = 0;
+    }
+    else
+    {
+        m_pBuilding = 0;
+    }
+    return m_pBuilding;
+}
+
+/*
+    MDNSResponder::stcMDNSAnswerCache::finishBuilding
+
+    If composing the message failed, the entry is released.
+*/
+bool MDNSResponder::stcMDNSAnswerCache::finishBuilding(bool p_bSuccess)
+{
+
+    bool    bResult = false;
+
+    if (m_pBuilding)
+    {
+        if ((p_bSuccess) &&
+                (!m_bBuildFailed))
+        {
+            m_pBuilding->m_u32Generation = m_u32Generation;
+            m_pBuilding->m_u32LastUse = ++m_u32Uses;
+            bResult = true;
+        }
+        else
+        {
+            m_pBuilding->clear();
+        }
+        m_pBuilding = 0;
     }
-    return (pCacheItem ? pCacheItem->m_u16Offset : 0);
+    return bResult;
 }
 
 }   // namespace MDNSImplementation
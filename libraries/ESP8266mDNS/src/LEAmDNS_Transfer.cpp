@@ -153,16 +153,102 @@ bool MDNSResponder::_sendMDNSMessage_Multicast(MDNSResponder::stcMDNSSendParamet
 /*
     MDNSResponder::_prepareMDNSMessage
 
+    Fills the UDP output buffer with the MDNS message for the send parameter.
+    Answers, which don't depend on the query (ID, questions) or on dynamic TXT items,
+    are taken from the answer cache, if a matching and up-to-date message was
+    prebuilt; else the message is composed (and stored in the answer cache).
+
+*/
+bool MDNSResponder::_prepareMDNSMessage(MDNSResponder::stcMDNSSendParameter& p_rSendParameter,
+                                        IPAddress p_IPAddress)
+{
+
+    bool        bResult = false;
+
+    uint8_t     au8Key[MDNS_ANSWER_CACHE_KEY_LENGTH];
+    uint8_t     u8KeyLength = _answerCacheKey(p_rSendParameter, p_IPAddress, au8Key);
+    const stcMDNSAnswerCache::stcEntry* pCachedAnswer = (u8KeyLength
+            ? m_AnswerCache.find(au8Key, u8KeyLength)
+            : 0);
+    if (pCachedAnswer)
+    {
+        DEBUG_EX_INFO(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _prepareMDNSMessage: Using prebuilt answer (%u bytes)\n"), pCachedAnswer->m_u16Length););
+        bResult = _udpAppendBuffer(pCachedAnswer->m_pucMessage, pCachedAnswer->m_u16Length);
+    }
+    else
+    {
+        if (u8KeyLength)
+        {
+            m_AnswerCache.startBuilding(au8Key, u8KeyLength);
+        }
+        bResult = _composeMDNSMessage(p_rSendParameter, p_IPAddress);
+        m_AnswerCache.finishBuilding(bResult);
+    }
+    return bResult;
+}
+
+/*
+    MDNSResponder::_answerCacheKey
+
+    Writes the key identifying the answer message for the send parameter and returns
+    its length (0, if the message can't be taken from the answer cache).
+    The key is made of the host reply mask, the flags, the IP address and the reply
+    mask of every service.
+*/
+uint8_t MDNSResponder::_answerCacheKey(const MDNSResponder::stcMDNSSendParameter& p_SendParameter,
+                                       IPAddress p_IPAddress,
+                                       uint8_t* p_pu8Key) const
+{
+
+    uint8_t u8KeyLength = 0;
+
+    if ((MDNS_ANSWER_CACHE_SIZE) &&
+            (p_SendParameter.m_bResponse) &&
+            (!p_SendParameter.m_bLegacyQuery) &&
+            (!p_SendParameter.m_pQuestions) &&
+            (!p_SendParameter.m_u16ID))
+    {
+        p_pu8Key[u8KeyLength++] = p_SendParameter.m_u8HostReplyMask;
+        p_pu8Key[u8KeyLength++] = ((p_SendParameter.m_bAuthorative ? 0x01 : 0) |
+                                   (p_SendParameter.m_bCacheFlush ? 0x02 : 0) |
+                                   (p_SendParameter.m_bUnicast ? 0x04 : 0) |
+                                   (p_SendParameter.m_bUnannounce ? 0x08 : 0));
+        p_pu8Key[u8KeyLength++] = p_IPAddress[0];
+        p_pu8Key[u8KeyLength++] = p_IPAddress[1];
+        p_pu8Key[u8KeyLength++] = p_IPAddress[2];
+        p_pu8Key[u8KeyLength++] = p_IPAddress[3];
+
+        for (const stcMDNSService* pService = m_pServices; ((u8KeyLength) && (pService)); pService = pService->m_pNext)
+        {
+            if ((MDNS_ANSWER_CACHE_KEY_LENGTH == u8KeyLength) ||                    // Too many services
+                    ((pService->m_u8ReplyMask & (ContentFlag_TXT | ContentFlag_PTR_NAME)) && // TXT items (might) be included, AND
+                     ((m_fnServiceTxtCallback) ||                                  // might be dynamic
+                      (pService->m_fnTxtCallback))))
+            {
+                u8KeyLength = 0;
+            }
+            else
+            {
+                p_pu8Key[u8KeyLength++] = pService->m_u8ReplyMask;
+            }
+        }
+    }
+    return u8KeyLength;
+}
+
+/*
+    MDNSResponder::_composeMDNSMessage
+
     The MDNS message is composed in a two-step process.
     In the first loop 'only' the header information (mainly number of answers) are collected,
     while in the seconds loop, the header and all queries and answers are written to the UDP
     output buffer.
 
 */
-bool MDNSResponder::_prepareMDNSMessage(MDNSResponder::stcMDNSSendParameter& p_rSendParameter,
+bool MDNSResponder::_composeMDNSMessage(MDNSResponder::stcMDNSSendParameter& p_rSendParameter,
                                         IPAddress p_IPAddress)
 {
-    DEBUG_EX_INFO(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _prepareMDNSMessage\n")););
+    DEBUG_EX_INFO(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _composeMDNSMessage\n")););
     bool    bResult = true;
     p_rSendParameter.clearCachedNames(); // Need to remove cached names, p_SendParameter might have been used before on other interface
 
@@ -460,104 +546,154 @@ bool MDNSResponder::_readRRAnswer(MDNSResponder::stcMDNS_RRAnswer*& p_rpRRAnswer
 {
     //DEBUG_EX_INFO(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRAnswer\n")););
 
-    bool    bResult = false;
-
     stcMDNS_RRHeader    header;
     uint32_t            u32TTL;
     uint16_t            u16RDLength;
-    if ((_readRRHeader(header)) &&
-            (_udpRead32(u32TTL)) &&
-            (_udpRead16(u16RDLength)))
-    {
+    return ((_readRRAnswerHeader(header, u32TTL, u16RDLength)) &&
+            (_readRRAnswerContent(header, u32TTL, u16RDLength, p_rpRRAnswer)));
+}
+
+/*
+    MDNSResponder::_readRRAnswerHeader
+
+    Reads the domain, type info, TTL and RDLength of an answer. The answer content
+    must then be read by '_readRRAnswerContent' or skipped by '_skipRRAnswerContent'.
+
+*/
+bool MDNSResponder::_readRRAnswerHeader(MDNSResponder::stcMDNS_RRHeader& p_rHeader,
+                                        uint32_t& p_ru32TTL,
+                                        uint16_t& p_ru16RDLength)
+{
+
+    bool    bResult = ((_readRRHeader(p_rHeader)) &&
+                       (_udpRead32(p_ru32TTL)) &&
+                       (_udpRead16(p_ru16RDLength)) &&
+                       (p_ru16RDLength <= m_Reader.available()));
+    DEBUG_EX_ERR(if (!bResult) DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRAnswerHeader: FAILED!\n")););
+    return bResult;
+}
+
+/*
+    MDNSResponder::_skipRRAnswerContent
+
+    Skips the content of an answer, which isn't needed (without allocating it).
+
+*/
+bool MDNSResponder::_skipRRAnswerContent(uint16_t p_u16RDLength)
+{
+
+    bool    bResult = m_Reader.skip(p_u16RDLength);
+    DEBUG_EX_ERR(if (!bResult) DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _skipRRAnswerContent: FAILED!\n")););
+    return bResult;
+}
+
+/*
+    MDNSResponder::_readRRAnswerContent
+
+    Allocates the answer for the given header and reads its content.
+    On success, the read position is behind the answer content (RDLength bytes).
+
+*/
+bool MDNSResponder::_readRRAnswerContent(const MDNSResponder::stcMDNS_RRHeader& p_Header,
+                                         uint32_t p_u32TTL,
+                                         uint16_t p_u16RDLength,
+                                         MDNSResponder::stcMDNS_RRAnswer*& p_rpRRAnswer)
+{
+
+    bool    bResult = false;
 
-        /*  DEBUG_EX_INFO(
-                DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRAnswer: Reading 0x%04X answer (class:0x%04X, TTL:%u, RDLength:%u) for "), header.m_Attributes.m_u16Type, header.m_Attributes.m_u16Class, u32TTL, u16RDLength);
-                _printRRDomain(header.m_Domain);
-                DEBUG_OUTPUT.printf_P(PSTR("\n"));
-                );*/
+    uint16_t    u16ContentStart = m_Reader.tell();
 
-        switch (header.m_Attributes.m_u16Type & (~0x8000))      // Topmost bit might carry 'cache flush' flag
+    /*  DEBUG_EX_INFO(
+            DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRAnswer: Reading 0x%04X answer (class:0x%04X, TTL:%u, RDLength:%u) for "), p_Header.m_Attributes.m_u16Type, p_Header.m_Attributes.m_u16Class, p_u32TTL, p_u16RDLength);
+            _printRRDomain(p_Header.m_Domain);
+            DEBUG_OUTPUT.printf_P(PSTR("\n"));
+            );*/
+
+    switch (p_Header.m_Attributes.m_u16Type & (~0x8000))      // Topmost bit might carry 'cache flush' flag
+    {
+#ifdef MDNS_IP4_SUPPORT
+    case DNS_RRTYPE_A:
+        p_rpRRAnswer = new (m_Arena) stcMDNS_RRAnswerA(p_Header, p_u32TTL);
+        bResult = _readRRAnswerA(*(stcMDNS_RRAnswerA*&)p_rpRRAnswer, p_u16RDLength);
+        break;
+#endif
+    case DNS_RRTYPE_PTR:
+        p_rpRRAnswer = new (m_Arena) stcMDNS_RRAnswerPTR(p_Header, p_u32TTL);
+        bResult = _readRRAnswerPTR(*(stcMDNS_RRAnswerPTR*&)p_rpRRAnswer, p_u16RDLength);
+        break;
+    case DNS_RRTYPE_TXT:
+        p_rpRRAnswer = new (m_Arena) stcMDNS_RRAnswerTXT(p_Header, p_u32TTL);
+        bResult = _readRRAnswerTXT(*(stcMDNS_RRAnswerTXT*&)p_rpRRAnswer, p_u16RDLength);
+        break;
+#ifdef MDNS_IP6_SUPPORT
+    case DNS_RRTYPE_AAAA:
+        p_rpRRAnswer = new (m_Arena) stcMDNS_RRAnswerAAAA(p_Header, p_u32TTL);
+        bResult = _readRRAnswerAAAA(*(stcMDNS_RRAnswerAAAA*&)p_rpRRAnswer, p_u16RDLength);
+        break;
+#endif
+    case DNS_RRTYPE_SRV:
+        p_rpRRAnswer = new (m_Arena) stcMDNS_RRAnswerSRV(p_Header, p_u32TTL);
+        bResult = _readRRAnswerSRV(*(stcMDNS_RRAnswerSRV*&)p_rpRRAnswer, p_u16RDLength);
+        break;
+    default:
+        p_rpRRAnswer = new (m_Arena) stcMDNS_RRAnswerGeneric(p_Header, p_u32TTL);
+        bResult = _readRRAnswerGeneric(*(stcMDNS_RRAnswerGeneric*&)p_rpRRAnswer, p_u16RDLength);
+        break;
+    }
+    DEBUG_EX_INFO(
+        if ((bResult) &&
+            (p_rpRRAnswer))
+{
+    DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRAnswer: "));
+        _printRRDomain(p_rpRRAnswer->m_Header.m_Domain);
+        DEBUG_OUTPUT.printf_P(PSTR(" Type:0x%04X Class:0x%04X TTL:%u, RDLength:%u "), p_rpRRAnswer->m_Header.m_Attributes.m_u16Type, p_rpRRAnswer->m_Header.m_Attributes.m_u16Class, p_rpRRAnswer->m_u32TTL, p_u16RDLength);
+        switch (p_Header.m_Attributes.m_u16Type & (~0x8000))      // Topmost bit might carry 'cache flush' flag
         {
 #ifdef MDNS_IP4_SUPPORT
         case DNS_RRTYPE_A:
-            p_rpRRAnswer = new stcMDNS_RRAnswerA(header, u32TTL);
-            bResult = _readRRAnswerA(*(stcMDNS_RRAnswerA*&)p_rpRRAnswer, u16RDLength);
+            DEBUG_OUTPUT.printf_P(PSTR("A IP:%s"), ((stcMDNS_RRAnswerA*&)p_rpRRAnswer)->m_IPAddress.toString().c_str());
             break;
 #endif
         case DNS_RRTYPE_PTR:
-            p_rpRRAnswer = new stcMDNS_RRAnswerPTR(header, u32TTL);
-            bResult = _readRRAnswerPTR(*(stcMDNS_RRAnswerPTR*&)p_rpRRAnswer, u16RDLength);
+            DEBUG_OUTPUT.printf_P(PSTR("PTR "));
+            _printRRDomain(((stcMDNS_RRAnswerPTR*&)p_rpRRAnswer)->m_PTRDomain);
             break;
         case DNS_RRTYPE_TXT:
-            p_rpRRAnswer = new stcMDNS_RRAnswerTXT(header, u32TTL);
-            bResult = _readRRAnswerTXT(*(stcMDNS_RRAnswerTXT*&)p_rpRRAnswer, u16RDLength);
+        {
+            size_t  stTxtLength = ((stcMDNS_RRAnswerTXT*&)p_rpRRAnswer)->m_Txts.c_strLength();
+            char*   pTxts = new char[stTxtLength];
+            if (pTxts)
+            {
+                ((stcMDNS_RRAnswerTXT*&)p_rpRRAnswer)->m_Txts.c_str(pTxts);
+                DEBUG_OUTPUT.printf_P(PSTR("TXT(%u) %s"), stTxtLength, pTxts);
+                delete[] pTxts;
+            }
             break;
+        }
 #ifdef MDNS_IP6_SUPPORT
         case DNS_RRTYPE_AAAA:
-            p_rpRRAnswer = new stcMDNS_RRAnswerAAAA(header, u32TTL);
-            bResult = _readRRAnswerAAAA(*(stcMDNS_RRAnswerAAAA*&)p_rpRRAnswer, u16RDLength);
+            DEBUG_OUTPUT.printf_P(PSTR("AAAA IP:%s"), ((stcMDNS_RRAnswerA*&)p_rpRRAnswer)->m_IPAddress.toString().c_str());
             break;
 #endif
         case DNS_RRTYPE_SRV:
-            p_rpRRAnswer = new stcMDNS_RRAnswerSRV(header, u32TTL);
-            bResult = _readRRAnswerSRV(*(stcMDNS_RRAnswerSRV*&)p_rpRRAnswer, u16RDLength);
+            DEBUG_OUTPUT.printf_P(PSTR("SRV Port:%u "), ((stcMDNS_RRAnswerSRV*&)p_rpRRAnswer)->m_u16Port);
+            _printRRDomain(((stcMDNS_RRAnswerSRV*&)p_rpRRAnswer)->m_SRVDomain);
             break;
         default:
-            p_rpRRAnswer = new stcMDNS_RRAnswerGeneric(header, u32TTL);
-            bResult = _readRRAnswerGeneric(*(stcMDNS_RRAnswerGeneric*&)p_rpRRAnswer, u16RDLength);
+            DEBUG_OUTPUT.printf_P(PSTR("generic "));
             break;
         }
-        DEBUG_EX_INFO(
-            if ((bResult) &&
-                (p_rpRRAnswer))
+        DEBUG_OUTPUT.printf_P(PSTR("\n"));
+    }
+    else
     {
-        DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRAnswer: "));
-            _printRRDomain(p_rpRRAnswer->m_Header.m_Domain);
-            DEBUG_OUTPUT.printf_P(PSTR(" Type:0x%04X Class:0x%04X TTL:%u, RDLength:%u "), p_rpRRAnswer->m_Header.m_Attributes.m_u16Type, p_rpRRAnswer->m_Header.m_Attributes.m_u16Class, p_rpRRAnswer->m_u32TTL, u16RDLength);
-            switch (header.m_Attributes.m_u16Type & (~0x8000))      // Topmost bit might carry 'cache flush' flag
-            {
-#ifdef MDNS_IP4_SUPPORT
-            case DNS_RRTYPE_A:
-                DEBUG_OUTPUT.printf_P(PSTR("A IP:%s"), ((stcMDNS_RRAnswerA*&)p_rpRRAnswer)->m_IPAddress.toString().c_str());
-                break;
-#endif
-            case DNS_RRTYPE_PTR:
-                DEBUG_OUTPUT.printf_P(PSTR("PTR "));
-                _printRRDomain(((stcMDNS_RRAnswerPTR*&)p_rpRRAnswer)->m_PTRDomain);
-                break;
-            case DNS_RRTYPE_TXT:
-            {
-                size_t  stTxtLength = ((stcMDNS_RRAnswerTXT*&)p_rpRRAnswer)->m_Txts.c_strLength();
-                char*   pTxts = new char[stTxtLength];
-                if (pTxts)
-                {
-                    ((stcMDNS_RRAnswerTXT*&)p_rpRRAnswer)->m_Txts.c_str(pTxts);
-                    DEBUG_OUTPUT.printf_P(PSTR("TXT(%u) %s"), stTxtLength, pTxts);
-                    delete[] pTxts;
-                }
-                break;
-            }
-#ifdef MDNS_IP6_SUPPORT
-            case DNS_RRTYPE_AAAA:
-                DEBUG_OUTPUT.printf_P(PSTR("AAAA IP:%s"), ((stcMDNS_RRAnswerA*&)p_rpRRAnswer)->m_IPAddress.toString().c_str());
-                break;
-#endif
-            case DNS_RRTYPE_SRV:
-                DEBUG_OUTPUT.printf_P(PSTR("SRV Port:%u "), ((stcMDNS_RRAnswerSRV*&)p_rpRRAnswer)->m_u16Port);
-                _printRRDomain(((stcMDNS_RRAnswerSRV*&)p_rpRRAnswer)->m_SRVDomain);
-                break;
-            default:
-                DEBUG_OUTPUT.printf_P(PSTR("generic "));
-                break;
-            }
-            DEBUG_OUTPUT.printf_P(PSTR("\n"));
-        }
-        else
-        {
-            DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRAnswer: FAILED to read specific answer of type 0x%04X!\n"), p_rpRRAnswer->m_Header.m_Attributes.m_u16Type);
-        }
-        );  // DEBUG_EX_INFO
+        DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRAnswer: FAILED to read specific answer of type 0x%04X!\n"), p_rpRRAnswer->m_Header.m_Attributes.m_u16Type);
     }
+    );  // DEBUG_EX_INFO
+    // The specific readers must not leave content behind (or read beyond it)
+    bResult = ((bResult) &&
+               (m_Reader.seek(u16ContentStart + p_u16RDLength)));
     DEBUG_EX_ERR(if (!bResult) DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRAnswer: FAILED!\n")););
     return bResult;
 }
@@ -608,7 +744,7 @@ bool MDNSResponder::_readRRAnswerTXT(MDNSResponder::stcMDNS_RRAnswerTXT& p_rRRAn
     {
         bResult = false;
 
-        unsigned char*  pucBuffer = new unsigned char[p_u16RDLength];
+        unsigned char*  pucBuffer = (unsigned char*)stcMDNSArena::allocChars(&p_rRRAnswerTXT, p_u16RDLength);
         if (pucBuffer)
         {
             if (_udpReadBuffer(pucBuffer, p_u16RDLength))
@@ -638,7 +774,7 @@ bool MDNSResponder::_readRRAnswerTXT(MDNSResponder::stcMDNS_RRAnswerTXT& p_rRRAn
                                 ((ucKeyLength = (pucEqualSign - pucCursor))))
                         {
                             unsigned char   ucValueLength = (ucLength - (pucEqualSign - pucCursor + 1));
-                            bResult = (((pTxt = new stcMDNSServiceTxt)) &&
+                            bResult = (((pTxt = new (m_Arena) stcMDNSServiceTxt)) &&
                                        (pTxt->setKey((const char*)pucCursor, ucKeyLength)) &&
                                        (pTxt->setValue((const char*)(pucEqualSign + 1), ucValueLength)));
                         }
@@ -668,7 +804,7 @@ bool MDNSResponder::_readRRAnswerTXT(MDNSResponder::stcMDNS_RRAnswerTXT& p_rRRAn
                             DEBUG_EX_ERR(
                                 DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRAnswerTXT: FAILED to read TXT item!\n"));
                                 DEBUG_OUTPUT.printf_P(PSTR("RData dump:\n"));
-                                _udpDump((m_pUDPContext->tell() - p_u16RDLength), p_u16RDLength);
+                                _udpDump((m_Reader.tell() - p_u16RDLength), p_u16RDLength);
                                 DEBUG_OUTPUT.printf_P(PSTR("\n"));
                             );
                         }
@@ -685,7 +821,7 @@ bool MDNSResponder::_readRRAnswerTXT(MDNSResponder::stcMDNS_RRAnswerTXT& p_rRRAn
                     if (!bResult)   // Some failure
             {
                 DEBUG_OUTPUT.printf_P(PSTR("RData dump:\n"));
-                    _udpDump((m_pUDPContext->tell() - p_u16RDLength), p_u16RDLength);
+                    _udpDump((m_Reader.tell() - p_u16RDLength), p_u16RDLength);
                     DEBUG_OUTPUT.printf_P(PSTR("\n"));
                 }
                 );
@@ -695,7 +831,7 @@ bool MDNSResponder::_readRRAnswerTXT(MDNSResponder::stcMDNS_RRAnswerTXT& p_rRRAn
                 DEBUG_EX_ERR(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRAnswerTXT: FAILED to read TXT content!\n")););
             }
             // Clean up
-            delete[] pucBuffer;
+            stcMDNSArena::releaseChars((char*)pucBuffer);
         }
         else
         {
@@ -746,7 +882,7 @@ bool MDNSResponder::_readRRAnswerGeneric(MDNSResponder::stcMDNS_RRAnswerGeneric&
 
     p_rRRAnswerGeneric.clear();
     if (((p_rRRAnswerGeneric.m_u16RDLength = p_u16RDLength)) &&
-            ((p_rRRAnswerGeneric.m_pu8RDData = new unsigned char[p_rRRAnswerGeneric.m_u16RDLength])))
+            ((p_rRRAnswerGeneric.m_pu8RDData = (uint8_t*)stcMDNSArena::allocChars(&p_rRRAnswerGeneric, p_rRRAnswerGeneric.m_u16RDLength))))
     {
 
         bResult = _udpReadBuffer(p_rRRAnswerGeneric.m_pu8RDData, p_rRRAnswerGeneric.m_u16RDLength);
@@ -772,110 +908,87 @@ bool MDNSResponder::_readRRHeader(MDNSResponder::stcMDNS_RRHeader& p_rRRHeader)
     MDNSResponder::_readRRDomain
 
     Reads a (maybe multilevel compressed) domain from the UDP input buffer.
+    Compression pointers are followed by moving the read position to the referenced label;
+    after the domain end, the read position is restored to behind the first pointer.
+    To avoid endless loops because of malformed MDNS records, pointers must point backwards
+    and the maximum number of redirections is set by MDNS_DOMAIN_MAX_REDIRCTION.
 
 */
 bool MDNSResponder::_readRRDomain(MDNSResponder::stcMDNS_RRDomain& p_rRRDomain)
 {
     //DEBUG_EX_INFO(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRDomain\n")););
 
-    bool    bResult = ((p_rRRDomain.clear()) &&
-                       (_readRRDomain_Loop(p_rRRDomain, 0)));
-    DEBUG_EX_ERR(if (!bResult) DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRDomain: FAILED!\n")););
-    return bResult;
-}
+    bool        bResult = p_rRRDomain.clear();
+    uint16_t    u16ReturnOffset = 0;    // Behind the first compression pointer
+    uint8_t     u8Redirections = 0;
 
-/*
-    MDNSResponder::_readRRDomain_Loop
-
-    Reads a domain from the UDP input buffer. For every compression level, the functions
-    calls itself recursively. To avoid endless recursion because of malformed MDNS records,
-    the maximum recursion depth is set by MDNS_DOMAIN_MAX_REDIRCTION.
-
-*/
-bool MDNSResponder::_readRRDomain_Loop(MDNSResponder::stcMDNS_RRDomain& p_rRRDomain,
-                                       uint8_t p_u8Depth)
-{
-    //DEBUG_EX_INFO(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRDomain_Loop(%u)\n"), p_u8Depth););
-
-    bool    bResult = false;
-
-    if (MDNS_DOMAIN_MAX_REDIRCTION >= p_u8Depth)
+    uint8_t     u8Len = 0;
+    do
     {
-        bResult = true;
-
-        uint8_t u8Len = 0;
-        do
+        uint16_t    u16LabelOffset = m_Reader.tell();
+        if (!_udpRead8(u8Len))
         {
-            //DEBUG_EX_INFO(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRDomain_Loop(%u): Offset:%u p0:%02x\n"), p_u8Depth, m_pUDPContext->tell(), m_pUDPContext->peek()););
-            _udpRead8(u8Len);
-
-            if (u8Len & MDNS_DOMAIN_COMPRESS_MARK)
+            bResult = false;
+        }
+        else if (MDNS_DOMAIN_COMPRESS_MARK == (u8Len & MDNS_DOMAIN_COMPRESS_MARK))
+        {
+            // Compressed label(s)
+            uint16_t    u16Offset = ((u8Len & ~MDNS_DOMAIN_COMPRESS_MARK) << 8);    // Implicit BE to LE conversion!
+            uint8_t     u8OffsetLow = 0;
+            if ((_udpRead8(u8OffsetLow)) &&
+                    ((u16Offset |= u8OffsetLow) < u16LabelOffset) &&            // Only backward pointers
+                    (MDNS_DOMAIN_MAX_REDIRCTION >= ++u8Redirections))
             {
-                // Compressed label(s)
-                uint16_t    u16Offset = ((u8Len & ~MDNS_DOMAIN_COMPRESS_MARK) << 8);    // Implicit BE to LE conversion!
-                _udpRead8(u8Len);
-                u16Offset |= u8Len;
-
-                if (m_pUDPContext->isValidOffset(u16Offset))
+                //DEBUG_EX_RX(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRDomain: Redirecting from %u to %u!\n"), u16LabelOffset, u16Offset););
+                if (1 == u8Redirections)
                 {
-                    size_t  stCurrentPosition = m_pUDPContext->tell();      // Prepare return from recursion
-
-                    //DEBUG_EX_RX(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRDomain_Loop(%u): Redirecting from %u to %u!\n"), p_u8Depth, stCurrentPosition, u16Offset););
-                    m_pUDPContext->seek(u16Offset);
-                    if (_readRRDomain_Loop(p_rRRDomain, p_u8Depth + 1))     // Do recursion
-                    {
-                        //DEBUG_EX_RX(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRDomain_Loop(%u): Succeeded to read redirected label! Returning to %u\n"), p_u8Depth, stCurrentPosition););
-                        m_pUDPContext->seek(stCurrentPosition);             // Restore after recursion
-                    }
-                    else
-                    {
-                        DEBUG_EX_ERR(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRDomain_Loop(%u): FAILED to read redirected label!\n"), p_u8Depth););
-                        bResult = false;
-                    }
+                    u16ReturnOffset = m_Reader.tell();
                 }
-                else
-                {
-                    DEBUG_EX_ERR(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRDomain_Loop(%u): INVALID offset in redirection!\n"), p_u8Depth););
-                    bResult = false;
-                }
-                break;
+                bResult = m_Reader.seek(u16Offset);     // Continue with the referenced label (u8Len isn't 0)
             }
             else
             {
-                // Normal (uncompressed) label (maybe '\0' only)
-                if (MDNS_DOMAIN_MAXLENGTH > (p_rRRDomain.m_u16NameLength + u8Len))
+                DEBUG_EX_ERR(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRDomain: INVALID redirection (%u) from %u to %u!\n"), u8Redirections, u16LabelOffset, u16Offset););
+                bResult = false;
+            }
+        }
+        else if (MDNS_DOMAIN_LABEL_MAXLENGTH < u8Len)
+        {
+            // 0x40 and 0x80 prefixes (extended label types) aren't supported
+            DEBUG_EX_ERR(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRDomain: INVALID label length %u at %u!\n"), u8Len, u16LabelOffset););
+            bResult = false;
+        }
+        else
+        {
+            // Normal (uncompressed) label (maybe '\0' only)
+            if (MDNS_DOMAIN_MAXLENGTH > (p_rRRDomain.m_u16NameLength + u8Len))
+            {
+                // Add length byte
+                p_rRRDomain.m_acName[p_rRRDomain.m_u16NameLength] = u8Len;
+                ++(p_rRRDomain.m_u16NameLength);
+                if (u8Len)      // Add name
                 {
-                    // Add length byte
-                    p_rRRDomain.m_acName[p_rRRDomain.m_u16NameLength] = u8Len;
-                    ++(p_rRRDomain.m_u16NameLength);
-                    if (u8Len)      // Add name
+                    if ((bResult = _udpReadBuffer((unsigned char*) & (p_rRRDomain.m_acName[p_rRRDomain.m_u16NameLength]), u8Len)))
                     {
-                        if ((bResult = _udpReadBuffer((unsigned char*) & (p_rRRDomain.m_acName[p_rRRDomain.m_u16NameLength]), u8Len)))
-                        {
-                            /*  DEBUG_EX_INFO(
-                                    p_rRRDomain.m_acName[p_rRRDomain.m_u16NameLength + u8Len] = 0;  // Closing '\0' for printing
-                                    DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRDomain_Loop(%u): Domain label (%u): %s\n"), p_u8Depth, (unsigned)(p_rRRDomain.m_acName[p_rRRDomain.m_u16NameLength - 1]), &(p_rRRDomain.m_acName[p_rRRDomain.m_u16NameLength]));
-                                    );*/
-
-                            p_rRRDomain.m_u16NameLength += u8Len;
-                        }
+                        p_rRRDomain.m_u16NameLength += u8Len;
                     }
-                    //DEBUG_EX_INFO(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRDomain_Loop(2) offset:%u p0:%x\n"), m_pUDPContext->tell(), m_pUDPContext->peek()););
-                }
-                else
-                {
-                    DEBUG_EX_ERR(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRDomain_Loop(%u): ERROR! Domain name too long (%u + %u)!\n"), p_u8Depth, p_rRRDomain.m_u16NameLength, u8Len););
-                    bResult = false;
-                    break;
                 }
             }
-        } while ((bResult) &&
-                 (0 != u8Len));
-    }
-    else
+            else
+            {
+                DEBUG_EX_ERR(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRDomain: ERROR! Domain name too long (%u + %u)!\n"), p_rRRDomain.m_u16NameLength, u8Len););
+                bResult = false;
+            }
+        }
+    } while ((bResult) &&
+             (0 != u8Len));
+
+    if ((bResult) &&
+            (u8Redirections))
     {
-        DEBUG_EX_ERR(DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRDomain_Loop(%u): ERROR! Too many redirections!\n"), p_u8Depth););
+        bResult = m_Reader.seek(u16ReturnOffset);   // Restore after redirection(s)
     }
+    DEBUG_EX_ERR(if (!bResult) DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _readRRDomain: FAILED!\n")););
     return bResult;
 }
 
@@ -1035,16 +1148,17 @@ bool MDNSResponder::_buildDomainForReverseIP6(IPAddress p_IP4Address,
 
 /*
     MDNSResponder::_udpReadBuffer
+
+    Reads from the received message (in place, see stcMDNSPacketReader).
 */
 bool MDNSResponder::_udpReadBuffer(unsigned char* p_pBuffer,
                                    size_t p_stLength)
 {
 
-    bool    bResult = ((m_pUDPContext) &&
-                       (true/*m_pUDPContext->getSize() > p_stLength*/) &&
-                       (p_pBuffer) &&
+    bool    bResult = ((p_pBuffer) &&
                        (p_stLength) &&
-                       ((p_stLength == m_pUDPContext->read((char*)p_pBuffer, p_stLength))));
+                       (p_stLength <= m_Reader.available()) &&
+                       (m_Reader.read(p_pBuffer, p_stLength)));
     DEBUG_EX_ERR(if (!bResult)
 {
     DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _udpReadBuffer: FAILED!\n"));
@@ -1104,6 +1218,12 @@ bool MDNSResponder::_udpAppendBuffer(const unsigned char* p_pcBuffer,
                     (p_pcBuffer) &&
                     (p_stLength) &&
                     (p_stLength == m_pUDPContext->append((const char*)p_pcBuffer, p_stLength)));
+    if ((bResult) &&
+            (m_AnswerCache.m_pBuilding) &&
+            (!m_AnswerCache.m_pBuilding->append(p_pcBuffer, p_stLength)))   // Answer cache can't grow: don't keep this answer
+    {
+        m_AnswerCache.m_bBuildFailed = true;
+    }
     DEBUG_EX_ERR(if (!bResult)
 {
     DEBUG_OUTPUT.printf_P(PSTR("[MDNSResponder] _udpAppendBuffer: FAILED!\n"));
@@ -1149,7 +1269,7 @@ bool MDNSResponder::_udpDump(bool p_bMovePointer /*= false*/)
 
     const uint8_t   cu8BytesPerLine = 16;
 
-    uint32_t        u32StartPosition = m_pUDPContext->tell();
+    uint32_t        u32StartPosition = m_Reader.tell();
     DEBUG_OUTPUT.println("UDP Context Dump:");
     uint32_t    u32Counter = 0;
     uint8_t     u8Byte = 0;
@@ -1162,7 +1282,7 @@ bool MDNSResponder::_udpDump(bool p_bMovePointer /*= false*/)
 
     if (!p_bMovePointer)    // Restore
     {
-        m_pUDPContext->seek(u32StartPosition);
+        m_Reader.seek(u32StartPosition);
     }
     return true;
 }
@@ -1174,19 +1294,17 @@ bool MDNSResponder::_udpDump(unsigned p_uOffset,
                              unsigned p_uLength)
 {
 
-    if ((m_pUDPContext) &&
-            (m_pUDPContext->isValidOffset(p_uOffset)))
-    {
-        unsigned    uCurrentPosition = m_pUDPContext->tell();   // Remember start position
+    unsigned    uCurrentPosition = m_Reader.tell();     // Remember start position
 
-        m_pUDPContext->seek(p_uOffset);
+    if (m_Reader.seek(p_uOffset))
+    {
         uint8_t u8Byte;
         for (unsigned u = 0; ((u < p_uLength) && (_udpRead8(u8Byte))); ++u)
         {
             DEBUG_OUTPUT.printf_P(PSTR("%02x "), u8Byte);
         }
         // Return to start position
-        m_pUDPContext->seek(uCurrentPosition);
+        m_Reader.seek(uCurrentPosition);
     }
     return true;
 }
@@ -1641,12 +1759,13 @@ bool MDNSResponder::_writeMDNSAnswer_TXT(MDNSResponder::stcMDNSService& p_rServi
             unsigned char       ucLengthByte = pTxt->length();
             bResult = ((_udpAppendBuffer((unsigned char*)&ucLengthByte, sizeof(ucLengthByte))) &&   // Length
                        (p_rSendParameter.shiftOffset(sizeof(ucLengthByte))) &&
-                       ((size_t)os_strlen(pTxt->m_pcKey) == m_pUDPContext->append(pTxt->m_pcKey, os_strlen(pTxt->m_pcKey))) &&          // Key
+                       (_udpAppendBuffer((const unsigned char*)pTxt->m_pcKey, os_strlen(pTxt->m_pcKey))) &&          // Key
                        (p_rSendParameter.shiftOffset((size_t)os_strlen(pTxt->m_pcKey))) &&
-                       (1 == m_pUDPContext->append("=", 1)) &&                                                                          // =
+                       (_udpAppendBuffer((const unsigned char*)"=", 1)) &&                                          // =
                        (p_rSendParameter.shiftOffset(1)) &&
                        ((!pTxt->m_pcValue) ||
-                        (((size_t)os_strlen(pTxt->m_pcValue) == m_pUDPContext->append(pTxt->m_pcValue, os_strlen(pTxt->m_pcValue))) &&  // Value
+                        (!*pTxt->m_pcValue) ||
+                        ((_udpAppendBuffer((const unsigned char*)pTxt->m_pcValue, os_strlen(pTxt->m_pcValue))) &&    // Value
                          (p_rSendParameter.shiftOffset((size_t)os_strlen(pTxt->m_pcValue))))));
 
             DEBUG_EX_ERR(if (!bResult)
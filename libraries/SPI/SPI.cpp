@@ -87,6 +87,13 @@ void SPIClass::begin() {
 }
 
 void SPIClass::end() {
+    if (_isrAttached) {
+        wait();
+        ETS_SPI_INTR_DISABLE();
+        ETS_SPI_INTR_ATTACH(NULL, NULL);
+        _isrAttached = false;
+    }
+
     switch (pinSet) {
     case SPI_PINS_HSPI:
         pinMode(SCK, INPUT);
@@ -140,6 +147,11 @@ void SPIClass::setHwCs(bool use) {
 }
 
 void SPIClass::beginTransaction(SPISettings settings) {
+    while(busy()) {
+        // a long queue (a display frame at a low clock) must not trip the
+        // watchdog (it can when called from an interrupt, which can't yield)
+        optimistic_yield(1000);
+    }
     while(SPI1CMD & SPIBUSY) {}
     setFrequency(settings._clock);
     setBitOrder(settings._bitOrder);
@@ -616,6 +628,90 @@ void SPIClass::transferBytes_(const uint8_t * out, uint8_t * in, uint8_t size) {
 }
 
 
+// Hardware side of the transaction queue (SPIQueue.cpp)
+
+void IRAM_ATTR SPIClass::_isr(void * arg, void * frame) {
+    (void) frame;
+    if (!(SPIIR & (1 << SPII1)) || !(SPI1S & SPISTRIS)) {
+        return;
+    }
+    SPI1S &= ~SPISTRIS;
+    if (SPI1CMD & SPIBUSY) {
+        // status left by an earlier transfer, the chunk being clocked out
+        // sets it again when done (SPIBUSY is read after clearing it)
+        return;
+    }
+    static_cast<SPIClass *>(arg)->_transferred();
+}
+
+void IRAM_ATTR SPIClass::_queueEnable(bool enable) {
+    if (!enable) {
+        SPI1S &= ~SPISTRIE;
+        return;
+    }
+    if (!_isrAttached) {
+        ETS_SPI_INTR_ATTACH(_isr, this);
+        ETS_SPI_INTR_ENABLE();
+        _isrAttached = true;
+    }
+    while(SPI1CMD & SPIBUSY) {}
+    // synchronous transfers leave their trans-done status set, it would
+    // trigger the interrupt during the first chunk
+    SPI1S &= ~SPISTRIS;
+    SPI1S |= SPISTRIE;
+}
+
+void SPIClass::_queuePoll() {
+    // transfers are driven by the interrupt
+}
+
+void IRAM_ATTR SPIClass::_writeChunk(const uint8_t * out) {
+    // setDataBits(), which may not be in IRAM
+    const uint32_t mask = ~((SPIMMOSI << SPILMOSI) | (SPIMMISO << SPILMISO));
+    const uint32_t bits = _chunk * 8 - 1;
+    SPI1U1 = ((SPI1U1 & mask) | ((bits << SPILMOSI) | (bits << SPILMISO)));
+
+    volatile uint32_t * fifoPtr = &SPI1W0;
+    if (!out) {
+        for (uint8_t i = 0; i < _chunk; i += 4) {
+            *(fifoPtr++) = 0xFFFFFFFF;
+        }
+    } else if (!((uintptr_t)out & 3)) {
+        const uint32_t * dataPtr = (const uint32_t *) out;
+        for (uint8_t i = 0; i < _chunk; i += 4) {
+            *(fifoPtr++) = *(dataPtr++);
+        }
+    } else {
+        for (uint8_t i = 0; i < _chunk; i += 4) {
+            uint32_t word = 0;
+            for (uint8_t b = 0; b < 4 && i + b < _chunk; b++) {
+                word |= (uint32_t)out[i + b] << (8 * b);
+            }
+            *(fifoPtr++) = word;
+        }
+    }
+
+    __sync_synchronize();
+    SPI1CMD |= SPIBUSY;
+}
+
+void IRAM_ATTR SPIClass::_readChunk(uint8_t * in) {
+    volatile uint32_t * fifoPtr = &SPI1W0;
+    uint8_t inSize = _chunk;
+    if (!((uintptr_t)in & 3)) {
+        uint32_t * dataPtr = (uint32_t *) in;
+        while (inSize >= 4) {
+            *(dataPtr++) = *(fifoPtr++);
+            inSize -= 4;
+            in += 4;
+        }
+    }
+    volatile uint8_t * fifoPtrB = (volatile uint8_t *) fifoPtr;
+    while (inSize--) {
+        *(in++) = *(fifoPtrB++);
+    }
+}
+
 #if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_SPI)
 SPIClass SPI;
 #endif
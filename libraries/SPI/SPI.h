@@ -22,6 +22,7 @@
 #define _SPI_H_INCLUDED
 
 #include <Arduino.h>
+#include <functional>
 
 #define SPI_HAS_TRANSACTION 1
 
@@ -49,6 +50,24 @@ public:
   uint8_t  _dataMode;
 };
 
+struct SPITransaction;
+typedef std::function<void(SPITransaction&)> SPICallback;
+
+// an asynchronous transfer, see SPIClass::queue()
+struct SPITransaction {
+  const uint8_t * out = nullptr; ///< sent, 0xff bytes when null
+  uint8_t * in = nullptr;        ///< received, unless null (can be out)
+  uint32_t size = 0;
+  int8_t cs = -1;                ///< pin driven low during the transfer, unless -1
+  bool keepCs = false;           ///< cs stays low for the next transaction (chained)
+  volatile bool done = false;    ///< transferred, and the callback called
+
+  // used by SPIClass
+  SPITransaction * _next = nullptr;
+  uint32_t _sent = 0;
+  SPICallback _callback;
+};
+
 class SPIClass {
 public:
   SPIClass();
@@ -73,6 +92,18 @@ public:
   void writePattern(const uint8_t * data, uint8_t size, uint32_t repeat);
   void transferBytes(const uint8_t * out, uint8_t * in, uint32_t size);
   void endTransaction(void);
+
+  // Interrupt driven transfers: 'txn' is sent after the transactions queued
+  // before it, while loop() runs, and 'callback' is then called from loop().
+  // 'txn' and its buffers (in RAM) must be kept until txn.done, and
+  // SPIClass until the callbacks are called.
+  // beginTransaction() waits for the queue to be empty, yielding meanwhile.
+  bool queue(SPITransaction & txn, SPICallback callback = nullptr);
+  // also retries handing the callbacks over to loop() when the scheduled
+  // function ring was full
+  bool busy(void);
+  // until the queue is empty, and the callbacks called
+  void wait(void);
 private:
   bool useHwCs;
   uint8_t pinSet;
@@ -80,6 +111,25 @@ private:
   void transferBytes_(const uint8_t * out, uint8_t * in, uint8_t size);
   void transferBytesAligned_(const uint8_t * out, uint8_t * in, uint8_t size);
   inline void setDataBits(uint16_t bits);
+
+  SPITransaction * volatile _queueHead = nullptr; // being transferred
+  SPITransaction * _queueTail = nullptr;
+  SPITransaction * volatile _doneHead = nullptr;  // waiting for their callback
+  SPITransaction * _doneTail = nullptr;
+  volatile bool _doneScheduled = false;
+  bool _isrAttached = false;
+  uint8_t _chunk = 0;
+  static void _isr(void * arg, void * frame);
+  void _startTransaction();
+  void _startChunk();
+  void _transferred();
+  void _scheduleCallbacks();
+  void _runCallbacks();
+  // hardware access, emulated on host
+  void _queueEnable(bool enable);
+  void _queuePoll();
+  void _writeChunk(const uint8_t * out);
+  void _readChunk(uint8_t * in);
 };
 
 #if !defined(NO_GLOBAL_INSTANCES) && !defined(NO_GLOBAL_SPI)
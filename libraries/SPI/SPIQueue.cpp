@@ -0,0 +1,158 @@
+/*
+ SPIQueue.cpp - SPI transaction queue for esp8266
+
+ This file is part of the esp8266 core for Arduino environment.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+// Queue bookkeeping, independent of the hardware.  The FIFO and register
+// accesses are in SPI.cpp (_queueEnable, _writeChunk, _readChunk,
+// _queuePoll), and replaced by the host emulation in tests/host.
+
+#include "SPI.h"
+#include <Schedule.h>
+#include <interrupts.h>
+
+/**
+ * The queued transactions are sent by chunks of 64 bytes (the FIFO), each
+ * one loaded by the SPI interrupt when the previous one is transferred.
+ * Note: the SPI interrupt is shared with SPISlave, both can't be used.
+ * @param txn SPITransaction &
+ * @param callback SPICallback called from loop() when txn is transferred
+ * @return false if txn is empty
+ */
+bool SPIClass::queue(SPITransaction & txn, SPICallback callback) {
+    if (!txn.size) {
+        return false;
+    }
+    txn.done = false;
+    txn._next = nullptr;
+    txn._sent = 0;
+    txn._callback = std::move(callback);
+
+    esp8266::InterruptLock lock;
+    if (_queueHead) {
+        _queueTail->_next = &txn;
+        _queueTail = &txn;
+    } else {
+        _queueHead = _queueTail = &txn;
+        _queueEnable(true);
+        _startTransaction();
+    }
+    return true;
+}
+
+bool SPIClass::busy() {
+    _queuePoll();
+    {
+        esp8266::InterruptLock lock;
+        if (_doneHead && !_doneScheduled) {
+            // the scheduled function ring was full
+            _scheduleCallbacks();
+        }
+    }
+    return _queueHead != nullptr;
+}
+
+void SPIClass::wait() {
+    while (busy()) {
+        yield();
+    }
+    _runCallbacks();
+}
+
+void SPIClass::_runCallbacks() {
+    SPITransaction * txn;
+    {
+        esp8266::InterruptLock lock;
+        txn = _doneHead;
+        _doneHead = _doneTail = nullptr;
+        _doneScheduled = false;
+    }
+    while (txn) {
+        SPITransaction * next = txn->_next;
+        txn->_next = nullptr;
+        // txn can be queued again from its callback
+        SPICallback callback = std::move(txn->_callback);
+        txn->_callback = nullptr;
+        txn->done = true;
+        callback(*txn);
+        txn = next;
+    }
+}
+
+void IRAM_ATTR SPIClass::_scheduleCallbacks() {
+    _doneScheduled = schedule_function_isr([this]() { _runCallbacks(); });
+}
+
+void IRAM_ATTR SPIClass::_startTransaction() {
+    if (_queueHead->cs >= 0) {
+        digitalWrite(_queueHead->cs, LOW);
+    }
+    _startChunk();
+}
+
+void IRAM_ATTR SPIClass::_startChunk() {
+    SPITransaction & txn = *_queueHead;
+    uint32_t size = txn.size - txn._sent;
+    _chunk = size > 64 ? 64 : size;
+    _writeChunk(txn.out ? txn.out + txn._sent : nullptr);
+    txn._sent += _chunk;
+}
+
+// called when a chunk is transferred (interrupt)
+void IRAM_ATTR SPIClass::_transferred() {
+    SPITransaction * txn = _queueHead;
+    if (!txn) {
+        return;
+    }
+
+    if (txn->in) {
+        _readChunk(txn->in + txn->_sent - _chunk);
+    }
+
+    if (txn->_sent < txn->size) {
+        _startChunk();
+        return;
+    }
+
+    if (txn->cs >= 0 && !txn->keepCs) {
+        digitalWrite(txn->cs, HIGH);
+    }
+    _queueHead = txn->_next;
+    txn->_next = nullptr;
+    if (_queueHead) {
+        _startTransaction();
+    } else {
+        _queueTail = nullptr;
+        _queueEnable(false);
+    }
+
+    if (!txn->_callback) {
+        txn->done = true;
+        return;
+    }
+    if (_doneHead) {
+        _doneTail->_next = txn;
+    } else {
+        _doneHead = txn;
+    }
+    _doneTail = txn;
+    if (!_doneScheduled) {
+        // if the ring is full, this is tried again by busy() and wait()
+        _scheduleCallbacks();
+    }
+}
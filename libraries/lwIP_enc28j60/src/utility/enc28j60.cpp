@@ -75,6 +75,9 @@ void serial_printf(const char *fmt, ...)
 #define ECON2_AUTOINC 0x80
 #define ECON2_PKTDEC  0x40
 
+#define EIE_INTIE     0x80
+#define EIE_PKTIE     0x40
+
 #define EIR_TXIF      0x08
 
 #define ERXTX_BANK 0x00
@@ -632,6 +635,44 @@ ENC28J60::sendFrame(const uint8_t *data, uint16_t datalen)
 
 /*---------------------------------------------------------------------------*/
 
+void
+ENC28J60::enableRxInterrupt()
+{
+    setregbitfield(EIE, EIE_INTIE | EIE_PKTIE);
+}
+
+void
+ENC28J60::ackRxInterrupt()
+{
+    /* EIR.PKTIF is cleared by hardware once all frames are read */
+}
+
+/*---------------------------------------------------------------------------*/
+
+void
+ENC28J60::releaseframe(void)
+{
+    /* Read an additional byte at odd lengths, to avoid FIFO corruption */
+    if ((_len % 2) != 0)
+    {
+        readdatabyte();
+    }
+
+    /* Errata #14 */
+    if (_next == RX_BUF_START)
+    {
+        _next = RX_BUF_END;
+    }
+    else
+    {
+        _next = _next - 1;
+    }
+    writereg(ERXRDPTL, _next & 0xff);
+    writereg(ERXRDPTH, _next >> 8);
+
+    setregbitfield(ECON2, ECON2_PKTDEC);
+}
+
 uint16_t
 ENC28J60::readFrame(uint8_t *buffer, uint16_t bufsize)
 {
@@ -708,25 +749,7 @@ ENC28J60::readFrameData(uint8_t *buffer, uint16_t framesize)
         readdata(buffer, _len);
     }
 
-    /* Read an additional byte at odd lengths, to avoid FIFO corruption */
-    if ((_len % 2) != 0)
-    {
-        readdatabyte();
-    }
-
-    /* Errata #14 */
-    if (_next == RX_BUF_START)
-    {
-        _next = RX_BUF_END;
-    }
-    else
-    {
-        _next = _next - 1;
-    }
-    writereg(ERXRDPTL, _next & 0xff);
-    writereg(ERXRDPTH, _next >> 8);
-
-    setregbitfield(ECON2, ECON2_PKTDEC);
+    releaseframe();
 
     if (!buffer)
     {
@@ -742,3 +765,14 @@ ENC28J60::readFrameData(uint8_t *buffer, uint16_t framesize)
 
     return _len;
 }
+
+uint16_t
+ENC28J60::readFrameChunk(uint8_t *chunk, uint16_t chunksize, bool last)
+{
+    readdata(chunk, chunksize);
+    if (last)
+    {
+        releaseframe();
+    }
+    return chunksize;
+}
@@ -84,9 +84,21 @@ protected:
 
     static constexpr bool interruptIsPossible()
     {
-        return false;
+        return true;
     }
 
+    /**
+        Enable the interrupt pin on frame reception
+        (active low, asserted until acknowledged)
+    */
+    void enableRxInterrupt();
+
+    /**
+        Acknowledge frame reception interrupt,
+        to be called before reading pending frames
+    */
+    void ackRxInterrupt();
+
     /**
         Read an Ethernet frame size
         @return the length of data do receive
@@ -111,6 +123,19 @@ protected:
     */
     uint16_t readFrameData(uint8_t *frame, uint16_t framesize);
 
+    /**
+        Read a part of an Ethernet frame data
+           readFrameSize() must be called first,
+           then the frame is read in consecutive chunks
+           whose sizes sum up to readFrameSize()'s result
+        @param chunk a pointer to a buffer to write the chunk to
+        @param chunksize size of the chunk
+        @param last true for the last chunk, the frame is then released
+        @return chunksize
+               or 0 if a problem occurred
+    */
+    uint16_t readFrameChunk(uint8_t *chunk, uint16_t chunksize, bool last);
+
 private:
 
     uint8_t is_mac_mii_reg(uint8_t reg);
@@ -126,6 +151,7 @@ private:
     void softreset(void);
     uint8_t readrev(void);
     bool reset(void);
+    void releaseframe(void);
 
     void enc28j60_arch_spi_init(void);
     uint8_t enc28j60_arch_spi_write(uint8_t data);
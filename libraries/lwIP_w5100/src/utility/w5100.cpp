@@ -260,6 +260,16 @@ void Wiznet5100::end()
     while (getSn_SR() != SOCK_CLOSED);
 }
 
+void Wiznet5100::enableRxInterrupt()
+{
+    wizchip_write(IMR, 0x01); // socket 0
+}
+
+void Wiznet5100::ackRxInterrupt()
+{
+    setSn_IR(Sn_IR_RECV);
+}
+
 uint16_t Wiznet5100::readFrame(uint8_t *buffer, uint16_t bufsize)
 {
     uint16_t data_len = readFrameSize();
@@ -329,6 +339,16 @@ uint16_t Wiznet5100::readFrameData(uint8_t *buffer, uint16_t framesize)
 #endif
 }
 
+uint16_t Wiznet5100::readFrameChunk(uint8_t *chunk, uint16_t chunksize, bool last)
+{
+    wizchip_recv_data(chunk, chunksize);
+    if (last)
+    {
+        setSn_CR(Sn_CR_RECV);
+    }
+    return chunksize;
+}
+
 uint16_t Wiznet5100::sendFrame(const uint8_t *buf, uint16_t len)
 {
     // Wait for space in the transmit buffer
@@ -332,6 +332,17 @@ void Wiznet5500::end()
     while (getSn_SR() != SOCK_CLOSED);
 }
 
+void Wiznet5500::enableRxInterrupt()
+{
+    setSn_IMR(Sn_IR_RECV);
+    wizchip_write(BlockSelectCReg, SIMR, 0x01); // socket 0
+}
+
+void Wiznet5500::ackRxInterrupt()
+{
+    setSn_IR(Sn_IR_RECV);
+}
+
 uint16_t Wiznet5500::readFrame(uint8_t *buffer, uint16_t bufsize)
 {
     uint16_t data_len = readFrameSize();
@@ -402,6 +413,16 @@ uint16_t Wiznet5500::readFrameData(uint8_t *buffer, uint16_t framesize)
 #endif
 }
 
+uint16_t Wiznet5500::readFrameChunk(uint8_t *chunk, uint16_t chunksize, bool last)
+{
+    wizchip_recv_data(chunk, chunksize);
+    if (last)
+    {
+        setSn_CR(Sn_CR_RECV);
+    }
+    return chunksize;
+}
+
 uint16_t Wiznet5500::sendFrame(const uint8_t *buf, uint16_t len)
 {
     // Wait for space in the transmit buffer
@@ -87,9 +87,21 @@ protected:
 
     static constexpr bool interruptIsPossible()
     {
-        return false;
+        return true;
     }
 
+    /**
+        Enable the interrupt pin on frame reception
+        (active low, asserted until acknowledged)
+    */
+    void enableRxInterrupt();
+
+    /**
+        Acknowledge frame reception interrupt,
+        to be called before reading pending frames
+    */
+    void ackRxInterrupt();
+
     /**
         Read an Ethernet frame size
         @return the length of data do receive
@@ -114,6 +126,19 @@ protected:
     */
     uint16_t readFrameData(uint8_t *frame, uint16_t framesize);
 
+    /**
+        Read a part of an Ethernet frame data
+           readFrameSize() must be called first,
+           then the frame is read in consecutive chunks
+           whose sizes sum up to readFrameSize()'s result
+        @param chunk a pointer to a buffer to write the chunk to
+        @param chunksize size of the chunk
+        @param last true for the last chunk, the frame is then released
+        @return chunksize
+               or 0 if a problem occurred
+    */
+    uint16_t readFrameChunk(uint8_t *chunk, uint16_t chunksize, bool last);
+
 
 private:
 
@@ -0,0 +1,60 @@
+/*
+ bench.h - minimal benchmark harness for host builds
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+#ifndef __HOST_BENCH_H
+#define __HOST_BENCH_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace bench
+{
+
+struct Case
+{
+    const char* name;
+    void (*run)(uint32_t iterations);
+    uint32_t iterations;
+};
+
+std::vector<Case>& cases();
+
+struct Register
+{
+    Register(const char* name, void (*run)(uint32_t), uint32_t iterations)
+    {
+        cases().push_back({ name, run, iterations });
+    }
+};
+
+// prevents the compiler from optimizing away a computation whose result is unused
+template<typename T>
+inline void keep(const T& value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+} // namespace bench
+
+#define BENCH_CONCAT2(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT2(a, b)
+
+// BENCHMARK("name", iterations) { for (uint32_t i = 0; i < iterations; i++) ... }
+// (names are used as keys in CSV files: no comma)
+#define BENCHMARK(name, count) \
+    static void BENCH_CONCAT(bench_run_, __LINE__)(uint32_t iterations); \
+    static bench::Register BENCH_CONCAT(bench_register_, __LINE__)(name, BENCH_CONCAT(bench_run_, __LINE__), count); \
+    static void BENCH_CONCAT(bench_run_, __LINE__)(uint32_t iterations)
+
+#endif
@@ -0,0 +1,138 @@
+/*
+ bench_hash.cpp - base64, MD5 and CRC32 on typical buffer sizes
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+#include <Arduino.h>
+#include <base64.h>
+#include <MD5Builder.h>
+#include <coredecls.h>
+#include <libb64/cdecode.h>
+#include "bench.h"
+
+namespace
+{
+
+// pseudo random, but the same on every run
+const uint8_t* data(size_t size)
+{
+    static std::vector<uint8_t> bytes;
+    if (bytes.size() < size)
+    {
+        uint32_t x = 0x12345678;
+        bytes.resize(size);
+        for (uint8_t& b : bytes)
+        {
+            x = x * 1103515245 + 12345;
+            b = x >> 24;
+        }
+    }
+    return bytes.data();
+}
+
+} // namespace
+
+BENCHMARK("base64 encode 48 bytes", 200000)
+{
+    const uint8_t* input = data(48);
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        String encoded = base64::encode(input, 48);
+        bench::keep(encoded);
+    }
+}
+
+BENCHMARK("base64 encode 4 KB", 5000)
+{
+    const uint8_t* input = data(4096);
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        String encoded = base64::encode(input, 4096);
+        bench::keep(encoded);
+    }
+}
+
+BENCHMARK("base64 decode 4 KB", 5000)
+{
+    const String encoded = base64::encode(data(4096), 4096);
+    std::vector<char> decoded(base64_decode_expected_len(encoded.length()) + 1);
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        if (base64_decode_chars(encoded.c_str(), encoded.length(), decoded.data()) != 4096)
+            abort();
+    }
+}
+
+BENCHMARK("MD5Builder 64 bytes", 200000)
+{
+    const uint8_t* input = data(64);
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        MD5Builder md5;
+        md5.begin();
+        md5.add(input, 64);
+        md5.calculate();
+        uint8_t digest[16];
+        md5.getBytes(digest);
+        bench::keep(digest);
+    }
+}
+
+BENCHMARK("MD5Builder 4 KB", 10000)
+{
+    const uint8_t* input = data(4096);
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        MD5Builder md5;
+        md5.begin();
+        md5.add(input, 4096);
+        md5.calculate();
+        uint8_t digest[16];
+        md5.getBytes(digest);
+        bench::keep(digest);
+    }
+}
+
+BENCHMARK("crc32 64 bytes", 100000)
+{
+    const uint8_t* input = data(64);
+    uint32_t crc = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+        crc ^= crc32(input, 64);
+    bench::keep(crc);
+}
+
+BENCHMARK("crc32 4 KB", 500)
+{
+    const uint8_t* input = data(4096);
+    uint32_t crc = 0;
+    for (uint32_t i = 0; i < iterations; i++)
+        crc ^= crc32(input, 4096);
+    bench::keep(crc);
+}
+
+// crc32() variants (see crc32.cpp), on a flash sector; the tables are in RAM
+// on the host, so their placement can only be compared on the device
+#define BENCH_CRC32(variant, count) \
+    BENCHMARK("crc32 4 KB " #variant, count) \
+    { \
+        const uint8_t* input = data(4096); \
+        uint32_t crc = 0; \
+        for (uint32_t i = 0; i < iterations; i++) \
+            crc ^= crc32_##variant(input, 4096, 0xffffffff); \
+        bench::keep(crc); \
+    }
+
+BENCH_CRC32(bitwise, 100)
+BENCH_CRC32(slice1, 500)
+BENCH_CRC32(slice4, 500)
+BENCH_CRC32(slice8, 500)
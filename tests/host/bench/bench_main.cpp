@@ -0,0 +1,184 @@
+/*
+ bench_main.cpp - runs the host benchmarks
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "bench.h"
+
+// mocks (MockEsp.cpp) stay quiet while measuring
+int mockverbose(const char* fmt, ...)
+{
+    (void)fmt;
+    return 0;
+}
+
+std::vector<bench::Case>& bench::cases()
+{
+    static std::vector<Case> all;
+    return all;
+}
+
+namespace
+{
+
+struct Baseline
+{
+    double nsPerIteration;
+    double thresholdPercent; // < 0: use the command line threshold
+};
+
+// reads "name,iterations,ns/iteration[,threshold %]" lines, as written by -c
+bool readBaseline(const char* path, std::map<std::string, Baseline>& baseline)
+{
+    FILE* file = fopen(path, "r");
+    if (!file)
+        return false;
+
+    char line[256];
+    while (fgets(line, sizeof line, file))
+    {
+        line[strcspn(line, "\r\n")] = 0;
+        char* fields[4] = { line, nullptr, nullptr, nullptr };
+        int count = 1;
+        for (char* p = line; *p && count < 4; p++)
+            if (*p == ',')
+            {
+                *p = 0;
+                fields[count++] = p + 1;
+            }
+        if (count < 3 || !strcmp(fields[0], "name"))
+            continue; // header or malformed line
+
+        baseline[fields[0]] = { atof(fields[2]), count > 3 ? atof(fields[3]) : -1 };
+    }
+
+    fclose(file);
+    return true;
+}
+
+void usage(const char* name)
+{
+    fprintf(stderr,
+        "usage: %s [-r runs] [-c results.csv] [-b baseline.csv] [-t threshold%%] [name filter]\n"
+        "  -r  timed runs per benchmark, the fastest one is reported (default 5)\n"
+        "  -c  write the results as CSV (name,iterations,ns/iteration)\n"
+        "  -b  compare with a CSV file written by -c, which may have a 4th column\n"
+        "      with a threshold for that benchmark; exit status is 1 on regression\n"
+        "  -t  slowdown tolerated before reporting a regression, in %% (default 10)\n",
+        name);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    unsigned runs = 5;
+    const char* csvPath = nullptr;
+    const char* baselinePath = nullptr;
+    double thresholdPercent = 10;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "r:c:b:t:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'r': runs = atoi(optarg) > 0 ? atoi(optarg) : 1; break;
+        case 'c': csvPath = optarg; break;
+        case 'b': baselinePath = optarg; break;
+        case 't': thresholdPercent = atof(optarg); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    const char* filter = optind < argc ? argv[optind] : nullptr;
+
+    std::map<std::string, Baseline> baseline;
+    if (baselinePath && !readBaseline(baselinePath, baseline))
+    {
+        fprintf(stderr, "cannot read baseline '%s'\n", baselinePath);
+        return 2;
+    }
+
+    FILE* csv = nullptr;
+    if (csvPath)
+    {
+        csv = fopen(csvPath, "w");
+        if (!csv)
+        {
+            fprintf(stderr, "cannot write '%s'\n", csvPath);
+            return 2;
+        }
+        fprintf(csv, "name,iterations,ns/iteration\n");
+    }
+
+    setvbuf(stdout, nullptr, _IOLBF, 0); // show progress when piped
+
+    unsigned regressions = 0;
+    for (const bench::Case& c : bench::cases())
+    {
+        if (filter && !strstr(c.name, filter))
+            continue;
+
+        c.run(c.iterations / 10 + 1); // warm up caches and allocator
+
+        // the fastest run is the least disturbed by the host
+        double best = 0;
+        for (unsigned run = 0; run < runs; run++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            c.run(c.iterations);
+            std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+            double nsPerIteration = elapsed.count() / c.iterations;
+            if (run == 0 || nsPerIteration < best)
+                best = nsPerIteration;
+        }
+
+        printf("%-48s %10u iterations %12.1f ns/iteration", c.name, c.iterations, best);
+        if (csv)
+            fprintf(csv, "%s,%u,%.1f\n", c.name, c.iterations, best);
+
+        if (baselinePath)
+        {
+            auto reference = baseline.find(c.name);
+            if (reference == baseline.end() || reference->second.nsPerIteration <= 0)
+                printf("   (no baseline)");
+            else
+            {
+                double threshold = reference->second.thresholdPercent >= 0 ? reference->second.thresholdPercent : thresholdPercent;
+                double change = (best / reference->second.nsPerIteration - 1) * 100;
+                printf(" %+7.1f%%", change);
+                if (change > threshold)
+                {
+                    printf("   REGRESSION (> %.0f%%)", threshold);
+                    regressions++;
+                }
+            }
+        }
+        printf("\n");
+    }
+
+    if (csv)
+        fclose(csv);
+
+    if (regressions)
+    {
+        printf("%u benchmark(s) regressed\n", regressions);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,146 @@
+/*
+ bench_mesh_metadata.cpp - FloodingMesh metadata encoding and decoding
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+
+#include <Arduino.h>
+#include <TypeConversion.h>
+#include <FloodingMeshMetadata.h>
+#include "bench.h"
+
+// The text format below mirrors FloodingMesh::broadcast() and its broadcast filter and request handler:
+// targetMeshName, delimiter, 16 hexadecimal characters messageID, delimiter, message.
+// (FloodingMesh.cpp and its TypeConversionFunctions need the ESP-NOW backend, which is not emulated.)
+// The binary format (FloodingMesh::MetadataFormat::BINARY) uses the FloodingMeshMetadata functions called by FloodingMesh.
+
+namespace
+{
+
+constexpr char delimiter = 23;
+
+const uint8_t mac[6] = { 0x5e, 0xcf, 0x7f, 0x12, 0x34, 0x56 };
+const String meshName = "MeshNode_";
+const String message = "Hello world! This is a typical FloodingMesh message body of moderate length.";
+
+String textMessageID(uint16_t count)
+{
+    char countArray[5];
+    snprintf(countArray, sizeof countArray, "%04X", count);
+    return experimental::TypeConversion::uint8ArrayToHexString(mac, 6) + String(countArray);
+}
+
+uint64_t hexToUint64(const String& hex)
+{
+    uint64_t result = 0;
+    for (uint32_t i = 0; i < hex.length(); ++i)
+    {
+        char c = hex.charAt(i);
+        result = result << 4 | (c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+    }
+    return result;
+}
+
+String encodeText(uint16_t count)
+{
+    return meshName + String(delimiter) + textMessageID(count) + String(delimiter) + message;
+}
+
+uint64_t macToUint64()
+{
+    uint64_t result = 0;
+    for (uint8_t byte : mac)
+        result = result << 8 | byte;
+    return result;
+}
+
+String encodeBinary(uint16_t count)
+{
+    return FloodingMeshMetadata::createBinaryMessage(&meshName, macToUint64() << 16 | count, message);
+}
+
+// returns the index of the message body, -1 if rejected
+int32_t decodeText(const String& transmission, uint64_t& messageID)
+{
+    // broadcast filter
+    int32_t metadataEndIndex = transmission.indexOf(delimiter);
+    if (metadataEndIndex == -1)
+        return -1;
+    String targetMeshName = transmission.substring(0, metadataEndIndex);
+    if (!targetMeshName.isEmpty() && targetMeshName != meshName)
+        return -1;
+    int32_t messageIDEndIndex = transmission.indexOf(delimiter, metadataEndIndex + 1);
+    if (messageIDEndIndex == -1)
+        return -1;
+    messageID = hexToUint64(transmission.substring(metadataEndIndex + 1, messageIDEndIndex));
+
+    // request handler, after the filter marked the broadcast
+    String request = String(delimiter) + transmission;
+    int32_t broadcastTargetEndIndex = request.indexOf(delimiter, 1);
+    String remainingRequest = request;
+    remainingRequest.remove(0, broadcastTargetEndIndex + 1);
+    messageIDEndIndex = remainingRequest.indexOf(delimiter);
+    messageID = hexToUint64(remainingRequest.substring(0, messageIDEndIndex));
+    return broadcastTargetEndIndex + messageIDEndIndex + 1;
+}
+
+int32_t decodeBinary(const String& transmission, uint64_t& messageID)
+{
+    // broadcast filter, then request handler
+    if (!FloodingMeshMetadata::acceptBinaryBroadcast(transmission, meshName, messageID))
+        return -1;
+    return FloodingMeshMetadata::getBinaryMessageIndex(transmission, messageID);
+}
+
+} // namespace
+
+BENCHMARK("mesh metadata: text encode", 200000)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        String encoded = encodeText(i);
+        bench::keep(encoded);
+    }
+}
+
+BENCHMARK("mesh metadata: binary encode", 200000)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        String encoded = encodeBinary(i);
+        bench::keep(encoded);
+    }
+}
+
+BENCHMARK("mesh metadata: text decode", 200000)
+{
+    const String encoded = encodeText(0x1234);
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        uint64_t messageID = 0;
+        int32_t bodyIndex = decodeText(encoded, messageID);
+        if (bodyIndex < 0 || messageID != (macToUint64() << 16 | 0x1234) || strcmp(encoded.c_str() + bodyIndex, message.c_str()))
+            abort();
+    }
+}
+
+BENCHMARK("mesh metadata: binary decode", 200000)
+{
+    const String encoded = encodeBinary(0x1234);
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        uint64_t messageID = 0;
+        int32_t bodyIndex = decodeBinary(encoded, messageID);
+        if (bodyIndex < 0 || messageID != (macToUint64() << 16 | 0x1234) || strcmp(encoded.c_str() + bodyIndex, message.c_str()))
+            abort();
+    }
+}
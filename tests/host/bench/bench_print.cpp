@@ -0,0 +1,88 @@
+/*
+ bench_print.cpp - Print::printf() and Print::print() formatting
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+#include <Arduino.h>
+#include "bench.h"
+
+namespace
+{
+
+// counts what would be sent to the output (like a Serial port)
+class CountingPrint: public Print
+{
+public:
+    size_t count = 0;
+
+    virtual size_t write(uint8_t) override
+    {
+        count++;
+        return 1;
+    }
+
+    virtual size_t write(const uint8_t* buffer, size_t size) override
+    {
+        (void)buffer;
+        count += size;
+        return size;
+    }
+};
+
+} // namespace
+
+BENCHMARK("Print::printf short line", 200000)
+{
+    CountingPrint out;
+    for (uint32_t i = 0; i < iterations; i++)
+        out.printf("heap: %u, uptime: %u s\n", 40000 + (i & 0xff), i);
+    bench::keep(out.count);
+}
+
+BENCHMARK("Print::printf_P short line", 200000)
+{
+    CountingPrint out;
+    for (uint32_t i = 0; i < iterations; i++)
+        out.printf_P(PSTR("heap: %u, uptime: %u s\n"), 40000 + (i & 0xff), i);
+    bench::keep(out.count);
+}
+
+BENCHMARK("Print::printf long line (> 64 bytes)", 100000)
+{
+    CountingPrint out;
+    for (uint32_t i = 0; i < iterations; i++)
+        out.printf("[%8u] %s: connected to %s, channel %d, rssi %d dBm, ip %u.%u.%u.%u\n",
+                   i, "WiFi", "my-access-point-name", 6, -67, 192, 168, 1, i & 0xff);
+    bench::keep(out.count);
+}
+
+BENCHMARK("Print::printf floats", 100000)
+{
+    CountingPrint out;
+    for (uint32_t i = 0; i < iterations; i++)
+        out.printf("t=%.2f h=%.1f%%\n", 21.5 + (i & 7) * 0.25, 45.0 + (i & 3));
+    bench::keep(out.count);
+}
+
+BENCHMARK("Print::print numbers", 200000)
+{
+    CountingPrint out;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        out.print(i);
+        out.print(',');
+        out.print((long)-i);
+        out.print(',');
+        out.println(i, HEX);
+    }
+    bench::keep(out.count);
+}
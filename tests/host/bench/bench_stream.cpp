@@ -0,0 +1,216 @@
+/*
+ bench_stream.cpp - Stream::send*() between strings, files and network clients
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+#include <Arduino.h>
+#include <StreamString.h>
+#include <StreamDev.h>
+#include <FS.h>
+#include "../common/spiffs_mock.h"
+#include "bench.h"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+
+namespace
+{
+
+constexpr size_t payloadSize = 16 * 1024;
+constexpr size_t segmentSize = 1460; // TCP_MSS
+
+const String& payload()
+{
+    static String text;
+    if (!text.length())
+    {
+        text.reserve(payloadSize);
+        for (size_t i = 0; i < payloadSize; i++)
+            text += (char)('a' + i % 26);
+    }
+    return text;
+}
+
+// Behaves like a WiFiClient whose peer sent 'input' and closed the connection:
+// received data is read segment by segment (peek buffer API included), and
+// writes are accepted one segment at a time.
+class MockClient: public Stream
+{
+public:
+    MockClient(const String& input = emptyString): _input(input) { }
+
+    void rewind()
+    {
+        _position = 0;
+        _written = 0;
+    }
+
+    size_t written() const { return _written; }
+
+    // Print
+    virtual size_t write(uint8_t) override
+    {
+        _written++;
+        return 1;
+    }
+
+    virtual size_t write(const uint8_t* buffer, size_t size) override
+    {
+        (void)buffer;
+        size = std::min(size, segmentSize);
+        _written += size;
+        return size;
+    }
+
+    virtual int availableForWrite() override { return segmentSize; }
+
+    // Stream
+    virtual int available() override { return _input.length() - _position; }
+
+    virtual int read() override { return available() ? _input[_position++] : -1; }
+
+    virtual int peek() override { return available() ? _input[_position] : -1; }
+
+    virtual int read(uint8_t* buffer, size_t size) override
+    {
+        size = std::min(size, peekAvailable());
+        memcpy(buffer, _input.c_str() + _position, size);
+        _position += size;
+        return size;
+    }
+
+    virtual bool inputCanTimeout() override { return false; } // peer closed
+
+    virtual ssize_t streamRemaining() override { return available(); }
+
+    virtual bool hasPeekBufferAPI() const override { return true; }
+
+    virtual size_t peekAvailable() override
+    {
+        return std::min((size_t)available(), segmentSize - _position % segmentSize);
+    }
+
+    virtual const char* peekBuffer() override { return _input.c_str() + _position; }
+
+    virtual void peekConsume(size_t consume) override { _position += consume; }
+
+protected:
+    const String& _input;
+    size_t _position = 0;
+    size_t _written = 0;
+};
+
+// a file holding the payload, on a mocked SPIFFS created once
+fs::FS& fileSystem()
+{
+    static SPIFFS_MOCK_DECLARE(256, 8, 512, "");
+    static bool ready = false;
+    if (!ready)
+    {
+        SPIFFS.format();
+        SPIFFS.begin();
+        File f = SPIFFS.open("/payload", "w");
+        f.print(payload());
+        ready = true;
+    }
+    return SPIFFS;
+}
+
+void check(size_t transferred)
+{
+    if (transferred != payloadSize)
+        abort();
+}
+
+} // namespace
+
+BENCHMARK("Stream::sendAll StreamString -> StreamString", 2000)
+{
+    StreamString from(payload());
+    StreamString to;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        from.resetPointer();
+        to.clear();
+        check(from.sendAll(to));
+    }
+}
+
+BENCHMARK("Stream::sendAll StreamConstPtr -> client", 2000)
+{
+    StreamConstPtr from(payload());
+    MockClient to;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        from.resetPointer();
+        to.rewind();
+        check(from.sendAll(to));
+    }
+}
+
+BENCHMARK("Stream::sendAll client -> StreamString", 2000)
+{
+    MockClient from(payload());
+    StreamString to;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        from.rewind();
+        to.clear();
+        check(from.sendAll(to));
+    }
+}
+
+BENCHMARK("Stream::sendAll File -> client", 200)
+{
+    fs::FS& fs = fileSystem();
+    MockClient to;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        File from = fs.open("/payload", "r");
+        to.rewind();
+        check(from.sendAll(to));
+    }
+}
+
+// Stream::send*() can't write to SPIFFS files (their availableForWrite() is 0):
+// uploads are written chunk by chunk
+BENCHMARK("Stream::read client -> File (512 B chunks)", 50)
+{
+    fs::FS& fs = fileSystem();
+    MockClient from(payload());
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        File to = fs.open("/upload", "w");
+        from.rewind();
+        size_t transferred = 0;
+        uint8_t buffer[512];
+        int size;
+        while ((size = from.read(buffer, sizeof buffer)) > 0)
+            transferred += to.write(buffer, size);
+        check(transferred);
+    }
+}
+
+BENCHMARK("Stream::read client (byte by byte)", 200)
+{
+    MockClient from(payload());
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        from.rewind();
+        size_t count = 0;
+        while (from.read() >= 0)
+            count++;
+        check(count);
+    }
+}
+
+#pragma GCC diagnostic pop
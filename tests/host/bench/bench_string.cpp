@@ -0,0 +1,106 @@
+/*
+ bench_string.cpp - common String building patterns
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+#include <Arduino.h>
+#include "bench.h"
+
+BENCHMARK("String += char (1 KB)", 5000)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        String s;
+        for (int c = 0; c < 1024; c++)
+            s += 'x';
+        bench::keep(s);
+    }
+}
+
+BENCHMARK("String += char (1 KB, reserved)", 5000)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        String s;
+        s.reserve(1024);
+        for (int c = 0; c < 1024; c++)
+            s += 'x';
+        bench::keep(s);
+    }
+}
+
+BENCHMARK("String += const char* (short)", 200000)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        String s;
+        s += "GET ";
+        s += "/index.html";
+        s += " HTTP/1.1\r\n";
+        bench::keep(s);
+    }
+}
+
+BENCHMARK("String operator+ chain", 200000)
+{
+    const String host = "esp8266.local";
+    const String path = "/api/v1/status";
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        String s = String("http://") + host + ':' + 80 + path + "?id=" + i;
+        bench::keep(s);
+    }
+}
+
+BENCHMARK("String += number", 200000)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        String s;
+        s += i;
+        s += ',';
+        s += (int)-i;
+        s += ',';
+        s += 3.14159f;
+        bench::keep(s);
+    }
+}
+
+BENCHMARK("String JSON-like building (reserved)", 50000)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        String s;
+        s.reserve(128);
+        s += F("{\"heap\":");
+        s += 40000 + (i & 0xff);
+        s += F(",\"uptime\":");
+        s += i;
+        s += F(",\"ssid\":\"");
+        s += F("my network");
+        s += F("\",\"rssi\":");
+        s += -67;
+        s += '}';
+        bench::keep(s);
+    }
+}
+
+BENCHMARK("String copy and compare", 200000)
+{
+    const String original = "Content-Type: text/html; charset=utf-8";
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        String copy = original;
+        if (copy != original || !copy.startsWith("Content-Type") || copy.indexOf("charset") < 0)
+            abort();
+    }
+}
@@ -36,6 +36,9 @@
 
 #include <stdlib.h>
 
+#include <map>
+#include <vector>
+
 unsigned long long operator"" _kHz(unsigned long long x) {
     return x * 1000;
 }
@@ -87,6 +90,25 @@ void EspClass::restart ()
 	exit(EXIT_SUCCESS);
 }
 
+// user RTC memory, kept while the process runs
+static uint32_t mockRtcUserMemory[128];
+
+bool EspClass::rtcUserMemoryRead(uint32_t offset, uint32_t *data, size_t size)
+{
+	if (offset * 4 + size > sizeof(mockRtcUserMemory) || size == 0)
+		return false;
+	memcpy(data, (uint8_t*)mockRtcUserMemory + offset * 4, size);
+	return true;
+}
+
+bool EspClass::rtcUserMemoryWrite(uint32_t offset, uint32_t *data, size_t size)
+{
+	if (offset * 4 + size > sizeof(mockRtcUserMemory) || size == 0)
+		return false;
+	memcpy((uint8_t*)mockRtcUserMemory + offset * 4, data, size);
+	return true;
+}
+
 uint32_t EspClass::getChipId()
 {
 	return 0xee1337;
@@ -142,9 +164,20 @@ void EspClass::getHeapStats(uint32_t* hfree, uint16_t* hmax, uint8_t* hfrag) {
   if (hfrag) *hfrag = 100 - (sqrt(hm) * 100) / hf;
 }
 
+// flash contents, sector by sector: erased sectors read as 0xff
+static std::map<uint32_t, std::vector<uint8_t>> mockFlash;
+
+static uint8_t* mockFlashByte(uint32_t offset)
+{
+	auto& sector = mockFlash[offset / FLASH_SECTOR_SIZE];
+	if (sector.empty())
+		sector.resize(FLASH_SECTOR_SIZE, 0xff);
+	return &sector[offset % FLASH_SECTOR_SIZE];
+}
+
 bool EspClass::flashEraseSector(uint32_t sector)
 {
-	(void) sector;
+	mockFlash.erase(sector);
 	return true;
 }
 
@@ -161,33 +194,25 @@ FlashMode_t EspClass::magicFlashChipMode(uint8_t byte)
 
 bool EspClass::flashWrite(uint32_t offset, const uint32_t *data, size_t size)
 {
-	(void)offset;
-	(void)data;
-	(void)size;
-	return true;
+	return flashWrite(offset, (const uint8_t*)data, size);
 }
 
 bool EspClass::flashWrite(uint32_t offset, const uint8_t *data, size_t size)
 {
-	(void)offset;
-	(void)data;
-	(void)size;
+	while (size--)
+		*mockFlashByte(offset++) = *data++;
 	return true;
 }
 
 bool EspClass::flashRead(uint32_t offset, uint32_t *data, size_t size)
 {
-	(void)offset;
-	(void)data;
-	(void)size;
-	return true;
+	return flashRead(offset, (uint8_t*)data, size);
 }
 
 bool EspClass::flashRead(uint32_t offset, uint8_t *data, size_t size)
 {
-	(void)offset;
-	(void)data;
-	(void)size;
+	while (size--)
+		*data++ = *mockFlashByte(offset++);
 	return true;
 }
 
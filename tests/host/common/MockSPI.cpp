@@ -61,3 +61,31 @@ void SPIClass::setHwCs(bool use)
 {
 	(void)use;
 }
+
+// Queued transactions (SPIQueue.cpp) are transferred in loopback ('in'
+// receives 'out'), by chunks of 64 bytes: one chunk each time busy() is
+// called, as if the SPI interrupt happened.
+
+static uint8_t fifo[64];
+
+void SPIClass::_queueEnable(bool enable)
+{
+	(void)enable;
+}
+
+void SPIClass::_queuePoll()
+{
+	if (_queueHead)
+		_transferred();
+}
+
+void SPIClass::_writeChunk(const uint8_t* out)
+{
+	for (uint8_t i = 0; i < _chunk; i++)
+		fifo[i] = out ? out[i] : 0xff;
+}
+
+void SPIClass::_readChunk(uint8_t* in)
+{
+	memcpy(in, fifo, _chunk);
+}
@@ -234,6 +234,20 @@ public:
 	return ret;
     }
 
+    size_t write(const WiFiClient::iov* v, size_t n, bool borrow)
+    {
+        (void) borrow;
+        size_t written = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            size_t ret = write((const char*)v[i].buf, v[i].len);
+            written += ret;
+            if (ret != v[i].len)
+                break;
+        }
+        return written;
+    }
+
     void keepAlive (uint16_t idle_sec = TCP_DEFAULT_KEEPALIVE_IDLE_SEC, uint16_t intv_sec = TCP_DEFAULT_KEEPALIVE_INTERVAL_SEC, uint8_t count = TCP_DEFAULT_KEEPALIVE_COUNT)
     {
         (void) idle_sec;
@@ -118,6 +118,23 @@ public:
         _on_rx = handler;
     }
 
+    enum class RxPolicy
+    {
+        DropNewest,
+        DropOldest,
+    };
+
+    bool setRxQueue(size_t depth, RxPolicy policy = RxPolicy::DropNewest)
+    {
+        (void)policy;
+        return depth > 0;
+    }
+
+    uint32_t getRxDropped() const
+    {
+        return 0;
+    }
+
     size_t getSize()
     {
         return _inbufsize;
@@ -143,6 +160,18 @@ public:
         return pos <= _inbufsize;
     }
 
+    const pbuf* getRxBuffer()
+    {
+        if (!_inbufsize)
+        {
+            return nullptr;
+        }
+        _inpbuf.next = nullptr;
+        _inpbuf.payload = _inbuf;
+        _inpbuf.len = _inpbuf.tot_len = _inbufsize;
+        return &_inpbuf;
+    }
+
     IPAddress getRemoteAddress()
     {
         return _dst.addr;
@@ -231,6 +260,18 @@ public:
         _outbufsize = 0;
     }
 
+    bool setTxPool(size_t count, size_t size)
+    {
+        (void)count;
+        (void)size;
+        return true;
+    }
+
+    bool sendDatagram(const char* data, size_t size, const ip_addr_t* addr, uint16_t port)
+    {
+        return mockUDPWrite(_sock, (const uint8_t*)data, size, _timeout_ms, addr->addr, port) == size;
+    }
+
     bool send(ip_addr_t* addr = 0, uint16_t port = 0)
     {
         return trySend(addr, port, false) == ERR_OK;
@@ -282,6 +323,7 @@ private:
 
     char _inbuf [CCBUFSIZE];
     size_t _inbufsize = 0;
+    pbuf _inpbuf; // single pbuf view of _inbuf
     char _outbuf [CCBUFSIZE];
     size_t _outbufsize = 0;
 
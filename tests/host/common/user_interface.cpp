@@ -498,10 +498,6 @@ extern "C"
         (void)intr;
     }
 
-    void esp_schedule(void)
-    {
-    }
-
     void dns_setserver(u8_t numdns, ip_addr_t *dnsserver)
     {
         (void)numdns;
@@ -15,6 +15,7 @@
 
 #include <catch.hpp>
 #include <string.h>
+#include <limits.h>
 #include <FS.h>
 #include <LittleFS.h>
 #include "../common/littlefs_mock.h"
@@ -79,3 +80,99 @@ TEST_CASE("Print::write overrides all compile properly", "[core][Print]")
     REQUIRE(buff[13] == 0);
     REQUIRE(buff[14] == 1);
 }
+
+// Keeps what is written, a few bytes at a time when 'window' is set
+class ChunkedPrint: public Print
+{
+public:
+    ChunkedPrint(int window = 0): _window(window) { }
+
+    size_t write(uint8_t c) override
+    {
+        output += (char)c;
+        return 1;
+    }
+
+    size_t write(const uint8_t* buffer, size_t size) override
+    {
+        writes++;
+        output.concat((const char*)buffer, size);
+        return size;
+    }
+
+    int availableForWrite() override { return _window; }
+
+    String output;
+    int writes = 0;
+
+protected:
+    int _window;
+};
+
+// compares with the C library
+#define CHECK_PRINTF(format, ...)                                      \
+    do                                                                 \
+    {                                                                  \
+        char expected[256];                                            \
+        int len = snprintf(expected, sizeof expected, format, ##__VA_ARGS__); \
+        ChunkedPrint p;                                                \
+        CHECK(p.printf(format, ##__VA_ARGS__) == (size_t)len);         \
+        CHECK(p.output == expected);                                   \
+    } while (0)
+
+TEST_CASE("Print::printf formats like the C library", "[core][Print]")
+{
+    CHECK_PRINTF("hello");
+    CHECK_PRINTF("%d %i %u", 0, -12, 42u);
+    CHECK_PRINTF("[%5d] [%-5d] [%05d] [%+d] [% d] [%.3d] [%8.3d]", 42, 42, -42, 42, 42, 7, -7);
+    CHECK_PRINTF("%x %X %#x %#o %o %#.0o %.0d|", 0xbeefu, 0xbeefu, 255u, 8u, 0u, 0u, 0);
+    CHECK_PRINTF("%hhd %hd %ld %lld %llu", 300, 70000, -123456789L, -1234567890123LL, 18446744073709551615ULL);
+    CHECK_PRINTF("%zu %jd %td", (size_t)12345, (intmax_t)-5, (ptrdiff_t)-6);
+    CHECK_PRINTF("%*d|%-*d|%.*d", 6, 1, 6, 2, 4, 3);
+    CHECK_PRINTF("%c%c [%3c] [%-3c]", 'o', 'k', 'x', 'y');
+    CHECK_PRINTF("%s [%10s] [%-10s] [%.2s] [%*.*s]", "str", "right", "left", "truncated", 6, 3, "abcdef");
+    CHECK_PRINTF("%f %.2f %10.3f %-10.1f| %e %g %G %+.0f", 3.14159, -2.5, 1.0 / 3, 8.25, 12345.678, 0.0001, 1e20, 2.5);
+    CHECK_PRINTF("%f", 1e100);
+    CHECK_PRINTF("100%%");
+    CHECK_PRINTF("%d %d %d", INT_MIN, INT_MAX, -1);
+    static int pointee;
+    CHECK_PRINTF("%p [%20p] [%-20p]", (void*)&pointee, (void*)&pointee, (void*)&pointee);
+}
+
+TEST_CASE("Print::printf formats NULL pointers like newlib", "[core][Print]")
+{
+    // glibc prints "(nil)"
+    ChunkedPrint p;
+    CHECK(p.printf("%p [%5p] [%-5p]", nullptr, nullptr, nullptr) == 19);
+    CHECK(p.output == "0x0 [  0x0] [0x0  ]");
+}
+
+TEST_CASE("Print::printf writes long lines in chunks", "[core][Print]")
+{
+    String line;
+    for (int i = 0; i < 1000; i++)
+        line += (char)('a' + i % 26);
+
+    ChunkedPrint p;
+    REQUIRE(p.printf("<%s> %d", line.c_str(), 1234) == line.length() + 7);
+    CHECK(p.output == "<" + line + "> 1234");
+
+    // chunks follow the room told by availableForWrite()
+    ChunkedPrint windowed(20);
+    REQUIRE(windowed.printf("%s", line.c_str()) == line.length());
+    CHECK(windowed.output == line);
+    CHECK(windowed.writes == 50);
+
+    int count = 0;
+    ChunkedPrint counted;
+    counted.printf("%s%n!", line.c_str(), &count);
+    CHECK(count == (int)line.length());
+    CHECK(counted.output == line + "!");
+}
+
+TEST_CASE("Print::printf_P reads the format from flash", "[core][Print]")
+{
+    ChunkedPrint p;
+    REQUIRE(p.printf_P(PSTR("%s=%04X"), "id", 0x2au) == 7);
+    CHECK(p.output == "id=002A");
+}
@@ -0,0 +1,135 @@
+/*
+ test_SPI.cpp - SPI transaction queue tests
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+#include <catch.hpp>
+#include <SPI.h>
+#include <Schedule.h>
+#include <string>
+#include <vector>
+
+TEST_CASE("SPI transactions are transferred and called back in order", "[SPI]")
+{
+    SPIClass spi;
+    std::vector<uint8_t> frame(150);
+    for (size_t i = 0; i < frame.size(); i++)
+        frame[i] = i;
+    uint8_t command[] = { 0x2c, 0x00 };
+    uint8_t reply[4];
+    std::vector<uint8_t> received(frame.size());
+    std::string order;
+
+    pinMode(4, OUTPUT);
+    pinMode(5, OUTPUT);
+    digitalWrite(4, HIGH);
+    digitalWrite(5, HIGH);
+
+    // a command and its data with the same cs, then a read on another device
+    SPITransaction cmd, data, read;
+    cmd.out = command;
+    cmd.size = sizeof(command);
+    cmd.cs = 4;
+    cmd.keepCs = true;
+    data.out = frame.data();
+    data.in = received.data();
+    data.size = frame.size();
+    data.cs = 4;
+    read.in = reply;
+    read.size = sizeof(reply);
+    read.cs = 5;
+
+    REQUIRE(spi.queue(cmd, [&](SPITransaction&) { order += 'c'; }));
+    REQUIRE(spi.queue(data, [&](SPITransaction& txn) { order += 'd'; CHECK(&txn == &data); }));
+    REQUIRE(spi.queue(read, [&](SPITransaction&) { order += 'r'; }));
+    CHECK(digitalRead(4) == LOW);
+
+    CHECK(spi.busy()); // command sent
+    CHECK(digitalRead(4) == LOW);
+    CHECK(cmd.done == false); // until its callback is called
+    CHECK(spi.busy()); // 64 bytes of data
+    CHECK(spi.busy());
+    CHECK(digitalRead(4) == LOW);
+    CHECK(digitalRead(5) == HIGH);
+    CHECK(spi.busy()); // data sent
+    CHECK(digitalRead(4) == HIGH);
+    CHECK(digitalRead(5) == LOW);
+    CHECK(!spi.busy()); // read
+    CHECK(digitalRead(5) == HIGH);
+
+    CHECK(order.empty());
+    run_scheduled_functions();
+    CHECK(order == "cdr");
+    CHECK(cmd.done);
+    CHECK(data.done);
+    CHECK(read.done);
+    CHECK(received == frame);
+    for (uint8_t b : reply)
+        CHECK(b == 0xff);
+}
+
+TEST_CASE("SPI transactions can be queued again from their callback", "[SPI]")
+{
+    SPIClass spi;
+    uint8_t line[100] = { };
+    SPITransaction txn;
+    txn.out = line;
+    txn.size = sizeof(line);
+    int sent = 0;
+
+    std::function<void(SPITransaction&)> next = [&](SPITransaction& t)
+    {
+        if (++sent < 3)
+            REQUIRE(spi.queue(t, next));
+    };
+    REQUIRE(spi.queue(txn, next));
+    spi.wait();
+    CHECK(sent == 1);
+    CHECK(spi.busy());
+    spi.wait();
+    spi.wait();
+    CHECK(sent == 3);
+    CHECK(txn.done);
+    CHECK(!spi.busy());
+
+    SPITransaction empty;
+    CHECK(!spi.queue(empty));
+
+    // spi must outlive the functions scheduled by wait()
+    run_scheduled_functions();
+}
+
+TEST_CASE("SPI callbacks are handed over again when the ring was full", "[SPI]")
+{
+    SPIClass spi;
+    uint8_t byte = 0x55;
+    SPITransaction txn;
+    txn.out = &byte;
+    txn.size = 1;
+    bool called = false;
+
+    int filled = 0;
+    while (schedule_function_isr([]() { }))
+        filled++;
+    CHECK(filled == SCHEDULED_FN_ISR_MAX_COUNT);
+
+    REQUIRE(spi.queue(txn, [&](SPITransaction&) { called = true; }));
+    CHECK(!spi.busy()); // transferred, but the ring is full
+    run_scheduled_functions();
+    CHECK(!called);
+
+    CHECK(!spi.busy()); // scheduled this time
+    run_scheduled_functions();
+    CHECK(called);
+    CHECK(txn.done);
+    get_scheduled_fn_isr_stats(true);
+}
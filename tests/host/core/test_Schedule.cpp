@@ -0,0 +1,217 @@
+/*
+ test_Schedule.cpp - scheduled functions tests
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+#include <catch.hpp>
+#include <Arduino.h>
+#include <Schedule.h>
+#include <vector>
+
+static bool scheduleIsr(std::vector<int>* ran, int id)
+{
+    return schedule_function_isr([ran, id]() { ran->push_back(id); });
+}
+
+TEST_CASE("ISR scheduled functions run in FIFO order", "[core][Schedule]")
+{
+    run_scheduled_functions();
+    get_scheduled_fn_isr_stats(true);
+
+    std::vector<int> ran;
+    // several passes so that the ring indexes wrap around
+    for (int pass = 0; pass < 3; pass++)
+    {
+        ran.clear();
+        for (int i = 0; i < 20; i++)
+            REQUIRE(scheduleIsr(&ran, i));
+        CHECK(ran.empty());
+        run_scheduled_functions();
+        REQUIRE(ran.size() == 20);
+        for (int i = 0; i < 20; i++)
+            CHECK(ran[i] == i);
+    }
+
+    scheduled_fn_isr_stats_t stats = get_scheduled_fn_isr_stats();
+    CHECK(stats.dropped == 0);
+    CHECK(stats.highWater == 20);
+}
+
+TEST_CASE("ISR scheduled functions ring overflow", "[core][Schedule]")
+{
+    run_scheduled_functions();
+    get_scheduled_fn_isr_stats(true);
+
+    std::vector<int> ran;
+    for (int i = 0; i < SCHEDULED_FN_ISR_MAX_COUNT; i++)
+        REQUIRE(scheduleIsr(&ran, i));
+    CHECK_FALSE(scheduleIsr(&ran, -1));
+    CHECK_FALSE(scheduleIsr(&ran, -2));
+
+    scheduled_fn_isr_stats_t stats = get_scheduled_fn_isr_stats(true);
+    CHECK(stats.dropped == 2);
+    CHECK(stats.highWater == SCHEDULED_FN_ISR_MAX_COUNT);
+
+    run_scheduled_functions();
+    REQUIRE(ran.size() == SCHEDULED_FN_ISR_MAX_COUNT);
+    for (int i = 0; i < SCHEDULED_FN_ISR_MAX_COUNT; i++)
+        CHECK(ran[i] == i);
+
+    // slots are free again
+    ran.clear();
+    REQUIRE(scheduleIsr(&ran, 42));
+    run_scheduled_functions();
+    REQUIRE(ran.size() == 1);
+    CHECK(ran[0] == 42);
+    CHECK(get_scheduled_fn_isr_stats().dropped == 0);
+}
+
+TEST_CASE("ISR scheduled functions registered while running", "[core][Schedule]")
+{
+    run_scheduled_functions();
+
+    static std::vector<int> ran;
+    ran.clear();
+    REQUIRE(schedule_function_isr([]()
+    {
+        ran.push_back(1);
+        schedule_function_isr([]() { ran.push_back(2); });
+    }));
+
+    // a function registered during a run waits for the next one
+    run_scheduled_functions();
+    REQUIRE(ran.size() == 1);
+    run_scheduled_functions();
+    REQUIRE(ran.size() == 2);
+    CHECK(ran[1] == 2);
+}
+
+static void waitUs(uint32_t us)
+{
+    uint32_t start = micros();
+    while (micros() - start < us)
+        ;
+}
+
+TEST_CASE("Recurrent functions are called by deadline", "[core][Schedule]")
+{
+    static std::vector<int> ran;
+    ran.clear();
+
+    // registered out of deadline order, run once each
+    REQUIRE(schedule_recurrent_function_us([]() { ran.push_back(3); return false; }, 60000));
+    REQUIRE(schedule_recurrent_function_us([]() { ran.push_back(1); return false; }, 20000));
+    REQUIRE(schedule_recurrent_function_us([]() { ran.push_back(4); return false; }, 60000));
+    REQUIRE(schedule_recurrent_function_us([]() { ran.push_back(2); return false; }, 40000));
+
+    run_scheduled_recurrent_functions();
+    CHECK(ran.empty());
+    waitUs(60000);
+    run_scheduled_recurrent_functions();
+    CHECK((ran == std::vector<int> { 1, 2, 3, 4 }));
+
+    // they were removed
+    waitUs(60000);
+    run_scheduled_recurrent_functions();
+    CHECK(ran.size() == 4);
+}
+
+TEST_CASE("Recurrent functions are removed when they return false", "[core][Schedule]")
+{
+    static int calls[4];
+    for (int& n : calls)
+        n = 0;
+
+    // due at every run, function i is called i + 1 times
+    REQUIRE(schedule_recurrent_function_us([]() { return ++calls[2] < 3; }, 0));
+    REQUIRE(schedule_recurrent_function_us([]() { return ++calls[0] < 1; }, 0));
+    REQUIRE(schedule_recurrent_function_us([]() { return ++calls[3] < 4; }, 0));
+    REQUIRE(schedule_recurrent_function_us([]() { return ++calls[1] < 2; }, 0));
+
+    for (int run = 0; run < 6; run++)
+        run_scheduled_recurrent_functions();
+    for (int i = 0; i < 4; i++)
+        CHECK(calls[i] == i + 1);
+}
+
+TEST_CASE("Recurrent functions with an alarm are called early", "[core][Schedule]")
+{
+    static bool wake = false;
+    static int calls = 0;
+    REQUIRE(schedule_recurrent_function_us([]() { ++calls; return false; }, 10000000, []() { return wake; }));
+
+    run_scheduled_recurrent_functions();
+    run_scheduled_recurrent_functions();
+    CHECK(calls == 0);
+    wake = true;
+    run_scheduled_recurrent_functions();
+    CHECK(calls == 1);
+    run_scheduled_recurrent_functions();
+    CHECK(calls == 1);
+}
+
+TEST_CASE("Recurrent functions report the next deadline", "[core][Schedule]")
+{
+    run_scheduled_recurrent_functions();
+    CHECK(get_scheduled_recurrent_delay_us() == UINT32_MAX);
+
+    static int calls[3];
+    for (int& n : calls)
+        n = 0;
+    uint32_t registering = micros();
+    REQUIRE(schedule_recurrent_function_us([]() { return ++calls[0] < 2; }, 50000));
+    REQUIRE(schedule_recurrent_function_us([]() { ++calls[1]; return false; }, 20000));
+    uint32_t registered = micros();
+    // not sorted yet
+    CHECK(get_scheduled_recurrent_delay_us() == 0);
+    run_scheduled_recurrent_functions();
+
+    // heap top: the 20ms function
+    uint32_t before = micros();
+    uint32_t delay = get_scheduled_recurrent_delay_us();
+    uint32_t after = micros();
+    CHECK(delay <= registered + 20000 - before);
+    CHECK(delay >= registering + 20000 - after);
+
+    waitUs(delay);
+    run_scheduled_recurrent_functions();
+    CHECK(calls[1] == 1);
+    // then the 50ms one
+    before = micros();
+    delay = get_scheduled_recurrent_delay_us();
+    after = micros();
+    CHECK(delay <= registered + 50000 - before);
+    CHECK(delay >= registering + 50000 - after);
+
+    // functions with an alarm count with their own deadline
+    registering = micros();
+    REQUIRE(schedule_recurrent_function_us([]() { ++calls[2]; return false; }, 5000, []() { return false; }));
+    registered = micros();
+    run_scheduled_recurrent_functions();
+    before = micros();
+    delay = get_scheduled_recurrent_delay_us();
+    after = micros();
+    CHECK(delay <= registered + 5000 - before);
+    CHECK(delay >= registering + 5000 - after);
+
+    waitUs(50000);
+    CHECK(get_scheduled_recurrent_delay_us() == 0);
+    run_scheduled_recurrent_functions();
+    CHECK(calls[2] == 1);
+    // the 50ms function was called and runs again
+    CHECK(calls[0] == 1);
+    CHECK(get_scheduled_recurrent_delay_us() > 0);
+    waitUs(50000);
+    run_scheduled_recurrent_functions();
+    CHECK(calls[0] == 2);
+    CHECK(get_scheduled_recurrent_delay_us() == UINT32_MAX);
+}
@@ -15,6 +15,9 @@
 
 #include <catch.hpp>
 #include <Updater.h>
+#include <MD5Builder.h>
+#include <StreamString.h>
+#include <vector>
 
 
 // Use a SPIFFS file because we can't instantiate a virtual class like Print
@@ -54,3 +57,277 @@ TEST_CASE("Updater fails when writes overflow requested size", "[core][Updater]"
     REQUIRE(!u->write(buff, 2048));
     delete u;
 }
+
+namespace
+{
+
+// a sketch image, as found at the start of the flash
+std::vector<uint8_t> sketchImage(size_t size, uint32_t seed)
+{
+    std::vector<uint8_t> image(size);
+    for (size_t i = 0; i < size; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        image[i] = seed >> 16;
+    }
+    image[0] = 0xE9;
+    image[3] = 0x00; // 512KB flash
+    return image;
+}
+
+void appendNumber(std::vector<uint8_t>& patch, uint32_t value)
+{
+    do
+    {
+        patch.push_back((value & 0x7f) | (value > 0x7f ? 0x80 : 0));
+        value >>= 7;
+    } while (value);
+}
+
+void appendInsert(std::vector<uint8_t>& patch, const uint8_t* data, size_t len)
+{
+    patch.push_back(0x02);
+    appendNumber(patch, len);
+    patch.insert(patch.end(), data, data + len);
+}
+
+void appendCopy(std::vector<uint8_t>& patch, int32_t offset, uint32_t len)
+{
+    patch.push_back(0x01);
+    appendNumber(patch, offset >= 0 ? offset << 1 : ((-offset) << 1) - 1);
+    appendNumber(patch, len);
+}
+
+std::vector<uint8_t> deltaHeader(const std::vector<uint8_t>& source, size_t targetSize)
+{
+    std::vector<uint8_t> patch = { UPDATE_DELTA_MAGIC, 'D', 'L', 'T', 1, 0, 0, 0 };
+    for (uint32_t value : { (uint32_t)source.size(), (uint32_t)targetSize })
+        for (int i = 0; i < 4; i++)
+            patch.push_back(value >> (8 * i));
+    MD5Builder md5;
+    md5.begin();
+    md5.add(source.data() + 4, source.size() - 4);
+    md5.calculate();
+    uint8_t sum[16];
+    md5.getBytes(sum);
+    patch.insert(patch.end(), sum, sum + sizeof(sum));
+    return patch;
+}
+
+String md5Of(const std::vector<uint8_t>& data)
+{
+    MD5Builder md5;
+    md5.begin();
+    md5.add(data.data(), data.size());
+    md5.calculate();
+    return md5.toString();
+}
+
+bool writeAll(UpdaterClass& u, std::vector<uint8_t>& data, size_t chunk)
+{
+    for (size_t i = 0; i < data.size(); i += chunk)
+    {
+        size_t len = std::min(chunk, data.size() - i);
+        if (u.write(data.data() + i, len) != len)
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+TEST_CASE("Updater applies delta patches against the running sketch", "[core][Updater]")
+{
+    std::vector<uint8_t> source = sketchImage(20000, 1);
+    REQUIRE(ESP.flashWrite(0, source.data(), source.size()));
+
+    // the new sketch: 50 changed bytes, 300 new ones and a moved block
+    std::vector<uint8_t> target(source.begin(), source.begin() + 10000);
+    std::vector<uint8_t> inserted = sketchImage(350, 2);
+    target.insert(target.end(), inserted.begin() + 50, inserted.end());
+    target.insert(target.end(), source.begin() + 15000, source.end());
+    target.insert(target.end(), source.begin() + 10050, source.begin() + 15000);
+    target[2] = 0x02; // flash mode
+
+    std::vector<uint8_t> patch = deltaHeader(source, target.size());
+    appendInsert(patch, target.data(), 4);
+    appendCopy(patch, 4, 10000 - 4);
+    appendInsert(patch, inserted.data() + 50, 300);
+    appendCopy(patch, 5000, 5000);
+    appendCopy(patch, -(20000 - 10050), 4950);
+    patch.push_back(0x00);
+
+    for (size_t chunk : { (size_t)1, (size_t)7, (size_t)1000, patch.size() })
+    {
+        UpdaterClass u;
+        REQUIRE(u.begin(patch.size()));
+        REQUIRE(u.setMD5(md5Of(target).c_str()));
+        REQUIRE(writeAll(u, patch, chunk));
+        REQUIRE(u.isFinished());
+        CHECK(u.progress() == patch.size());
+        REQUIRE(u.end());
+        CHECK(u.getError() == UPDATE_ERROR_OK);
+    }
+
+    // made for another sketch
+    std::vector<uint8_t> other = sketchImage(20000, 3);
+    std::vector<uint8_t> wrongSource = deltaHeader(other, target.size());
+    wrongSource.insert(wrongSource.end(), patch.begin() + wrongSource.size(), patch.end());
+    {
+        UpdaterClass u;
+        REQUIRE(u.begin(wrongSource.size()));
+        REQUIRE(!writeAll(u, wrongSource, wrongSource.size()));
+        CHECK(u.getError() == UPDATE_ERROR_DELTA);
+    }
+
+    // ends before the new sketch is complete
+    std::vector<uint8_t> truncated(patch.begin(), patch.end() - 10);
+    truncated.push_back(0x00);
+    {
+        UpdaterClass u;
+        REQUIRE(u.begin(truncated.size()));
+        REQUIRE(writeAll(u, truncated, 512));
+        REQUIRE(!u.end());
+        CHECK(u.getError() == UPDATE_ERROR_DELTA);
+    }
+
+    // copies out of the running sketch
+    std::vector<uint8_t> outOfRange = deltaHeader(source, target.size());
+    appendInsert(outOfRange, target.data(), 4);
+    appendCopy(outOfRange, 19000, 2000);
+    outOfRange.push_back(0x00);
+    {
+        UpdaterClass u;
+        REQUIRE(u.begin(outOfRange.size()));
+        REQUIRE(!writeAll(u, outOfRange, outOfRange.size()));
+        CHECK(u.getError() == UPDATE_ERROR_DELTA);
+    }
+}
+
+TEST_CASE("Updater erases ahead and writes by pages when pipelined", "[core][Updater]")
+{
+    std::vector<uint8_t> image = sketchImage(5 * FLASH_SECTOR_SIZE + 1000, 4);
+
+    UpdaterClass u;
+    u.setEraseAhead(2);
+    REQUIRE(u.begin(image.size()));
+    REQUIRE(u.setMD5(md5Of(image).c_str()));
+
+    // while waiting for data
+    CHECK(u.idle());
+    CHECK(u.idle());
+    CHECK(u.idle());
+    CHECK(!u.idle()); // 2 sectors after the current one
+    CHECK(u.getStats().sectorsErasedAhead == 3);
+
+    // complete pages are written as soon as they are received
+    REQUIRE(u.write(image.data(), 1000) == 1000);
+    CHECK(u.progress() == 3 * FLASH_PAGE_SIZE);
+    REQUIRE(u.write(image.data() + 1000, 2 * FLASH_SECTOR_SIZE) == 2 * FLASH_SECTOR_SIZE);
+    CHECK(u.progress() == ((1000 + 2 * FLASH_SECTOR_SIZE) & ~(FLASH_PAGE_SIZE - 1)));
+    CHECK(u.getStats().sectorsErased == 3);
+    CHECK(u.idle());
+    CHECK(u.idle());
+    CHECK(!u.idle());
+
+    REQUIRE(u.write(image.data() + 1000 + 2 * FLASH_SECTOR_SIZE, image.size() - 1000 - 2 * FLASH_SECTOR_SIZE));
+    REQUIRE(u.isFinished());
+    CHECK(!u.idle());
+    REQUIRE(u.end());
+
+    const UpdaterStats& stats = u.getStats();
+    CHECK(stats.bytes == image.size());
+    CHECK(stats.sectorsErased == 6);
+    CHECK(stats.sectorsErasedAhead == 5);
+}
+
+TEST_CASE("Updater::writeStream pipelined", "[core][Updater]")
+{
+    std::vector<uint8_t> image = sketchImage(3 * FLASH_SECTOR_SIZE + 100, 5);
+    StreamString stream;
+    stream.concat((const char*)image.data(), image.size());
+
+    UpdaterClass u;
+    u.setEraseAhead(1);
+    REQUIRE(u.begin(image.size()));
+    REQUIRE(u.setMD5(md5Of(image).c_str()));
+    REQUIRE(u.writeStream(stream) == image.size());
+    REQUIRE(u.end());
+    CHECK(u.getStats().bytes == image.size());
+    CHECK(u.getStats().sectorsErased == 4);
+}
+
+TEST_CASE("Updater resumes an interrupted update", "[core][Updater]")
+{
+    std::vector<uint8_t> image = sketchImage(4 * FLASH_SECTOR_SIZE + 300, 6);
+    String md5 = md5Of(image);
+    UpdaterClass::clearResumable();
+
+    {
+        UpdaterClass u;
+        REQUIRE(u.beginResumable(image.size(), md5.c_str()));
+        CHECK(u.progress() == 0);
+        REQUIRE(u.write(image.data(), 2 * FLASH_SECTOR_SIZE + 1000));
+        // interrupted, the last 1000 bytes are lost
+    }
+
+    String saved;
+    size_t size = 0;
+    CHECK(UpdaterClass::resumableProgress(&saved, &size) == 2 * FLASH_SECTOR_SIZE);
+    CHECK(saved == md5);
+    CHECK(size == image.size());
+    CHECK(UpdaterClass::resumableProgress(nullptr, nullptr, U_FS) == 0);
+
+    SECTION("with the same image")
+    {
+        UpdaterClass u;
+        REQUIRE(u.beginResumable(image.size(), md5.c_str()));
+        REQUIRE(u.progress() == 2 * FLASH_SECTOR_SIZE);
+        StreamString stream;
+        stream.concat((const char*)image.data() + u.progress(), image.size() - u.progress());
+        REQUIRE(u.writeStream(stream) == image.size() - 2 * FLASH_SECTOR_SIZE);
+        REQUIRE(u.end());
+        CHECK(UpdaterClass::resumableProgress() == 0);
+    }
+
+    SECTION("with another image")
+    {
+        std::vector<uint8_t> other = sketchImage(image.size(), 7);
+        UpdaterClass u;
+        REQUIRE(u.beginResumable(other.size(), md5Of(other).c_str()));
+        CHECK(u.progress() == 0);
+        CHECK(UpdaterClass::resumableProgress() == 0);
+        REQUIRE(writeAll(u, other, 1000));
+        REQUIRE(u.end());
+    }
+}
+
+TEST_CASE("Updater resumes an interrupted pipelined update", "[core][Updater]")
+{
+    std::vector<uint8_t> image = sketchImage(4 * FLASH_SECTOR_SIZE + 300, 8);
+    String md5 = md5Of(image);
+    UpdaterClass::clearResumable();
+
+    {
+        UpdaterClass u;
+        u.setEraseAhead(1);
+        REQUIRE(u.beginResumable(image.size(), md5.c_str()));
+        // pages are written as they are received, across sector boundaries
+        for (size_t i = 0; i < 9; i++)
+        {
+            REQUIRE(u.write(image.data() + i * 1000, 1000) == 1000);
+            u.idle();
+        }
+        CHECK(u.progress() == (9000 & ~(FLASH_PAGE_SIZE - 1)));
+    }
+    REQUIRE(UpdaterClass::resumableProgress() == 2 * FLASH_SECTOR_SIZE);
+
+    UpdaterClass u;
+    u.setEraseAhead(1);
+    REQUIRE(u.beginResumable(image.size(), md5.c_str()));
+    REQUIRE(u.progress() == 2 * FLASH_SECTOR_SIZE);
+    size_t from = u.progress();
+    REQUIRE(u.write(image.data() + from, image.size() - from) == image.size() - from);
+    REQUIRE(u.end());
+    CHECK(UpdaterClass::resumableProgress() == 0);
+}
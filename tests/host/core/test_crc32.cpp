@@ -0,0 +1,72 @@
+/*
+ test_crc32.cpp - crc32() and CRC32Builder tests
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+#include <catch.hpp>
+#include <coredecls.h>
+#include <CRC32Builder.h>
+#include <vector>
+
+TEST_CASE("crc32 check value", "[core][crc32]")
+{
+    // CRC-32/MPEG-2
+    REQUIRE(crc32("123456789", 9) == 0x0376e6e7);
+    REQUIRE(crc32_bitwise("123456789", 9, 0xffffffff) == 0x0376e6e7);
+    REQUIRE(crc32("", 0) == 0xffffffff);
+}
+
+TEST_CASE("crc32 variants give the same results", "[core][crc32]")
+{
+    std::vector<uint8_t> data(300);
+    uint32_t x = 1;
+    for (uint8_t& b : data)
+    {
+        x = x * 1103515245 + 12345;
+        b = x >> 16;
+    }
+
+    // every alignment of the start and of the end
+    for (size_t offset = 0; offset < 8; offset++)
+    {
+        for (size_t len = 0; len + offset <= data.size(); len += (len < 40 ? 1 : 37))
+        {
+            const uint8_t* p = data.data() + offset;
+            uint32_t expected = crc32_bitwise(p, len, 0xffffffff);
+            CHECK(crc32_slice1(p, len, 0xffffffff) == expected);
+            CHECK(crc32_slice4(p, len, 0xffffffff) == expected);
+            CHECK(crc32_slice8(p, len, 0xffffffff) == expected);
+            CHECK(crc32(p, len) == expected);
+        }
+    }
+}
+
+TEST_CASE("CRC32Builder adds data in parts", "[core][crc32]")
+{
+    const char* text = "The quick brown fox jumps over the lazy dog, twice: the quick brown fox jumps over the lazy dog";
+    size_t len = strlen(text);
+    uint32_t expected = crc32(text, len);
+
+    for (size_t part : { 1, 3, 4, 7, 16 })
+    {
+        CRC32Builder builder;
+        builder.begin();
+        for (size_t i = 0; i < len; i += part)
+            builder.add(text + i, std::min(part, len - i));
+        CHECK(builder.getCRC() == expected);
+    }
+
+    CRC32Builder builder;
+    builder.begin();
+    builder.add(String(text));
+    CHECK(builder.getCRC() == expected);
+}
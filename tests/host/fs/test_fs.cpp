@@ -16,6 +16,7 @@
 #include <catch.hpp>
 #include <map>
 #include <FS.h>
+#include <StreamString.h>
 #include "../common/spiffs_mock.h"
 #include "../common/littlefs_mock.h"
 #include "../common/sdfs_mock.h"
@@ -0,0 +1,267 @@
+/*
+ test_LEAmDNS.cpp - LEAmDNS received message parsing and answer cache tests
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+#include <catch.hpp>
+#include <ESP8266mDNS.h>
+#include <LwipIntf.h>
+#include <string>
+#include <vector>
+
+// Emulator parts referenced by LEAmDNS, not used by these tests
+extern "C"
+{
+netif netif0;
+bool wifi_get_ip_info(uint8, struct ip_info*) { return false; }
+}
+int mockverbose(const char*, ...) { return 0; }
+uint32_t UdpContext::staticMCastAddr = 0;
+void register_udp(int, UdpContext*) { }
+int mockUDPSocket() { return -1; }
+bool mockUDPListen(int, uint32_t, uint16_t, uint32_t) { return false; }
+size_t mockUDPFillInBuf(int, char*, size_t&, uint8_t&, uint8_t*, uint16_t&) { return 0; }
+size_t mockUDPWrite(int, const uint8_t*, size_t, int, uint32_t, uint16_t) { return 0; }
+bool LwipIntf::stateUpCB(LwipIntf::CBType&&) { return false; }
+
+using namespace std::string_literals;
+
+class TestResponder: public esp8266::MDNSImplementation::MDNSResponder
+{
+public:
+    using MDNSResponder::stcMDNS_MsgHeader;
+    using MDNSResponder::stcMDNS_RRDomain;
+    using MDNSResponder::stcMDNS_RRQuestion;
+    using MDNSResponder::stcMDNS_RRAnswer;
+    using MDNSResponder::stcMDNSService;
+    using MDNSResponder::m_Reader;
+    using MDNSResponder::m_AnswerCache;
+    using MDNSResponder::_readMDNSMsgHeader;
+    using MDNSResponder::_readRRQuestion;
+    using MDNSResponder::_readRRAnswer;
+    using MDNSResponder::_readRRDomain;
+    using MDNSResponder::_releaseService;
+
+    // Received message, as a chain of pbufs of at most chunk bytes
+    void receive(const std::string& message, size_t chunk = 0xffff)
+    {
+        _message = message;
+        _pbufs.assign((message.size() + chunk - 1) / chunk + 1, pbuf());
+        for (size_t i = 0; i * chunk < message.size(); i++)
+        {
+            pbuf& p = _pbufs[i];
+            p.payload = &_message[i * chunk];
+            p.len = std::min(chunk, message.size() - i * chunk);
+            p.tot_len = message.size() - i * chunk;
+            p.next = p.tot_len > p.len? &_pbufs[i + 1]: nullptr;
+        }
+        m_Reader.begin(&_pbufs[0]);
+    }
+
+    // Domain at offset, as "a.b.c", or "(invalid)"
+    std::string domain(uint16_t offset)
+    {
+        stcMDNS_RRDomain d;
+        if (!m_Reader.seek(offset) || !_readRRDomain(d))
+            return "(invalid)";
+        std::string name;
+        for (uint16_t i = 0; d.m_acName[i]; i += d.m_acName[i] + 1)
+            name += (name.empty()? "": ".") + std::string(&d.m_acName[i + 1], d.m_acName[i]);
+        return name;
+    }
+
+private:
+    std::string _message;
+    std::vector<pbuf> _pbufs;
+};
+
+static const std::string header(12, '\0');
+static const std::string exampleLocal = "\x07" "example" "\x05" "local" "\x00"s;  // at offset 12, 15 bytes
+
+TEST_CASE("mDNS reader follows the pbuf chain", "[mDNS]")
+{
+    TestResponder r;
+    // PTR question for host.example.local, compressed
+    std::string message = header + exampleLocal + "\x04" "host" "\xc0\x0c" "\x00\x0c\x00\x01"s;
+    for (size_t chunk = 1; chunk <= message.size(); chunk++)
+    {
+        INFO("pbuf size " << chunk);
+        r.receive(message, chunk);
+        CHECK(r.domain(12) == "example.local");
+        CHECK(r.m_Reader.tell() == 27);
+        CHECK(r.domain(27) == "host.example.local");
+        CHECK(r.m_Reader.tell() == 34); // behind the pointer
+        uint8_t end[4];
+        CHECK(r.m_Reader.read(end, 4));
+        CHECK(r.m_Reader.available() == 0);
+        CHECK_FALSE(r.m_Reader.read(end, 1));
+    }
+}
+
+TEST_CASE("mDNS truncated messages are rejected", "[mDNS]")
+{
+    TestResponder r;
+
+    // header announcing one question, then the question
+    std::string query = "\x00\x00\x00\x00\x00\x01\x00\x00\x00\x00\x00\x00"s + exampleLocal + "\x00\x01\x00\x01"s;
+    for (size_t length = 0; length <= query.size(); length++)
+    {
+        INFO("length " << length);
+        r.receive(query.substr(0, length));
+        TestResponder::stcMDNS_MsgHeader msgHeader;
+        TestResponder::stcMDNS_RRQuestion question;
+        bool parsed = r._readMDNSMsgHeader(msgHeader) && r._readRRQuestion(question);
+        CHECK(parsed == (length == query.size()));
+    }
+
+    // A answer with RDLength beyond the message end
+    std::string answer = header + exampleLocal + "\x00\x01\x00\x01" "\x00\x00\x00\x78"s;
+    for (const std::string& rdata : { "\x00\x04\xc0\xa8\x00"s, "\x00\x05\xc0\xa8\x00\x01"s, "\x00"s })
+    {
+        r.receive(answer + rdata);
+        r.m_Reader.seek(12);
+        TestResponder::stcMDNS_RRAnswer* pAnswer = nullptr;
+        CHECK_FALSE(r._readRRAnswer(pAnswer));
+        delete pAnswer;
+    }
+    r.receive(answer + "\x00\x04\xc0\xa8\x00\x01"s);
+    r.m_Reader.seek(12);
+    TestResponder::stcMDNS_RRAnswer* pAnswer = nullptr;
+    CHECK(r._readRRAnswer(pAnswer));
+    CHECK(r.m_Reader.available() == 0);
+    delete pAnswer;
+
+    // labels and pointers cut by the end of the message
+    r.receive(header + "\x07" "exam"s);
+    CHECK(r.domain(12) == "(invalid)");
+    r.receive(header + exampleLocal + "\xc0"s);
+    CHECK(r.domain(27) == "(invalid)");
+    r.receive(header + "\x07" "example"s);
+    CHECK(r.domain(12) == "(invalid)");
+}
+
+TEST_CASE("mDNS compression pointers must point backwards", "[mDNS]")
+{
+    TestResponder r;
+
+    // forward
+    r.receive(header + "\xc0\x0e" "\x01" "a" "\x00"s);
+    CHECK(r.domain(14) == "a");
+    CHECK(r.domain(12) == "(invalid)");
+
+    // to itself
+    r.receive(header + "\xc0\x0c"s);
+    CHECK(r.domain(12) == "(invalid)");
+
+    // beyond the message
+    r.receive(header + exampleLocal + "\xc0\xff"s);
+    CHECK(r.domain(27) == "(invalid)");
+    r.receive(header + exampleLocal + "\xff\xff"s);
+    CHECK(r.domain(27) == "(invalid)");
+
+    // loop made of backward pointers: "a" then a pointer back to "a"
+    r.receive(header + "\x01" "a" "\xc0\x0c"s);
+    CHECK(r.domain(12) == "(invalid)");
+    r.receive(header + exampleLocal + "\x01" "b" "\xc0\x1b"s);
+    CHECK(r.domain(27) == "(invalid)");
+
+    // chains of pointers, up to the redirection limit
+    std::string message = header + exampleLocal + "\xc0\x0c"; // 27 -> 12
+    for (uint16_t offset = 29; offset < 29 + 2 * 8; offset += 2)
+        message += "\xc0"s + char(offset - 2); // each one to the previous
+    r.receive(message);
+    CHECK(r.domain(27) == "example.local");
+    CHECK(r.domain(29 + 2 * 4) == "example.local"); // 6 redirections
+    CHECK(r.domain(29 + 2 * 5) == "(invalid)");     // 7
+}
+
+TEST_CASE("mDNS oversized labels and names are rejected", "[mDNS]")
+{
+    TestResponder r;
+
+    r.receive(header + "\x3f"s + std::string(63, 'a') + "\x00"s);
+    CHECK(r.domain(12) == std::string(63, 'a'));
+
+    // 0x40 and 0x80 prefixed lengths aren't pointers
+    for (char length : { '\x40', '\x41', '\x80', '\xbf' })
+    {
+        INFO("label length " << (int)(uint8_t)length);
+        r.receive(header + exampleLocal + length + "\x0c"s + std::string(200, 'a') + "\x00"s);
+        CHECK(r.domain(27) == "(invalid)");
+    }
+
+    // more than 255 bytes
+    std::string labels;
+    for (int i = 0; i < 4; i++)
+        labels += "\x3f"s + std::string(63, 'a' + i);
+    r.receive(header + labels + "\x00"s);
+    CHECK(r.domain(12) == "(invalid)");
+    r.receive(header + labels.substr(0, 3 * 64) + "\x3e"s + std::string(62, 'z') + "\x00"s);
+    CHECK(r.domain(12) != "(invalid)");
+    // also when made with a pointer
+    r.receive(header + labels.substr(0, 3 * 64) + "\x00"s + "\x3f"s + std::string(63, 'x') + "\xc0\x0c"s);
+    CHECK(r.domain(12 + 3 * 64 + 1) == "(invalid)");
+}
+
+TEST_CASE("mDNS answer cache is invalidated by host, service and TXT changes", "[mDNS]")
+{
+    TestResponder r;
+    const uint8_t key[] = { 1, 2, 3 };
+    auto build = [&]()
+    {
+        REQUIRE(r.m_AnswerCache.startBuilding(key, sizeof(key)));
+        REQUIRE(r.m_AnswerCache.finishBuilding(true));
+        REQUIRE(r.m_AnswerCache.find(key, sizeof(key)));
+    };
+    auto cached = [&]() { return r.m_AnswerCache.find(key, sizeof(key)) != nullptr; };
+
+    REQUIRE(r.setHostname("esp8266"));
+    build();
+    REQUIRE(r.setHostname("esp8285"));
+    CHECK_FALSE(cached());
+
+    build();
+    auto service = r.addService(nullptr, "http", "tcp", 80);
+    REQUIRE(service);
+    CHECK_FALSE(cached());
+
+    build();
+    CHECK(r.setServiceName(service, "web"));
+    CHECK_FALSE(cached());
+
+    build();
+    auto txt = r.addServiceTxt(service, "path", "/");
+    REQUIRE(txt);
+    CHECK_FALSE(cached());
+
+    build();
+    REQUIRE(r.addServiceTxt(service, "path", "/index.html")); // update
+    CHECK_FALSE(cached());
+
+    // dynamic TXT items are never part of cached answers
+    build();
+    REQUIRE(r.addDynamicServiceTxt(service, "uptime", "1"));
+    CHECK(cached());
+
+    build();
+    CHECK(r.removeServiceTxt(service, "path"));
+    CHECK_FALSE(cached());
+
+    build();
+    CHECK(r._releaseService((TestResponder::stcMDNSService*)service));
+    CHECK_FALSE(cached());
+
+    // a failed build isn't kept
+    REQUIRE(r.m_AnswerCache.startBuilding(key, sizeof(key)));
+    CHECK_FALSE(r.m_AnswerCache.finishBuilding(false));
+    CHECK_FALSE(cached());
+}
@@ -0,0 +1,182 @@
+/*
+ test_EspnowLogTable.cpp - ESP-NOW log hash table tests
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+#include <catch.hpp>
+#include <EspnowLogTable.h>
+#include <algorithm>
+#include <vector>
+
+using Table = EspnowLogTable<uint64_t, int>;
+using Key = Table::key_type;
+using Contents = std::vector<std::pair<Key, int>>;
+
+// keys and values from the oldest to the newest entry
+static Contents contents(Table& table)
+{
+    Contents result;
+    for (auto& entry : table)
+        result.emplace_back(entry.first, entry.second);
+    return result;
+}
+
+TEST_CASE("EspnowLogTable insert and find", "[mesh][EspnowLogTable]")
+{
+    Table table(4);
+    CHECK(table.empty());
+    CHECK(table.begin() == table.end());
+    CHECK(table.find(Key(1, 1)) == table.end());
+
+    auto inserted = table.emplace(Key(1, 1), 10);
+    CHECK(inserted.second);
+    CHECK(inserted.first->second == 10);
+    CHECK(table.insert(std::make_pair(Key(1, 2), 20)).second);
+    CHECK(table.emplace(Key(2, 1), 30).second);
+    CHECK(table.size() == 3);
+
+    // an existing key is kept
+    auto existing = table.emplace(Key(1, 1), 99);
+    CHECK(!existing.second);
+    CHECK(existing.first->second == 10);
+    CHECK(table.size() == 3);
+
+    CHECK(table.count(Key(1, 2)) == 1);
+    CHECK(table.count(Key(2, 2)) == 0);
+    REQUIRE(table.find(Key(2, 1)) != table.end());
+    table.find(Key(2, 1))->second = 31;
+    CHECK((contents(table) == Contents { { Key(1, 1), 10 }, { Key(1, 2), 20 }, { Key(2, 1), 31 } }));
+}
+
+TEST_CASE("EspnowLogTable erase", "[mesh][EspnowLogTable]")
+{
+    Table table(8);
+    for (int i = 0; i < 5; i++)
+        table.emplace(Key(i, i), i);
+
+    CHECK(table.erase(Key(2, 2)) == 1);
+    CHECK(table.erase(Key(2, 2)) == 0);
+    CHECK(table.count(Key(2, 2)) == 0);
+
+    // erasing returns the next entry
+    auto next = table.erase(table.begin());
+    REQUIRE(next != table.end());
+    CHECK(next->second == 1);
+    CHECK((contents(table) == Contents { { Key(1, 1), 1 }, { Key(3, 3), 3 }, { Key(4, 4), 4 } }));
+
+    CHECK(table.eraseIf([](const Table::value_type& entry) { return entry.second != 3; }) == 2);
+    CHECK(table.size() == 1);
+    CHECK(table.find(Key(3, 3)) != table.end());
+
+    // freed entries are reused
+    for (int i = 10; i < 17; i++)
+        CHECK(table.emplace(Key(i, 0), i).second);
+    CHECK(table.size() == 8);
+
+    table.clear();
+    CHECK(table.empty());
+    CHECK(table.find(Key(3, 3)) == table.end());
+    CHECK(table.emplace(Key(3, 3), 3).second);
+    CHECK(table.size() == 1);
+}
+
+TEST_CASE("EspnowLogTable evicts the oldest entry when full", "[mesh][EspnowLogTable]")
+{
+    Table table(3);
+    for (int i = 0; i < 3; i++)
+        table.emplace(Key(0, i), i);
+    CHECK(table.evicted() == 0);
+    table.emplace(Key(0, 3), 3);
+    CHECK(table.size() == 3);
+    CHECK(table.count(Key(0, 0)) == 0);
+    CHECK(contents(table).front().second == 1);
+    CHECK(table.evicted() == 1);
+    // already stored, nothing evicted
+    CHECK_FALSE(table.emplace(Key(0, 3), 3).second);
+    CHECK(table.evicted() == 1);
+
+    // shrinking keeps the newest entries
+    table.setCapacity(2);
+    CHECK(table.capacity() == 2);
+    CHECK((contents(table) == Contents { { Key(0, 2), 2 }, { Key(0, 3), 3 } }));
+    CHECK(table.evicted() == 2);
+
+    table.setCapacity(0);
+    CHECK(table.capacity() == 1);
+    CHECK((contents(table) == Contents { { Key(0, 3), 3 } }));
+    table.setCapacity(60000);
+    CHECK(table.capacity() == Table::maxCapacity);
+    CHECK(table.size() == 1);
+    CHECK(table.evicted() == 3);
+
+    // not reset with the storage
+    table.clear();
+    CHECK(table.evicted() == 3);
+}
+
+TEST_CASE("EspnowLogTable eraseExpired stops at the first recent entry", "[mesh][EspnowLogTable]")
+{
+    Table table(8);
+    // the value is the age
+    for (int age : { 50, 40, 30, 20, 10 })
+        table.emplace(Key(age, 0), age);
+
+    int visited = 0;
+    auto age = [&visited](const Table::value_type& entry) { ++visited; return (uint32_t)entry.second; };
+    table.eraseExpired(age, 25, [](const Table::value_type& entry) { return entry.first.first == 40 ? 100u : 25u; });
+    CHECK((contents(table) == Contents { { Key(40, 0), 40 }, { Key(20, 0), 20 }, { Key(10, 0), 10 } }));
+    CHECK(visited == 4); // 20 was the last one
+
+    table.eraseExpired(age, 15);
+    CHECK((contents(table) == Contents { { Key(10, 0), 10 } }));
+}
+
+TEST_CASE("EspnowLogTable probing wraps around the buckets", "[mesh][EspnowLogTable]")
+{
+    // a small table, checked against a plain list after random operations:
+    // collisions, probe sequences wrapping around the end of the buckets and
+    // backward shift deletion are all exercised
+    Table table(5);
+    Contents reference;
+    uint32_t x = 1;
+
+    for (int i = 0; i < 5000; i++)
+    {
+        x = x * 1103515245 + 12345;
+        Key key((x >> 16) % 3, (x >> 20) % 7);
+        auto found = std::find_if(reference.begin(), reference.end(), [&key](const std::pair<Key, int>& entry) { return entry.first == key; });
+
+        if ((x >> 8) & 1)
+        {
+            bool inserted = table.emplace(key, i).second;
+            REQUIRE(inserted == (found == reference.end()));
+            if (inserted)
+            {
+                if (reference.size() == 5)
+                    reference.erase(reference.begin());
+                reference.emplace_back(key, i);
+            }
+        }
+        else
+        {
+            REQUIRE(table.erase(key) == (found != reference.end() ? 1 : 0));
+            if (found != reference.end())
+                reference.erase(found);
+        }
+
+        bool same = table.size() == reference.size();
+        for (const auto& entry : reference)
+            same = same && table.count(entry.first) == 1;
+        REQUIRE(same);
+    }
+    CHECK(contents(table) == reference);
+}
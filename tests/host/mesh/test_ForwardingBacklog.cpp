@@ -0,0 +1,196 @@
+/*
+ test_ForwardingBacklog.cpp - FloodingMesh forwarding backlog and message ID log tests
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+#include <catch.hpp>
+#include <ForwardingBacklog.h>
+#include <MessageIdLog.h>
+#include <deque>
+
+static String message(char c, uint32_t length)
+{
+    String result;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        char b = i % 5 ? c : 0; // includes null bytes
+        result.concat(&b, 1);
+    }
+    return result;
+}
+
+static bool popped(ForwardingBacklog& backlog, const String& expected, bool expectedEncrypted)
+{
+    String text;
+    bool encrypted = !expectedEncrypted;
+    return backlog.pop(text, encrypted) && text == expected && encrypted == expectedEncrypted;
+}
+
+TEST_CASE("ForwardingBacklog is a FIFO", "[mesh][ForwardingBacklog]")
+{
+    ForwardingBacklog backlog(100);
+    String text = "unchanged";
+    bool encrypted = false;
+    CHECK(backlog.empty());
+    CHECK(!backlog.pop(text, encrypted));
+    CHECK(text == "unchanged");
+
+    REQUIRE(backlog.push(message('a', 10), true));
+    REQUIRE(backlog.push(emptyString, false));
+    CHECK(!backlog.push(message('b', 98), false)); // record larger than the buffer
+    REQUIRE(backlog.push(message('c', 1), false));
+    CHECK(backlog.size() == 3);
+    CHECK(backlog.droppedMessages() == 1);
+
+    CHECK(popped(backlog, message('a', 10), true));
+    CHECK(popped(backlog, emptyString, false));
+    CHECK(popped(backlog, message('c', 1), false));
+    CHECK(backlog.empty());
+
+    // records are 3 bytes of header and the message
+    REQUIRE(backlog.push(message('d', 97), false));
+    CHECK(!backlog.push(emptyString, false));
+    CHECK(backlog.droppedMessages() == 2);
+    CHECK(popped(backlog, message('d', 97), false));
+
+    backlog.push(message('e', 5), true);
+    backlog.setCapacity(50);
+    CHECK(backlog.empty());
+    CHECK(backlog.capacity() == 50);
+    CHECK(!backlog.push(message('f', 48), false));
+    CHECK(backlog.push(message('f', 47), false));
+}
+
+TEST_CASE("ForwardingBacklog wraps whole records", "[mesh][ForwardingBacklog]")
+{
+    // 13 bytes records in 32 bytes
+    ForwardingBacklog backlog(32);
+    REQUIRE(backlog.push(message('a', 10), false));
+    REQUIRE(backlog.push(message('b', 10), true));
+    CHECK(!backlog.push(message('c', 10), false)); // 6 bytes left at the end, none at the start
+    CHECK(backlog.droppedMessages() == 1);
+
+    CHECK(popped(backlog, message('a', 10), false));
+    // the header would fit at the end, not the record: it is written at the start
+    REQUIRE(backlog.push(message('c', 10), false));
+    CHECK(!backlog.push(emptyString, true)); // full up to the oldest record
+    CHECK(backlog.droppedMessages() == 2);
+    CHECK(backlog.size() == 2);
+
+    CHECK(popped(backlog, message('b', 10), true));
+    REQUIRE(backlog.push(message('d', 10), true)); // after 'c', not wrapped anymore
+    REQUIRE(backlog.push(message('e', 3), false)); // up to the end of the buffer
+    CHECK(popped(backlog, message('c', 10), false));
+    CHECK(popped(backlog, message('d', 10), true));
+    CHECK(popped(backlog, message('e', 3), false));
+    CHECK(backlog.empty());
+    CHECK(backlog.droppedMessages() == 2);
+}
+
+TEST_CASE("ForwardingBacklog keeps messages in order under load", "[mesh][ForwardingBacklog]")
+{
+    ForwardingBacklog backlog(200);
+    std::deque<std::pair<String, bool>> reference;
+    uint32_t x = 1, pushed = 0, dropped = 0;
+
+    for (int i = 0; i < 5000; i++)
+    {
+        x = x * 1103515245 + 12345;
+        if ((x >> 16) % 3)
+        {
+            String text = message('a' + i % 26, (x >> 8) % 60);
+            bool encrypted = x & 1;
+            ++pushed;
+            if (backlog.push(text, encrypted))
+                reference.emplace_back(text, encrypted);
+            else
+                ++dropped;
+        }
+        else if (!reference.empty())
+        {
+            REQUIRE(popped(backlog, reference.front().first, reference.front().second));
+            reference.pop_front();
+        }
+        REQUIRE(backlog.size() == reference.size());
+    }
+
+    CHECK(dropped > 0);
+    CHECK(backlog.droppedMessages() == dropped);
+    CHECK(pushed > dropped);
+    while (!reference.empty())
+    {
+        REQUIRE(popped(backlog, reference.front().first, reference.front().second));
+        reference.pop_front();
+    }
+    CHECK(backlog.empty());
+}
+
+TEST_CASE("MessageIdLog evicts the oldest ID", "[mesh][MessageIdLog]")
+{
+    MessageIdLog log(3);
+    CHECK(log.find(1) == nullptr);
+
+    for (uint64_t id = 1; id <= 3; id++)
+        REQUIRE(*log.insert(id << 16, id) == id);
+    CHECK(log.size() == 3);
+    for (uint64_t id = 1; id <= 3; id++)
+    {
+        REQUIRE(log.find(id << 16) != nullptr);
+        CHECK(*log.find(id << 16) == id);
+    }
+
+    // states can be updated in place
+    *log.find(2 << 16) = 20;
+    CHECK(*log.find(2 << 16) == 20);
+
+    log.insert(4 << 16, 4);
+    CHECK(log.size() == 3);
+    CHECK(log.find(1 << 16) == nullptr);
+    CHECK(*log.find(2 << 16) == 20);
+    CHECK(*log.find(4 << 16) == 4);
+
+    log.setCapacity(2);
+    CHECK(log.size() == 0);
+    CHECK(log.find(4 << 16) == nullptr);
+    log.insert(5, 5);
+    CHECK(*log.find(5) == 5);
+    log.clear();
+    CHECK(log.find(5) == nullptr);
+}
+
+TEST_CASE("MessageIdLog remembers the last IDs", "[mesh][MessageIdLog]")
+{
+    // message IDs are a MAC and a counter
+    MessageIdLog log(50);
+    std::deque<uint64_t> reference;
+    uint32_t x = 1;
+
+    for (int i = 0; i < 5000; i++)
+    {
+        x = x * 1103515245 + 12345;
+        uint64_t id = (0x5ecf7f000000ULL | (x >> 16) % 8) << 16 | (x >> 8) % 64;
+        bool known = false;
+        for (uint64_t stored : reference)
+            known = known || stored == id;
+
+        uint8_t* state = log.find(id);
+        REQUIRE((state != nullptr) == known);
+        if (!known)
+        {
+            REQUIRE(*log.insert(id, i & 0xff) == (i & 0xff));
+            if (reference.size() == 50)
+                reference.pop_front();
+            reference.push_back(id);
+        }
+        REQUIRE(log.size() == reference.size());
+    }
+}
@@ -0,0 +1,194 @@
+/*
+ test_TlvTranslator.cpp - TLV metadata encoding tests
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+#include <catch.hpp>
+#include <TlvTranslator.h>
+#include <FloodingMeshMetadata.h>
+#include <vector>
+
+static String bytes(std::initializer_list<uint8_t> list)
+{
+    String result;
+    for (uint8_t b : list)
+        result.concat((const char*)&b, 1);
+    return result;
+}
+
+TEST_CASE("TLV records round trip", "[mesh][TlvTranslator]")
+{
+    std::vector<uint16_t> lengths = { 0, 1, 127, 128, 300, TlvTranslator::maxValueLength };
+    std::vector<String> values;
+    for (uint16_t length : lengths)
+    {
+        String value;
+        for (uint16_t i = 0; i < length; i++)
+        {
+            char c = i * 7; // includes null bytes
+            value.concat(&c, 1);
+        }
+        values.push_back(value);
+    }
+
+    String tlv;
+    tlv += TlvTranslator::tlvMarker;
+    uint32_t expectedLength = 1;
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        REQUIRE(TlvTranslator::appendRecord(tlv, 10 + i, values[i]));
+        expectedLength += TlvTranslator::recordLength(lengths[i]);
+        CHECK(tlv.length() == expectedLength);
+    }
+    REQUIRE(TlvTranslator::appendRecord(tlv, 2, (uint64_t)0x0102030405060708ULL));
+    tlv += TlvTranslator::endOfRecords;
+    const uint32_t bodyIndex = tlv.length();
+    tlv += "body";
+
+    REQUIRE(TlvTranslator::isTlv(tlv));
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        uint16_t valueLength = 0xffff;
+        int32_t valueIndex = TlvTranslator::getValueIndex(tlv, 10 + i, valueLength);
+        REQUIRE(valueIndex > 0);
+        CHECK(valueLength == lengths[i]);
+
+        String value = "unchanged";
+        REQUIRE(TlvTranslator::decode(tlv, 10 + i, value));
+        CHECK(value.length() == lengths[i]);
+        CHECK(value == values[i]);
+    }
+
+    uint64_t number = 0;
+    REQUIRE(TlvTranslator::decode(tlv, 2, number));
+    CHECK(number == 0x0102030405060708ULL);
+    CHECK(TlvTranslator::getEndIndex(tlv) == (int32_t)bodyIndex);
+
+    // not found
+    String value = "unchanged";
+    uint16_t valueLength = 0;
+    CHECK(TlvTranslator::getValueIndex(tlv, 3, valueLength) < 0);
+    CHECK(!TlvTranslator::decode(tlv, 3, value));
+    CHECK(value == "unchanged");
+}
+
+TEST_CASE("TLV decoding stops at endOfRecords", "[mesh][TlvTranslator]")
+{
+    // a record type found in the body is not a record
+    String tlv = bytes({ (uint8_t)TlvTranslator::tlvMarker, 5, 1, 'a', 0, 6, 1, 'b' });
+    String value;
+    CHECK(TlvTranslator::decode(tlv, 5, value));
+    CHECK(value == "a");
+    CHECK(!TlvTranslator::decode(tlv, 6, value));
+    CHECK(TlvTranslator::getEndIndex(tlv) == 5);
+
+    CHECK(!TlvTranslator::isTlv(emptyString));
+    CHECK(!TlvTranslator::isTlv("text"));
+    CHECK(TlvTranslator::getEndIndex("text") < 0);
+}
+
+TEST_CASE("TLV truncated records are rejected", "[mesh][TlvTranslator]")
+{
+    const uint8_t marker = TlvTranslator::tlvMarker;
+    uint16_t valueLength = 0;
+    String value;
+    uint64_t number = 0;
+
+    // value shorter than its length
+    String tlv = bytes({ marker, 5, 4, 'a', 'b', 'c' });
+    CHECK(TlvTranslator::getValueIndex(tlv, 5, valueLength) < 0);
+    CHECK(!TlvTranslator::decode(tlv, 5, value));
+    CHECK(TlvTranslator::getEndIndex(tlv) < 0);
+
+    // length byte missing
+    tlv = bytes({ marker, 5 });
+    CHECK(TlvTranslator::getValueIndex(tlv, 5, valueLength) < 0);
+    CHECK(TlvTranslator::getEndIndex(tlv) < 0);
+
+    // second length byte missing
+    tlv = bytes({ marker, 5, 0x81 });
+    CHECK(TlvTranslator::getValueIndex(tlv, 5, valueLength) < 0);
+    CHECK(TlvTranslator::getEndIndex(tlv) < 0);
+
+    // two bytes length (0x100) running past the buffer
+    tlv = bytes({ marker, 5, 0x81, 0x00, 'a', 'b', 0, 'c' });
+    CHECK(TlvTranslator::getValueIndex(tlv, 5, valueLength) < 0);
+    CHECK(TlvTranslator::getEndIndex(tlv) < 0);
+
+    // a truncated record hides the following ones
+    tlv = bytes({ marker, 5, 1, 'a', 2, 9, 1, 2, 3, 0 });
+    CHECK(TlvTranslator::decode(tlv, 5, value));
+    CHECK(!TlvTranslator::decode(tlv, 2, number));
+    CHECK(TlvTranslator::getEndIndex(tlv) < 0);
+
+    // numbers are 1 to 8 bytes
+    tlv = bytes({ marker, 2, 0, 3, 9, 1, 2, 3, 4, 5, 6, 7, 8, 9, 0 });
+    number = 42;
+    CHECK(!TlvTranslator::decode(tlv, 2, number));
+    CHECK(!TlvTranslator::decode(tlv, 3, number));
+    CHECK(number == 42);
+}
+
+TEST_CASE("TLV without endOfRecords", "[mesh][TlvTranslator]")
+{
+    const uint8_t marker = TlvTranslator::tlvMarker;
+    String tlv = bytes({ marker, 5, 1, 'a', 2, 1, 7 });
+    String value;
+    uint64_t number = 0;
+
+    // records before the end are readable, but there is no body
+    CHECK(TlvTranslator::decode(tlv, 5, value));
+    CHECK(TlvTranslator::decode(tlv, 2, number));
+    CHECK(number == 7);
+    CHECK(!TlvTranslator::decode(tlv, 3, value));
+    CHECK(TlvTranslator::getEndIndex(tlv) < 0);
+
+    CHECK(TlvTranslator::getEndIndex(bytes({ marker })) < 0);
+    CHECK(TlvTranslator::getEndIndex(bytes({ marker, 0 })) == 2);
+}
+
+TEST_CASE("FloodingMesh binary metadata", "[mesh][TlvTranslator]")
+{
+    const String meshName = "MeshNode_";
+    const uint64_t messageID = 0x5ecf7f1234560042ULL;
+    String message;
+    message.concat("body\0with null", 14);
+
+    String broadcast = FloodingMeshMetadata::createBinaryMessage(&meshName, messageID, message);
+    CHECK(broadcast.length() == FloodingMeshMetadata::binaryMetadataLength(&meshName) + message.length());
+
+    uint64_t decoded = 0;
+    CHECK(FloodingMeshMetadata::acceptBinaryBroadcast(broadcast, meshName, decoded));
+    CHECK(decoded == messageID);
+    CHECK(!FloodingMeshMetadata::acceptBinaryBroadcast(broadcast, "MeshNode", decoded));
+    CHECK(!FloodingMeshMetadata::acceptBinaryBroadcast(broadcast, "OtherMesh", decoded));
+
+    decoded = 0;
+    int32_t bodyIndex = FloodingMeshMetadata::getBinaryMessageIndex(broadcast, decoded);
+    REQUIRE(bodyIndex == (int32_t)FloodingMeshMetadata::binaryMetadataLength(&meshName));
+    CHECK(decoded == messageID);
+    CHECK(memcmp(broadcast.c_str() + bodyIndex, message.c_str(), message.length()) == 0);
+
+    // to all mesh networks
+    String anyMesh = FloodingMeshMetadata::createBinaryMessage(&emptyString, messageID, message);
+    CHECK(FloodingMeshMetadata::acceptBinaryBroadcast(anyMesh, meshName, decoded));
+
+    // encrypted broadcasts have no target mesh name
+    String encrypted = FloodingMeshMetadata::createBinaryMessage(nullptr, messageID, message);
+    CHECK(!FloodingMeshMetadata::acceptBinaryBroadcast(encrypted, meshName, decoded));
+    CHECK(FloodingMeshMetadata::getBinaryMessageIndex(encrypted, decoded) == (int32_t)FloodingMeshMetadata::binaryMetadataLength(nullptr));
+
+    // truncated metadata
+    broadcast.remove(FloodingMeshMetadata::binaryMetadataLength(&meshName) - 3);
+    CHECK(!FloodingMeshMetadata::acceptBinaryBroadcast(broadcast, meshName, decoded));
+    CHECK(FloodingMeshMetadata::getBinaryMessageIndex(broadcast, decoded) < 0);
+}
@@ -57,6 +57,7 @@
 inline const char *strstr_P(const char *haystack, const char *needle) { return strstr(haystack, needle); }
 inline char *strcpy_P(char *dest, const char *src) { return strcpy(dest, src); }
 inline size_t strlen_P(const char *s) { return strlen(s); }
+inline size_t strnlen_P(const char *s, size_t size) { return strnlen(s, size); }
 inline int vsnprintf_P(char *str, size_t size, const char *format, va_list ap) { return vsnprintf(str, size, format, ap); }
 
 #define memcpy_P memcpy
@@ -67,6 +68,7 @@ inline int vsnprintf_P(char *str, size_t size, const char *format, va_list ap) {
 #define snprintf_P snprintf
 #define sprintf_P sprintf
 #define strncmp_P strncmp
+#define strncasecmp_P strncasecmp
 #define strcat_P strcat
 
 #endif
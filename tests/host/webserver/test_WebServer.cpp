@@ -0,0 +1,199 @@
+/*
+ test_WebServer.cpp - ESP8266WebServer request head tests
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+#include <catch.hpp>
+#include <ESP8266WebServer.h>
+#include <memory>
+#include <string>
+
+// In-memory connection: the request is read from input, the response is
+// written to output.  Copies share the connection, as WiFiClient copies do.
+class FakeClient: public Stream
+{
+public:
+    struct Connection
+    {
+        std::string input;
+        size_t pos = 0;
+        std::string output;
+        bool peekApi = true;
+        bool connected = true;
+    };
+
+    FakeClient(): _c(nullptr) { }
+    FakeClient(const std::string& input, bool peekApi = true): _c(std::make_shared<Connection>())
+    {
+        _c->input = input;
+        _c->peekApi = peekApi;
+    }
+
+    operator bool() const { return _c != nullptr; }
+    const std::string& output() const { return _c->output; }
+
+    uint8_t connected() { return _c && _c->connected; }
+    void stop() { if (_c) _c->connected = false; }
+    void flush() override { }
+
+    int available() override { return _c? _c->input.size() - _c->pos: 0; }
+    int read() override { return available()? (uint8_t)_c->input[_c->pos++]: -1; }
+    int peek() override { return available()? (uint8_t)_c->input[_c->pos]: -1; }
+
+    bool hasPeekBufferAPI() const override { return _c && _c->peekApi; }
+    size_t peekAvailable() override { return available(); }
+    const char* peekBuffer() override { return _c->input.data() + _c->pos; }
+    void peekConsume(size_t consume) override { _c->pos += consume; }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t size) override
+    {
+        if (!_c || !_c->connected)
+            return 0;
+        _c->output.append((const char*)buf, size);
+        return size;
+    }
+    int availableForWrite() override { return 1460; }
+
+protected:
+    std::shared_ptr<Connection> _c;
+};
+
+class FakeServer
+{
+public:
+    using ClientType = FakeClient;
+
+    FakeServer(int port) { (void)port; }
+    FakeServer(IPAddress addr, int port) { (void)addr; (void)port; }
+    void begin() { }
+    void close() { }
+    bool hasClient() { return false; }
+    ClientType available() { return ClientType(); }
+};
+
+class TestServer: public esp8266webserver::ESP8266WebServerTemplate<FakeServer>
+{
+public:
+    using ESP8266WebServerTemplate::ClientSlot;
+    using ESP8266WebServerTemplate::_slots;
+    using ESP8266WebServerTemplate::_readHead;
+    using ESP8266WebServerTemplate::_dropSlot;
+
+    // Collects and parses the request head sent by client, as handleClient()
+    ClientFuture request(FakeClient& client)
+    {
+        ClientSlot& slot = _slots[0];
+        slot.client = client;
+        slot.status = HC_WAIT_READ;
+        if (!_readHead(slot) || slot.headEol != 4)
+            return CLIENT_IS_GIVEN; // not expected by the tests
+        _currentClient = client;
+        ClientFuture whatNow = _parseRequest(_currentClient, slot.head);
+        if (whatNow == CLIENT_REQUEST_CAN_CONTINUE)
+        {
+            _contentLength = CONTENT_LENGTH_NOT_SET;
+            _handleRequest();
+        }
+        _currentClient = FakeClient();
+        _resetHead(slot);
+        return whatNow;
+    }
+};
+
+// short strings are kept in the String object itself, without heap
+static bool inPlace(const String& s)
+{
+    const char* buffer = s.c_str();
+    return buffer >= (const char*)&s && buffer < (const char*)(&s + 1);
+}
+
+static bool startsWith(const std::string& s, const char* prefix)
+{
+    return s.compare(0, strlen(prefix), prefix) == 0;
+}
+
+TEST_CASE("Request heads are parsed in place", "[WebServer]")
+{
+    TestServer server;
+    String host;
+    server.on("/path", HTTP_GET, [&]()
+    {
+        host = server.hostHeader();
+        server.send(200, "text/plain", server.arg("a"));
+    });
+
+    for (bool peekApi : { true, false })
+    {
+        FakeClient client("GET /path?a=value HTTP/1.1\r\nHost: esp8266\r\n\r\n", peekApi);
+        CHECK(server.request(client) == TestServer::CLIENT_REQUEST_CAN_CONTINUE);
+        CHECK(startsWith(client.output(), "HTTP/1.1 200 OK\r\n"));
+        CHECK(client.output().find("\r\n\r\nvalue") != std::string::npos);
+        CHECK(host == "esp8266");
+    }
+}
+
+TEST_CASE("Request heads with a NUL byte are rejected", "[WebServer]")
+{
+    using namespace std::string_literals;
+    TestServer server;
+    bool called = false;
+    server.on("/path", [&]() { called = true; server.send(200); });
+
+    for (bool peekApi : { true, false })
+    {
+        // in the request line, and in a header
+        for (const std::string& request :
+            {
+                "GET /pa\0th HTTP/1.1\r\nHost: esp8266\r\n\r\n"s,
+                "GET /path HTTP/1.1\0\r\nHost: esp8266\r\n\r\n"s,
+                "GET /path HTTP/1.1\r\nHost: esp\0" "8266\r\n\r\n"s,
+                "GET /path HTTP/1.1\r\nHost: esp8266\0\r\nAccept: */*\r\n\r\n"s,
+            })
+        {
+            FakeClient client(request, peekApi);
+            CHECK(server.request(client) == TestServer::CLIENT_MUST_STOP);
+            CHECK(startsWith(client.output(), "HTTP/1.0 400 Bad Request\r\n"));
+            CHECK(client.output().find("Connection: close\r\n") != std::string::npos);
+        }
+    }
+    CHECK_FALSE(called);
+}
+
+TEST_CASE("Malformed request lines are rejected", "[WebServer]")
+{
+    TestServer server;
+    for (const char* request : { "GET\r\n\r\n", "GET /path\r\n\r\n", "\r\n\r\n" })
+    {
+        FakeClient client(request);
+        CHECK(server.request(client) == TestServer::CLIENT_MUST_STOP);
+        CHECK(startsWith(client.output(), "HTTP/1.0 400 Bad Request\r\n"));
+    }
+}
+
+TEST_CASE("Request head buffers are freed with their client", "[WebServer]")
+{
+    TestServer server;
+    server.on("/path", [&]() { server.send(200); });
+
+    std::string request = "GET /path HTTP/1.1\r\nHost: esp8266\r\n";
+    request += "Cookie: " + std::string(1000, 'c') + "\r\n\r\n";
+    FakeClient client(request);
+    CHECK(server.request(client) == TestServer::CLIENT_REQUEST_CAN_CONTINUE);
+    TestServer::ClientSlot& slot = server._slots[0];
+    // kept for the next request on this connection
+    CHECK(slot.head.length() == 0);
+    CHECK_FALSE(inPlace(slot.head));
+
+    server._dropSlot(slot);
+    CHECK(inPlace(slot.head));
+}
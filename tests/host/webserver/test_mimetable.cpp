@@ -0,0 +1,74 @@
+/*
+ test_mimetable.cpp - ESP8266WebServer content type lookup tests
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+#include <catch.hpp>
+#include <detail/mimetable.h>
+
+using namespace mime;
+
+static const String defaultType = FPSTR(mimeTable[none].mimeType);
+
+TEST_CASE("Every table extension is found", "[mimetable]")
+{
+    for (int t = 0; t < none; t++)
+    {
+        String ext = FPSTR(mimeTable[t].endsWith);
+        String type = FPSTR(mimeTable[t].mimeType);
+        INFO("extension " << ext.c_str());
+        CHECK(getContentType(String("file") + ext) == type);
+        CHECK(getContentType(String("/dir.d/file.old") + ext) == type);
+        CHECK(getContentType(ext) == type);
+        CHECK(strcmp_P(type.c_str(), getContentType_P(("/x" + ext).c_str())) == 0);
+    }
+    CHECK(getContentType("/index.html") == "text/html");
+    CHECK(getContentType("/app.js.gz") == "application/x-gzip");
+}
+
+TEST_CASE("Unknown extensions get the default type", "[mimetable]")
+{
+    CHECK(defaultType == "application/octet-stream");
+    for (const char* path :
+        {
+            "", "/", "file", "/dir/file", "/dir.html/file", "file.",
+            ".a", ".zzzz", ".h", ".htmlx", ".jso", ".woff3",
+            "file.HTML", "file.Txt", "FILE.PNG", // case sensitive
+        })
+    {
+        INFO("path " << path);
+        CHECK(getContentType(path) == defaultType);
+    }
+}
+
+TEST_CASE("Registered types are found before the builtin ones", "[mimetable]")
+{
+    CHECK_FALSE(registerType("wasm", "application/wasm"));
+    CHECK_FALSE(registerType(".", "application/wasm"));
+    CHECK_FALSE(registerType(".tar.gz", "application/gzip"));
+    CHECK_FALSE(registerType(".a/b", "application/wasm"));
+
+    CHECK(registerType(".wasm", "application/wasm"));
+    CHECK(registerType(".mjs", "text/javascript"));
+    CHECK(getContentType("/main.wasm") == "application/wasm");
+    CHECK(getContentType("/main.mjs") == "text/javascript");
+    CHECK(getContentType("/main.WASM") == defaultType);
+    CHECK(getContentType("/main.js") == "application/javascript");
+
+    // overriding, then restoring a builtin type
+    CHECK(registerType(".mjs", "application/javascript"));
+    CHECK(getContentType("/main.mjs") == "application/javascript");
+    CHECK(registerType(".json", "application/json; charset=utf-8"));
+    CHECK(getContentType("/data.json") == "application/json; charset=utf-8");
+    CHECK(registerType(".json", mimeTable[json].mimeType));
+    CHECK(getContentType("/data.json") == "application/json");
+}
@@ -0,0 +1,284 @@
+/*
+ lwip_fake.cpp - minimal in-memory lwIP, to test the real UdpContext and ClientContext
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+#include "lwip_fake.h"
+
+#include <cstdlib>
+
+namespace lwip_fake
+{
+
+std::vector<Sent> sent;
+bool holdSent = false;
+size_t pbufAllocs = 0;
+size_t pbufsLive = 0;
+size_t pbufAllocsLeft = SIZE_MAX;
+std::vector<TcpWrite> tcpWrites;
+size_t tcpOutputs = 0;
+size_t tcpWritesLeft = SIZE_MAX;
+size_t tcpPcbsLive = 0;
+bool ackOnOutput = false;
+
+// written but not acknowledged yet, one connection at a time
+static u16_t tcpUnacked = 0;
+
+// room left in front of the payload for the protocol headers
+static constexpr u16_t headroom = 64;
+static constexpr u16_t udpHeaderLen = 8;
+
+void release()
+{
+    for (const Sent& s : sent)
+        if (s.pb)
+            pbuf_free(const_cast<pbuf*>(s.pb));
+    sent.clear();
+}
+
+void reset()
+{
+    release();
+    holdSent = false;
+    pbufAllocs = 0;
+    pbufAllocsLeft = SIZE_MAX;
+    tcpWrites.clear();
+    tcpOutputs = 0;
+    tcpWritesLeft = SIZE_MAX;
+    ackOnOutput = false;
+    tcpUnacked = 0;
+}
+
+void receive(udp_pcb* pcb, const std::string& data, uint16_t srcport)
+{
+    pbuf* pb = pbuf_alloc(PBUF_TRANSPORT, data.size(), PBUF_RAM);
+    memcpy(pb->payload, data.data(), data.size());
+    ip_addr_t src = IPADDR4_INIT_BYTES(192, 168, 0, 2);
+    pcb->recv(pcb->recv_arg, pcb, pb, &src, srcport);
+}
+
+tcp_pcb* tcpConnection(u16_t sndbuf)
+{
+    tcp_pcb* pcb = (tcp_pcb*)calloc(1, sizeof(tcp_pcb));
+    pcb->state = ESTABLISHED;
+    pcb->snd_buf = sndbuf;
+    ++tcpPcbsLive;
+    return pcb;
+}
+
+} // namespace lwip_fake
+
+using namespace lwip_fake;
+
+bool getDefaultPrivateGlobalSyncValue()
+{
+    return false;
+}
+
+extern "C"
+{
+
+struct ip_globals ip_data;
+const ip_addr_t ip_addr_any = IPADDR4_INIT(IPADDR_ANY);
+
+pbuf* pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type)
+{
+    (void)layer;
+    (void)type;
+    ++pbufAllocs;
+    if (!pbufAllocsLeft)
+        return nullptr;
+    --pbufAllocsLeft;
+
+    pbuf* p = (pbuf*)calloc(1, sizeof(pbuf) + headroom + length);
+    p->payload = (char*)(p + 1) + headroom;
+    p->tot_len = p->len = length;
+    p->ref = 1;
+    ++pbufsLive;
+    return p;
+}
+
+void pbuf_ref(pbuf* p)
+{
+    ++p->ref;
+}
+
+u8_t pbuf_free(pbuf* p)
+{
+    u8_t count = 0;
+    while (p && --p->ref == 0)
+    {
+        pbuf* next = p->next;
+        free(p);
+        --pbufsLive;
+        ++count;
+        p = next;
+    }
+    return count;
+}
+
+void pbuf_cat(pbuf* head, pbuf* tail)
+{
+    pbuf* p = head;
+    for (; p->next; p = p->next)
+        p->tot_len += tail->tot_len;
+    p->tot_len += tail->tot_len;
+    p->next = tail;
+}
+
+u8_t pbuf_get_at(const pbuf* p, u16_t offset)
+{
+    for (; p && offset >= p->len; p = p->next)
+        offset -= p->len;
+    return p? ((const u8_t*)p->payload)[offset]: 0;
+}
+
+void* pbuf_get_contiguous(const pbuf* p, void* buffer, size_t bufsize, u16_t len, u16_t offset)
+{
+    for (; p && offset >= p->len; p = p->next)
+        offset -= p->len;
+    if (!p || bufsize < len)
+        return nullptr;
+    if (offset + len <= p->len)
+        return (u8_t*)p->payload + offset;
+    u8_t* dst = (u8_t*)buffer;
+    for (u16_t copied = 0; p && copied < len; p = p->next, offset = 0)
+    {
+        u16_t n = std::min<u16_t>(p->len - offset, len - copied);
+        memcpy(dst + copied, (const u8_t*)p->payload + offset, n);
+        copied += n;
+    }
+    return buffer;
+}
+
+udp_pcb* udp_new(void)
+{
+    return (udp_pcb*)calloc(1, sizeof(udp_pcb));
+}
+
+void udp_remove(udp_pcb* pcb)
+{
+    free(pcb);
+}
+
+err_t udp_bind(udp_pcb* pcb, const ip_addr_t* ipaddr, u16_t port)
+{
+    (void)ipaddr;
+    pcb->local_port = port;
+    return ERR_OK;
+}
+
+void udp_disconnect(udp_pcb* pcb)
+{
+    (void)pcb;
+}
+
+void udp_recv(udp_pcb* pcb, udp_recv_fn recv, void* recv_arg)
+{
+    pcb->recv = recv;
+    pcb->recv_arg = recv_arg;
+}
+
+err_t udp_sendto(udp_pcb* pcb, pbuf* p, const ip_addr_t* dst_ip, u16_t dst_port)
+{
+    (void)pcb;
+    (void)dst_ip;
+    std::string data;
+    for (const pbuf* q = p; q; q = q->next)
+        data.append((const char*)q->payload, q->len);
+    // as lwIP, the header is added in place and left there
+    p->payload = (char*)p->payload - udpHeaderLen;
+    p->len += udpHeaderLen;
+    p->tot_len += udpHeaderLen;
+    if (holdSent)
+        pbuf_ref(p);
+    sent.push_back({ data, holdSent? p: nullptr, dst_port });
+    return ERR_OK;
+}
+
+void tcp_setprio(tcp_pcb* pcb, u8_t prio)
+{
+    pcb->prio = prio;
+}
+
+void tcp_arg(tcp_pcb* pcb, void* arg)
+{
+    pcb->callback_arg = arg;
+}
+
+void tcp_recv(tcp_pcb* pcb, tcp_recv_fn recv)
+{
+    pcb->recv = recv;
+}
+
+void tcp_sent(tcp_pcb* pcb, tcp_sent_fn sent)
+{
+    pcb->sent = sent;
+}
+
+void tcp_err(tcp_pcb* pcb, tcp_err_fn err)
+{
+    pcb->errf = err;
+}
+
+void tcp_poll(tcp_pcb* pcb, tcp_poll_fn poll, u8_t interval)
+{
+    pcb->poll = poll;
+    pcb->pollinterval = interval;
+}
+
+void tcp_recved(tcp_pcb* pcb, u16_t len)
+{
+    (void)pcb;
+    (void)len;
+}
+
+err_t tcp_write(tcp_pcb* pcb, const void* dataptr, u16_t len, u8_t apiflags)
+{
+    // as lwIP, nothing is queued when it doesn't fit
+    if (!tcpWritesLeft || len > pcb->snd_buf)
+        return ERR_MEM;
+    --tcpWritesLeft;
+    tcpWrites.push_back({ std::string((const char*)dataptr, len), apiflags });
+    pcb->snd_buf -= len;
+    tcpUnacked += len;
+    return ERR_OK;
+}
+
+err_t tcp_output(tcp_pcb* pcb)
+{
+    ++tcpOutputs;
+    if (ackOnOutput && tcpUnacked)
+    {
+        u16_t len = tcpUnacked;
+        tcpUnacked = 0;
+        pcb->snd_buf += len;
+        if (pcb->sent)
+            pcb->sent(pcb->callback_arg, pcb, len);
+    }
+    return ERR_OK;
+}
+
+err_t tcp_close(tcp_pcb* pcb)
+{
+    free(pcb);
+    --tcpPcbsLive;
+    return ERR_OK;
+}
+
+void tcp_abort(tcp_pcb* pcb)
+{
+    free(pcb);
+    --tcpPcbsLive;
+}
+
+} // extern "C"
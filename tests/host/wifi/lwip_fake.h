@@ -0,0 +1,106 @@
+/*
+ lwip_fake.h - minimal in-memory lwIP, to test the real UdpContext and ClientContext
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+#ifndef __LWIP_FAKE_H
+#define __LWIP_FAKE_H
+
+#include <Arduino.h>
+#include <IPAddress.h>
+#include <new>
+#include <string>
+#include <vector>
+
+extern "C"
+{
+#include <lwip/ip.h>
+#include <lwip/pbuf.h>
+#include <lwip/tcp.h>
+#include <lwip/udp.h>
+}
+
+#include <AddrList.h>
+#include <PolledTimeout.h>
+#include <WiFiClient.h>
+#include <assert.h>
+#include <esp_priv.h>
+#include <functional>
+
+bool getDefaultPrivateGlobalSyncValue();
+
+namespace lwip_fake
+{
+
+// The real ESP8266WiFi library headers, not the socket based ones from
+// tests/host/common/include.  Code linked in the same binary (LEAmDNS)
+// uses those, the namespace keeps both classes apart.
+#include "../../../libraries/ESP8266WiFi/src/include/UdpContext.h"
+
+// ClientContext only needs WiFiClient::iov, its forward declaration
+// of WiFiClient must not hide the real one
+class WiFiClient
+{
+public:
+    using iov = ::WiFiClient::iov;
+};
+#include "../../../libraries/ESP8266WiFi/src/include/ClientContext.h"
+
+// A datagram given to udp_sendto()
+struct Sent
+{
+    std::string data;
+    const pbuf* pb;
+    uint16_t port;
+};
+
+extern std::vector<Sent> sent;
+
+// When set, sent pbufs are referenced until release(), as the driver
+// does while they wait in its transmit queue.
+extern bool holdSent;
+
+extern size_t pbufAllocs; // pbuf_alloc() calls
+extern size_t pbufsLive;  // pbufs not freed yet
+extern size_t pbufAllocsLeft; // pbuf_alloc() fails once this reaches 0
+
+// Forget sent datagrams, unreference the held ones
+void release();
+// Start a new test: release(), reset counters and failures
+void reset();
+
+// Hands a datagram from srcport to the pcb receive callback
+void receive(udp_pcb* pcb, const std::string& data, uint16_t srcport);
+
+// A tcp_write() call
+struct TcpWrite
+{
+    std::string data;
+    u8_t flags;
+};
+
+extern std::vector<TcpWrite> tcpWrites;
+
+extern size_t tcpOutputs;    // tcp_output() calls
+extern size_t tcpWritesLeft; // tcp_write() fails with ERR_MEM once this reaches 0
+extern size_t tcpPcbsLive;   // pcbs not closed or aborted yet
+
+// When set, tcp_output() has the peer acknowledge all written data,
+// the sent callback is called from there.
+extern bool ackOnOutput;
+
+// New established connection, with sndbuf bytes of send buffer
+tcp_pcb* tcpConnection(u16_t sndbuf = TCP_SND_BUF);
+
+} // namespace lwip_fake
+
+#endif // __LWIP_FAKE_H
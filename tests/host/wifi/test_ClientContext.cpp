@@ -0,0 +1,158 @@
+/*
+ test_ClientContext.cpp - ClientContext write path tests
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+#include <catch.hpp>
+#include "lwip_fake.h"
+
+// ClientContext is lwip_fake's, the real one
+namespace lwip_fake
+{
+
+static ClientContext* newContext(u16_t sndbuf = TCP_SND_BUF, int timeout_ms = 5000)
+{
+    ClientContext* ctx = new ClientContext(tcpConnection(sndbuf), nullptr, nullptr);
+    ctx->ref();
+    ctx->setTimeout(timeout_ms);
+    return ctx;
+}
+
+static std::string allWritten()
+{
+    std::string data;
+    for (const TcpWrite& w : tcpWrites)
+        data += w.data;
+    return data;
+}
+
+TEST_CASE("TCP gather write queues all elements before output", "[ClientContext]")
+{
+    reset();
+    ClientContext* ctx = newContext();
+    const std::string header = "HTTP/1.1 200 OK\r\n\r\n", body = "hello";
+    const WiFiClient::iov v[] = { { header.data(), header.size() }, { "", 0 }, { body.data(), body.size() } };
+
+    CHECK(ctx->write(v, 3, false) == header.size() + body.size());
+    REQUIRE(tcpWrites.size() == 2); // empty element skipped
+    CHECK(tcpWrites[0].data == header);
+    CHECK(tcpWrites[0].flags == (TCP_WRITE_FLAG_MORE | TCP_WRITE_FLAG_COPY));
+    CHECK(tcpWrites[1].data == body);
+    CHECK(tcpWrites[1].flags == TCP_WRITE_FLAG_COPY); // last one is pushed
+    CHECK(tcpOutputs == 1);
+
+    ctx->unref();
+    CHECK(tcpPcbsLive == 0);
+}
+
+TEST_CASE("TCP writes larger than the send buffer go out in parts", "[ClientContext]")
+{
+    reset();
+    ClientContext* ctx = newContext(10, 50);
+    ackOnOutput = true;
+    const std::string a = "0123456789abcdef", b = "ghijklmno";
+    const WiFiClient::iov v[] = { { a.data(), a.size() }, { b.data(), b.size() } };
+
+    CHECK(ctx->write(v, 2, false) == a.size() + b.size());
+    CHECK(allWritten() == a + b);
+    REQUIRE(tcpWrites.size() == 4);
+    CHECK(tcpWrites[0].data.size() == 10);
+    CHECK(tcpWrites[1].data.size() == 6);  // end of a, the buffer isn't full
+    CHECK(tcpWrites[2].data.size() == 4);  // rest of the buffer
+    CHECK(tcpWrites[3].data.size() == 5);
+    for (size_t i = 0; i < 3; i++)
+        CHECK((tcpWrites[i].flags & TCP_WRITE_FLAG_MORE) != 0);
+    CHECK((tcpWrites[3].flags & TCP_WRITE_FLAG_MORE) == 0);
+    CHECK(tcpOutputs == 3);
+
+    // single buffer, same way
+    tcpWrites.clear();
+    const std::string c(35, 'c');
+    CHECK(ctx->write(c.data(), c.size()) == c.size());
+    CHECK(allWritten() == c);
+    CHECK(tcpWrites.size() == 4);
+
+    ctx->unref();
+    CHECK(tcpPcbsLive == 0);
+}
+
+TEST_CASE("TCP writes are short when the send buffer isn't freed in time", "[ClientContext]")
+{
+    reset();
+    ClientContext* ctx = newContext(10, 20); // never acknowledged
+    const std::string data(25, 'x');
+
+    uint32_t start = millis();
+    CHECK(ctx->write(data.data(), data.size()) == 10);
+    uint32_t elapsed = millis() - start;
+    CHECK(elapsed >= 20);
+    CHECK(allWritten() == data.substr(0, 10));
+    CHECK(ctx->availableForWrite() == 0);
+
+    // nothing fits: nothing is written
+    tcpWrites.clear();
+    CHECK(ctx->write(data.data(), data.size()) == 0);
+    CHECK(tcpWrites.empty());
+
+    ctx->unref();
+    CHECK(tcpPcbsLive == 0);
+}
+
+TEST_CASE("TCP writes are short when lwIP is out of memory", "[ClientContext]")
+{
+    reset();
+    ClientContext* ctx = newContext(TCP_SND_BUF, 20);
+    const std::string a = "first", b = "second", c = "third";
+    const WiFiClient::iov v[] = { { a.data(), a.size() }, { b.data(), b.size() }, { c.data(), c.size() } };
+
+    // ERR_MEM after the first element: what was queued is sent and counted
+    tcpWritesLeft = 1;
+    CHECK(ctx->write(v, 3, false) == a.size());
+    CHECK(allWritten() == a);
+    CHECK(tcpOutputs == 1);
+
+    // ERR_MEM right away
+    tcpWrites.clear();
+    tcpOutputs = 0;
+    tcpWritesLeft = 0;
+    CHECK(ctx->write(v, 3, false) == 0);
+    CHECK(tcpWrites.empty());
+    CHECK(tcpOutputs == 0);
+
+    // memory is back: the connection is still usable
+    tcpWritesLeft = SIZE_MAX;
+    CHECK(ctx->write(v, 3, false) == a.size() + b.size() + c.size());
+    CHECK(allWritten() == a + b + c);
+
+    ctx->unref();
+    CHECK(tcpPcbsLive == 0);
+}
+
+TEST_CASE("TCP borrowed buffers are not copied and are acknowledged on return", "[ClientContext]")
+{
+    reset();
+    ClientContext* ctx = newContext();
+    ackOnOutput = true;
+    const std::string a = "borrowed", b = "buffers";
+    const WiFiClient::iov v[] = { { a.data(), a.size() }, { b.data(), b.size() } };
+
+    CHECK(ctx->write(v, 2, true) == a.size() + b.size());
+    REQUIRE(tcpWrites.size() == 2);
+    CHECK((tcpWrites[0].flags & TCP_WRITE_FLAG_COPY) == 0);
+    CHECK((tcpWrites[1].flags & TCP_WRITE_FLAG_COPY) == 0);
+    CHECK(ctx->availableForWrite() == TCP_SND_BUF);
+
+    ctx->unref();
+    CHECK(tcpPcbsLive == 0);
+}
+
+} // namespace lwip_fake
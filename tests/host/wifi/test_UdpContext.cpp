@@ -0,0 +1,217 @@
+/*
+ test_UdpContext.cpp - UdpContext receive queue and transmit pool tests
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ */
+
+#include <catch.hpp>
+#include "lwip_fake.h"
+
+// UdpContext is lwip_fake's, the real one
+namespace lwip_fake
+{
+
+static UdpContext* newContext()
+{
+    UdpContext* ctx = new UdpContext;
+    ctx->ref();
+    return ctx;
+}
+
+static std::string next(UdpContext* ctx)
+{
+    if (!ctx->next())
+        return "(none)";
+    std::string data(ctx->getSize(), 0);
+    ctx->read(&data[0], data.size());
+    return data;
+}
+
+static bool sendDatagram(UdpContext* ctx, const std::string& data)
+{
+    ip_addr_t addr = IPADDR4_INIT_BYTES(192, 168, 0, 2);
+    return ctx->sendDatagram(data.data(), data.size(), &addr, 1234);
+}
+
+static bool sendPacket(UdpContext* ctx, const std::string& data)
+{
+    ip_addr_t addr = IPADDR4_INIT_BYTES(192, 168, 0, 2);
+    return ctx->append(data.data(), data.size()) == data.size()
+        && ctx->send(&addr, 1234);
+}
+
+TEST_CASE("UDP receive queue drops the newest datagrams when full", "[UdpContext]")
+{
+    reset();
+    UdpContext* ctx = newContext();
+    REQUIRE(ctx->setRxQueue(3));
+    REQUIRE(ctx->listen(IPAddress(), 1234));
+
+    for (uint16_t i = 1; i <= 5; i++)
+        receive(ctx->pcb(), std::to_string(i), 1000 + i);
+    CHECK(ctx->getRxDropped() == 2);
+    CHECK(pbufsLive == 3);
+
+    for (uint16_t i = 1; i <= 3; i++)
+    {
+        CHECK(next(ctx) == std::to_string(i));
+        CHECK(ctx->getRemotePort() == 1000 + i);
+    }
+    CHECK(next(ctx) == "(none)");
+
+    // room is made again by reading
+    receive(ctx->pcb(), "6", 1006);
+    CHECK(next(ctx) == "6");
+    CHECK(ctx->getRxDropped() == 2);
+
+    ctx->unref();
+    CHECK(pbufsLive == 0);
+}
+
+TEST_CASE("UDP receive queue can drop the oldest datagrams instead", "[UdpContext]")
+{
+    reset();
+    UdpContext* ctx = newContext();
+    REQUIRE(ctx->setRxQueue(3, UdpContext::RxPolicy::DropOldest));
+    REQUIRE(ctx->listen(IPAddress(), 1234));
+
+    for (uint16_t i = 1; i <= 5; i++)
+        receive(ctx->pcb(), std::to_string(i), 1000 + i);
+    CHECK(ctx->getRxDropped() == 2);
+    CHECK(pbufsLive == 3);
+
+    for (uint16_t i = 3; i <= 5; i++)
+    {
+        CHECK(next(ctx) == std::to_string(i));
+        CHECK(ctx->getRemotePort() == 1000 + i);
+    }
+    CHECK(next(ctx) == "(none)");
+
+    ctx->unref();
+    CHECK(pbufsLive == 0);
+}
+
+TEST_CASE("UDP receive queue resizing keeps the oldest datagrams", "[UdpContext]")
+{
+    reset();
+    UdpContext* ctx = newContext();
+    REQUIRE(ctx->listen(IPAddress(), 1234)); // default depth
+
+    for (uint16_t i = 1; i <= 4; i++)
+        receive(ctx->pcb(), std::to_string(i), 1000 + i);
+    CHECK(ctx->getRxDropped() == 0);
+
+    CHECK_FALSE(ctx->setRxQueue(0));
+    REQUIRE(ctx->setRxQueue(2));
+    CHECK(ctx->getRxDropped() == 2);
+    CHECK(pbufsLive == 2);
+    CHECK(next(ctx) == "1");
+    CHECK(next(ctx) == "2");
+    CHECK(next(ctx) == "(none)");
+
+    ctx->unref();
+    CHECK(pbufsLive == 0);
+}
+
+TEST_CASE("UDP transmit pool buffers are reused once released by lwIP", "[UdpContext]")
+{
+    reset();
+    UdpContext* ctx = newContext();
+    REQUIRE(ctx->setTxPool(2, 100));
+    CHECK(pbufAllocs == 2);
+
+    // not held: the same buffers are used again and again,
+    // headers added by the previous send are undone
+    for (int i = 0; i < 5; i++)
+        CHECK(sendDatagram(ctx, "datagram " + std::to_string(i)));
+    CHECK(sendPacket(ctx, "packet"));
+    CHECK(pbufAllocs == 2);
+    REQUIRE(sent.size() == 6);
+    CHECK(sent[4].data == "datagram 4");
+    CHECK(sent[5].data == "packet");
+    CHECK(sent[5].port == 1234);
+
+    // held by the driver: not reused until released
+    release();
+    holdSent = true;
+    CHECK(sendDatagram(ctx, "a"));
+    CHECK(sendPacket(ctx, "b"));
+    CHECK(pbufAllocs == 2);
+    REQUIRE(sent.size() == 2);
+    CHECK(sent[0].pb != sent[1].pb);
+    CHECK(pbufsLive == 2);
+
+    release();
+    CHECK(sendDatagram(ctx, "c"));
+    CHECK(pbufAllocs == 2);
+    CHECK(sent[0].data == "c");
+
+    ctx->unref();
+    release();
+    CHECK(pbufsLive == 0);
+}
+
+TEST_CASE("UDP transmit pool falls back to allocation when exhausted", "[UdpContext]")
+{
+    reset();
+    UdpContext* ctx = newContext();
+    REQUIRE(ctx->setTxPool(2, 100));
+    holdSent = true;
+
+    CHECK(sendDatagram(ctx, "1"));
+    CHECK(sendDatagram(ctx, "2"));
+    CHECK(pbufAllocs == 2);
+
+    // pool is exhausted
+    CHECK(sendDatagram(ctx, "3"));
+    CHECK(pbufAllocs == 3);
+    CHECK(sendPacket(ctx, "4"));
+    CHECK(pbufAllocs > 3);
+
+    // too large for the pool, in one go or appended
+    release();
+    size_t allocs = pbufAllocs;
+    CHECK(sendDatagram(ctx, std::string(101, 'x')));
+    CHECK(pbufAllocs > allocs);
+    allocs = pbufAllocs;
+    CHECK(ctx->append(std::string(60, 'y').c_str(), 60) == 60);
+    CHECK(pbufAllocs == allocs);
+    CHECK(sendPacket(ctx, std::string(60, 'z')));
+    CHECK(pbufAllocs > allocs);
+    REQUIRE(sent.size() == 2);
+    CHECK(sent[0].data == std::string(101, 'x'));
+    CHECK(sent[1].data == std::string(60, 'y') + std::string(60, 'z'));
+
+    release();
+    ctx->unref();
+    CHECK(pbufsLive == 0);
+}
+
+TEST_CASE("UDP transmit pool is not left half allocated", "[UdpContext]")
+{
+    reset();
+    UdpContext* ctx = newContext();
+    pbufAllocsLeft = 1;
+    CHECK_FALSE(ctx->setTxPool(2, 100));
+    CHECK(pbufsLive == 0);
+
+    // still usable without pool
+    pbufAllocsLeft = SIZE_MAX;
+    CHECK(sendDatagram(ctx, "1"));
+    CHECK(sendPacket(ctx, "2"));
+    REQUIRE(sent.size() == 2);
+    CHECK(sent[1].data == "2");
+
+    ctx->unref();
+    CHECK(pbufsLive == 0);
+}
+
+} // namespace lwip_fake
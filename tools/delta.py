@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Makes a delta patch, applied by the Updater against the running sketch:
+# only the parts of the new sketch which can't be found in the running one
+# are sent.  The format is described in cores/esp8266/Updater.cpp.
+#
+import argparse
+import hashlib
+import struct
+import sys
+
+MAGIC = b'\xd7DLT'
+VERSION = 1
+
+# the first bytes of the image (flash mode and size) are never copied
+FIRST_COPIED = 4
+# size of the blocks indexed in the running sketch
+BLOCK = 8
+# copies shorter than this are inserted, unless they continue the last copy
+MIN_COPY = 12
+# candidates kept per block
+MAX_CANDIDATES = 16
+
+CMD_END = 0x00
+CMD_COPY = 0x01
+CMD_INSERT = 0x02
+
+def parse_args():
+    parser = argparse.ArgumentParser(description='Delta OTA patch generator')
+    parser.add_argument('-s', '--source', required=True, help='Running sketch (.bin, unsigned)')
+    parser.add_argument('-t', '--target', required=True, help='New sketch (.bin, signed or not)')
+    parser.add_argument('-o', '--out', required=True, help='Output patch file')
+    return parser.parse_args()
+
+def varint(value):
+    out = bytearray()
+    while True:
+        byte = value & 0x7f
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return out
+
+def zigzag(value):
+    return (value << 1) if value >= 0 else ((-value << 1) - 1)
+
+def index_source(source):
+    """Maps each block of the source to the positions where it is found."""
+    index = {}
+    for pos in range(FIRST_COPIED, len(source) - BLOCK + 1):
+        positions = index.setdefault(source[pos:pos + BLOCK], [])
+        if len(positions) < MAX_CANDIDATES:
+            positions.append(pos)
+    return index
+
+def match_length(source, src, target, tgt):
+    length = 0
+    limit = min(len(source) - src, len(target) - tgt)
+    while length < limit and source[src + length] == target[tgt + length]:
+        length += 1
+    return length
+
+def make_patch(source, target):
+    index = index_source(source)
+    commands = bytearray()
+    pending = bytearray() # inserted bytes not yet written
+    last_copy = 0         # end of the last copy in the source
+
+    def flush_insert():
+        if pending:
+            commands.append(CMD_INSERT)
+            commands.extend(varint(len(pending)))
+            commands.extend(pending)
+            pending.clear()
+
+    tgt = 0
+    while tgt < len(target):
+        best_src, best_len = 0, 0
+        if tgt >= FIRST_COPIED:
+            # the running sketch often continues where the last copy ended,
+            # after a few changed bytes (like an address)
+            expected = last_copy + len(pending)
+            if FIRST_COPIED <= expected < len(source):
+                best_src = expected
+                best_len = match_length(source, expected, target, tgt)
+            if best_len < BLOCK:
+                for src in index.get(bytes(target[tgt:tgt + BLOCK]), ()):
+                    length = match_length(source, src, target, tgt)
+                    if length > best_len:
+                        best_src, best_len = src, length
+
+        continues = best_src == last_copy + len(pending) and best_len >= BLOCK // 2
+        if best_len >= MIN_COPY or continues:
+            flush_insert()
+            commands.append(CMD_COPY)
+            commands.extend(varint(zigzag(best_src - last_copy)))
+            commands.extend(varint(best_len))
+            last_copy = best_src + best_len
+            tgt += best_len
+        else:
+            pending.append(target[tgt])
+            tgt += 1
+
+    flush_insert()
+    commands.append(CMD_END)
+
+    header = MAGIC + bytes([VERSION, 0, 0, 0])
+    header += struct.pack('<II', len(source), len(target))
+    header += hashlib.md5(source[FIRST_COPIED:]).digest()
+    return header + commands
+
+def apply_patch(source, patch):
+    """Rebuilds the target, as the Updater does (used to check the patch)."""
+    target = bytearray()
+    pos = 32
+    last_copy = 0
+
+    def number():
+        nonlocal pos
+        value, shift = 0, 0
+        while True:
+            byte = patch[pos]
+            pos += 1
+            value |= (byte & 0x7f) << shift
+            shift += 7
+            if not byte & 0x80:
+                return value
+
+    while True:
+        command = patch[pos]
+        pos += 1
+        if command == CMD_END:
+            return target
+        if command == CMD_COPY:
+            offset = number()
+            last_copy += (offset >> 1) ^ -(offset & 1)
+            length = number()
+            target += source[last_copy:last_copy + length]
+            last_copy += length
+        else:
+            length = number()
+            target += patch[pos:pos + length]
+            pos += length
+
+def main():
+    args = parse_args()
+    with open(args.source, 'rb') as f:
+        source = f.read()
+    with open(args.target, 'rb') as f:
+        target = f.read()
+
+    if len(source) <= FIRST_COPIED or len(target) <= FIRST_COPIED:
+        sys.stderr.write("Source or target too small\n")
+        return 1
+    if target[0] != 0xe9:
+        sys.stderr.write("Target is not a sketch image (compressed images can't be patched)\n")
+        return 1
+
+    patch = make_patch(source, target)
+    if apply_patch(source, patch) != target:
+        sys.stderr.write("Internal error: the patch doesn't rebuild the target\n")
+        return 1
+
+    with open(args.out, 'wb') as f:
+        f.write(patch)
+    sys.stderr.write("Delta patch: {} ({} bytes, {:.1f}% of the target)\n".format(
+        args.out, len(patch), 100.0 * len(patch) / len(target)))
+    sys.stderr.write("Send the MD5 of the target as x-MD5: {}\n".format(hashlib.md5(target).hexdigest()))
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())